@@ -0,0 +1,235 @@
+/**
+ * @file actuator.c
+ * @brief 舵机执行器任务实现
+ * 
+ * 命令通过固定长度的FreeRTOS队列传递给执行器任务，
+ * 由执行器任务串行完成舵机动作。每次动作（转到目标角度、保持、复位）编译为一个舵机脚本，
+ * 在MCPWM的TEZ中断中按20ms周期执行，保持时间不受系统节拍和任务调度影响；
+ * 执行器任务只等待脚本结束的任务通知
+ */
+
+#include "actuator.h"
+#include "event_stream.h"
+#include "sg90_script.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+
+static const char *TAG = "ACTUATOR";
+
+#define ACTUATOR_TASK_STACK_SIZE  3072
+#define ACTUATOR_TASK_PRIORITY    5
+#define ACTUATOR_REPEAT_GAP_MS    200     // 重复动作之间在0°停留的时间，让料斗落料
+#define ACTUATOR_MOVE_MIN_MS      200     // 单次转动的最短时间
+#define ACTUATOR_MOVE_MS_PER_DEG  4       // 每度的转动时间，180°用时720ms
+#define ACTUATOR_MOVE_PROFILE     SG90_PROFILE_SCURVE
+#define ACTUATOR_WAIT_MARGIN_PERIODS 5    // 等待动作结束的余量：断开后恢复输出、END指令各占周期
+#define ACTUATOR_WAIT_MARGIN_MS   100     // 另加的固定余量：Flash操作期间MCPWM中断被推迟（未启用ISR_CACHE_SAFE）
+
+// 执行器状态
+typedef struct {
+    const sg90_config_t *servo; // 舵机配置
+    QueueHandle_t queue;        // 命令队列
+    volatile bool busy;         // 是否正在执行命令
+    volatile uint32_t stop_generation; // 每次取消加1，正在执行的重复动作发现变化后提前结束
+    uint8_t angle;              // 舵机当前角度，用于计算转动时间
+    sg90_script_t script;       // 当前动作的脚本（执行期间由TEZ中断读取）
+} actuator_state_t;
+
+static actuator_state_t actuator_state = {
+    .servo = NULL,
+    .queue = NULL,
+    .busy = false,
+    .angle = 0,
+};
+
+/**
+ * @brief 转动时间对应的周期数：每度 ACTUATOR_MOVE_MS_PER_DEG，至少 ACTUATOR_MOVE_MIN_MS
+ */
+static uint16_t actuator_move_periods(uint8_t from, uint8_t to)
+{
+    uint32_t distance = to > from ? to - from : from - to;
+    uint32_t duration_ms = distance * ACTUATOR_MOVE_MS_PER_DEG;
+    if (duration_ms < ACTUATOR_MOVE_MIN_MS) {
+        duration_ms = ACTUATOR_MOVE_MIN_MS;
+    }
+    return SG90_MS_TO_PERIODS(duration_ms);
+}
+
+/**
+ * @brief 执行一次动作并等待结束：平滑转到目标角度，reset_delay_ms 不为0时保持后转回0°
+ * @return ESP_OK 完成；ESP_ERR_INVALID_STATE 被打断；ESP_ERR_TIMEOUT 没有收到结束通知
+ */
+static esp_err_t actuator_run_once(uint8_t angle, uint32_t reset_delay_ms)
+{
+    uint32_t hold_periods = SG90_MS_TO_PERIODS(reset_delay_ms);
+    if (hold_periods > UINT16_MAX) {
+        hold_periods = UINT16_MAX;
+    }
+    
+    const sg90_script_step_t steps[] = {
+        SG90_SCRIPT_RAMP(angle * 10, actuator_move_periods(actuator_state.angle, angle), ACTUATOR_MOVE_PROFILE),
+        SG90_SCRIPT_HOLD(hold_periods),
+        SG90_SCRIPT_RAMP(0, actuator_move_periods(angle, 0), ACTUATOR_MOVE_PROFILE),
+    };
+    esp_err_t ret = sg90_script_compile(steps, reset_delay_ms > 0 ? 3 : 1, &actuator_state.script);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    xTaskNotifyStateClear(NULL);
+    ret = sg90_script_run(actuator_state.servo, &actuator_state.script, xTaskGetCurrentTaskHandle());
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    // 脚本在TEZ中断中执行；超时只用于发现中断不再运行的故障，余量宁大勿小，
+    // 否则会在动作正常进行时误判超时并调用 sg90_stop 截断动作
+    uint32_t wait_ms = (actuator_state.script.total_periods + ACTUATOR_WAIT_MARGIN_PERIODS) * SG90_PERIOD_MS +
+                       ACTUATOR_WAIT_MARGIN_MS;
+    uint32_t result = 0;
+    if (xTaskNotifyWait(0, UINT32_MAX, &result, pdMS_TO_TICKS(wait_ms) + 1) != pdTRUE) {
+        // 停止脚本，下一次编译时中断不会再读取它
+        sg90_stop(actuator_state.servo);
+        return ESP_ERR_TIMEOUT;
+    }
+    if (result != SG90_MOTION_DONE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    actuator_state.angle = reset_delay_ms > 0 ? 0 : angle;
+    return ESP_OK;
+}
+
+/**
+ * @brief 执行器任务
+ * 从队列中依次取出命令并完成舵机动作
+ */
+static void actuator_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "执行器任务启动，队列长度: %d", ACTUATOR_QUEUE_LENGTH);
+    
+    actuator_cmd_t cmd;
+    while (1) {
+        if (xQueueReceive(actuator_state.queue, &cmd, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        
+        actuator_state.busy = true;
+        uint32_t generation = actuator_state.stop_generation;
+        ESP_LOGI(TAG, "执行命令: 角度 %d°，%ums后复位，重复 %d 次",
+                 cmd.angle, (unsigned)cmd.reset_delay_ms, cmd.repeat > 0 ? cmd.repeat : 1);
+        
+        event_stream_publish(EVENT_MOTION_STARTED, cmd.angle, 0);
+        
+        esp_err_t ret = ESP_OK;
+        int count = cmd.repeat > 0 ? cmd.repeat : 1;
+        for (int i = 0; i < count && ret == ESP_OK; i++) {
+            if (i > 0) {
+                vTaskDelay(pdMS_TO_TICKS(ACTUATOR_REPEAT_GAP_MS));
+                if (generation != actuator_state.stop_generation) {
+                    ESP_LOGW(TAG, "动作被停止，剩余 %d 次未执行", count - i);
+                    ret = ESP_ERR_INVALID_STATE;
+                    break;
+                }
+            }
+            ret = actuator_run_once(cmd.angle, cmd.reset_delay_ms);
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "舵机动作失败: %s", esp_err_to_name(ret));
+            event_stream_publish(EVENT_ERROR, ret, 0);
+        }
+        
+        actuator_state.busy = false;
+        event_stream_publish(EVENT_MOTION_FINISHED, cmd.angle, ret);
+        
+        if (cmd.on_done) {
+            cmd.on_done(&cmd, ret);
+        }
+    }
+}
+
+esp_err_t actuator_init(const sg90_config_t *servo)
+{
+    if (servo == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (actuator_state.queue != NULL) {
+        ESP_LOGW(TAG, "执行器已经初始化");
+        return ESP_OK;
+    }
+    
+    actuator_state.servo = servo;
+    actuator_state.queue = xQueueCreate(ACTUATOR_QUEUE_LENGTH, sizeof(actuator_cmd_t));
+    if (actuator_state.queue == NULL) {
+        ESP_LOGE(TAG, "创建命令队列失败");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    BaseType_t ret = xTaskCreate(
+        actuator_task,              // 任务函数
+        "actuator",                 // 任务名称
+        ACTUATOR_TASK_STACK_SIZE,   // 堆栈大小
+        NULL,                       // 参数
+        ACTUATOR_TASK_PRIORITY,     // 优先级
+        NULL                        // 任务句柄
+    );
+    
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "创建执行器任务失败");
+        vQueueDelete(actuator_state.queue);
+        actuator_state.queue = NULL;
+        return ESP_FAIL;
+    }
+    
+    return ESP_OK;
+}
+
+actuator_submit_result_t actuator_submit(const actuator_cmd_t *cmd)
+{
+    if (actuator_state.queue == NULL || cmd == NULL) {
+        return ACTUATOR_SUBMIT_REJECTED_FULL;
+    }
+    
+    uint32_t pending = actuator_pending_count();
+    
+    // 不等待，队列满时立即拒绝
+    if (xQueueSend(actuator_state.queue, cmd, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "命令队列已满，拒绝命令: 角度 %d°", cmd->angle);
+        return ACTUATOR_SUBMIT_REJECTED_FULL;
+    }
+    
+    return pending == 0 ? ACTUATOR_SUBMIT_ACCEPTED : ACTUATOR_SUBMIT_QUEUED;
+}
+
+uint32_t actuator_cancel_pending(void)
+{
+    if (actuator_state.queue == NULL) {
+        return 0;
+    }
+    
+    actuator_state.stop_generation++;
+    
+    // 逐条取出而不是直接清空队列，保证每条被取消的命令都收到完成回调
+    uint32_t cancelled = 0;
+    actuator_cmd_t cmd;
+    while (xQueueReceive(actuator_state.queue, &cmd, 0) == pdTRUE) {
+        cancelled++;
+        if (cmd.on_done) {
+            cmd.on_done(&cmd, ESP_ERR_INVALID_STATE);
+        }
+    }
+    
+    ESP_LOGI(TAG, "取消了 %u 条排队命令", (unsigned)cancelled);
+    return cancelled;
+}
+
+uint32_t actuator_pending_count(void)
+{
+    if (actuator_state.queue == NULL) {
+        return 0;
+    }
+    
+    return uxQueueMessagesWaiting(actuator_state.queue) + (actuator_state.busy ? 1 : 0);
+}
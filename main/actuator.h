@@ -0,0 +1,100 @@
+/**
+ * @file actuator.h
+ * @brief 舵机执行器任务头文件
+ * 
+ * 网络任务只负责把命令放入有界队列，由独立的执行器任务完成机械动作，
+ * 避免舵机动作的延时阻塞网络收发
+ */
+
+#ifndef ACTUATOR_H
+#define ACTUATOR_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "sg90_servo.h"
+#include "command.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ACTUATOR_QUEUE_LENGTH  8   /**< 命令队列长度 */
+#define ACTUATOR_TAG_MAX_LEN   15  /**< 请求标签最大长度 */
+
+/**
+ * @brief 命令来源，执行完成后用于回复请求方
+ */
+typedef struct {
+    uint32_t conn_id;                   /**< 来源连接ID，0表示无需回复 */
+    uint8_t format;                     /**< 请求协议格式（tcp_reply_format_t） */
+    uint8_t opcode;                     /**< 二进制协议操作码 */
+    uint16_t seq;                       /**< 二进制协议请求序号 */
+    char tag[ACTUATOR_TAG_MAX_LEN + 1]; /**< 请求标签 */
+    char request_id[COMMAND_REQUEST_ID_MAX_LEN + 1]; /**< 请求ID，完成时记录到去重缓存；空字符串表示没有 */
+    uint32_t request_scope;             /**< 请求ID的作用域（见 request_cache.h） */
+} actuator_origin_t;
+
+typedef struct actuator_cmd actuator_cmd_t;
+
+/**
+ * @brief 命令执行完成回调，在执行器任务中调用
+ * @param cmd 已完成的命令
+ * @param result 执行结果
+ */
+typedef void (*actuator_done_cb_t)(const actuator_cmd_t *cmd, esp_err_t result);
+
+/**
+ * @brief 执行器命令
+ */
+struct actuator_cmd {
+    uint8_t angle;              /**< 目标角度 (0-180) */
+    uint32_t reset_delay_ms;    /**< 保持时间，之后自动复位到0°；0表示停留在目标角度 */
+    uint8_t repeat;             /**< 重复次数，0按1次处理 */
+    actuator_origin_t origin;   /**< 命令来源 */
+    actuator_done_cb_t on_done; /**< 完成回调，可为NULL */
+};
+
+/**
+ * @brief 命令提交结果
+ */
+typedef enum {
+    ACTUATOR_SUBMIT_ACCEPTED,       /**< 执行器空闲，命令立即执行 */
+    ACTUATOR_SUBMIT_QUEUED,         /**< 命令已排队，等待前面的命令完成 */
+    ACTUATOR_SUBMIT_REJECTED_FULL,  /**< 队列已满，命令被拒绝 */
+} actuator_submit_result_t;
+
+/**
+ * @brief 初始化执行器并启动执行器任务
+ * @param servo 已初始化的舵机配置
+ * @return ESP_OK 成功，其他值失败
+ */
+esp_err_t actuator_init(const sg90_config_t *servo);
+
+/**
+ * @brief 提交命令到执行器队列（不阻塞）
+ * @param cmd 命令
+ * @return 提交结果
+ */
+actuator_submit_result_t actuator_submit(const actuator_cmd_t *cmd);
+
+/**
+ * @brief 取消排队中的命令（可在任意任务中调用）
+ * 
+ * 被取消的命令在调用方的任务中收到结果为 ESP_ERR_INVALID_STATE 的完成回调；
+ * 正在执行的命令完成当前这一次动作后结束，剩余的重复次数不再执行
+ * 
+ * @return 取消的排队命令数
+ */
+uint32_t actuator_cancel_pending(void);
+
+/**
+ * @brief 获取当前等待及正在执行的命令数量
+ * @return 命令数量
+ */
+uint32_t actuator_pending_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ACTUATOR_H
@@ -0,0 +1,114 @@
+/**
+ * @file binary_protocol.c
+ * @brief 二进制命令帧协议实现
+ */
+
+#include "binary_protocol.h"
+#include "command_registry.h"
+
+// CRC-16/CCITT-FALSE 半字节查找表（多项式0x1021）
+static const uint16_t crc16_nibble_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+static inline uint16_t read_u16_le(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline void write_u16_le(uint8_t *p, uint16_t value)
+{
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+}
+
+uint16_t binary_protocol_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc << 4) ^ crc16_nibble_table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ crc16_nibble_table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    
+    return crc;
+}
+
+binary_parse_result_t binary_protocol_parse(const uint8_t *buf, size_t len,
+                                            command_t *cmd, binary_frame_info_t *info)
+{
+    if (len < 1) {
+        return BINARY_PARSE_NEED_MORE;
+    }
+    if (buf[0] != BINARY_PROTOCOL_SOF) {
+        return BINARY_PARSE_BAD_FRAME;
+    }
+    if (len < 2) {
+        return BINARY_PARSE_NEED_MORE;
+    }
+    
+    uint8_t payload_len = buf[1];
+    if (payload_len > BINARY_PROTOCOL_MAX_PAYLOAD) {
+        return BINARY_PARSE_BAD_FRAME;
+    }
+    
+    size_t frame_len = BINARY_PROTOCOL_HEADER_LEN + payload_len + BINARY_PROTOCOL_CRC_LEN;
+    if (len < frame_len) {
+        return BINARY_PARSE_NEED_MORE;
+    }
+    
+    const uint8_t *payload = buf + BINARY_PROTOCOL_HEADER_LEN;
+    info->opcode = buf[2];
+    info->seq = read_u16_le(buf + 3);
+    info->frame_len = frame_len;
+    
+    uint16_t crc = read_u16_le(payload + payload_len);
+    if (crc != binary_protocol_crc16(buf + 1, BINARY_PROTOCOL_HEADER_LEN - 1 + payload_len)) {
+        return BINARY_PARSE_BAD_CRC;
+    }
+    
+    cmd->request_id[0] = '\0';     // 二进制帧不携带请求ID
+    
+    // 操作码查表得到命令类型，负载按注册表中的参数格式解码
+    command_type_t type;
+    if (!command_registry_find_opcode(info->opcode, &type)) {
+        return BINARY_PARSE_BAD_REQUEST;
+    }
+    cmd->type = type;
+    if (!command_registry_decode_payload(payload, payload_len, cmd)) {
+        return BINARY_PARSE_BAD_REQUEST;
+    }
+    
+    return BINARY_PARSE_OK;
+}
+
+size_t binary_protocol_encode_reply(uint8_t *out, size_t out_size, uint8_t opcode, uint16_t seq,
+                                    command_result_t status, const uint8_t *data, size_t data_len)
+{
+    size_t payload_len = 1 + data_len;
+    size_t frame_len = BINARY_PROTOCOL_HEADER_LEN + payload_len + BINARY_PROTOCOL_CRC_LEN;
+    
+    if (payload_len > BINARY_PROTOCOL_MAX_PAYLOAD || frame_len > out_size) {
+        return 0;
+    }
+    
+    out[0] = BINARY_PROTOCOL_SOF;
+    out[1] = (uint8_t)payload_len;
+    out[2] = opcode | BINARY_PROTOCOL_REPLY_FLAG;
+    write_u16_le(out + 3, seq);
+    out[BINARY_PROTOCOL_HEADER_LEN] = (uint8_t)status;
+    for (size_t i = 0; i < data_len; i++) {
+        out[BINARY_PROTOCOL_HEADER_LEN + 1 + i] = data[i];
+    }
+    write_u16_le(out + BINARY_PROTOCOL_HEADER_LEN + payload_len,
+                 binary_protocol_crc16(out + 1, BINARY_PROTOCOL_HEADER_LEN - 1 + payload_len));
+    
+    return frame_len;
+}
+
+uint8_t binary_protocol_opcode_for(command_type_t type)
+{
+    uint8_t opcode = command_registry_opcode(type);
+    return opcode != 0 ? opcode : BINARY_OP_DIGIT;
+}
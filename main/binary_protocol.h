@@ -0,0 +1,109 @@
+/**
+ * @file binary_protocol.h
+ * @brief 二进制命令帧协议头文件
+ * 
+ * 帧格式（多字节字段均为小端）:
+ * 
+ *   | SOF(0xA5) | LEN | OPCODE | SEQ(2) | PAYLOAD(LEN) | CRC16(2) |
+ * 
+ * CRC16为CRC-16/CCITT-FALSE，覆盖LEN到PAYLOAD的全部字节。
+ * 回复帧格式相同，OPCODE为请求操作码 | 0x80，SEQ原样返回，
+ * PAYLOAD第一个字节为状态码（command_result_t），其后为附加数据。
+ * 请求负载即按注册表（command_registry.h）中参数顺序的小端编码
+ */
+
+#ifndef BINARY_PROTOCOL_H
+#define BINARY_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "command.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BINARY_PROTOCOL_SOF          0xA5   /**< 帧起始字节 */
+#define BINARY_PROTOCOL_HEADER_LEN   5      /**< SOF + LEN + OPCODE + SEQ */
+#define BINARY_PROTOCOL_CRC_LEN      2      /**< CRC16长度 */
+#define BINARY_PROTOCOL_MAX_PAYLOAD  32     /**< 最大负载长度 */
+#define BINARY_PROTOCOL_MAX_FRAME    (BINARY_PROTOCOL_HEADER_LEN + BINARY_PROTOCOL_MAX_PAYLOAD + BINARY_PROTOCOL_CRC_LEN)
+#define BINARY_PROTOCOL_REPLY_FLAG   0x80   /**< 回复帧操作码标志 */
+
+/**
+ * @brief 操作码
+ */
+typedef enum {
+    BINARY_OP_DIGIT     = 0x01, /**< payload: index(1) */
+    BINARY_OP_SET_ANGLE = 0x02, /**< payload: angle(1) hold_ms(2) */
+    BINARY_OP_FEED      = 0x03, /**< payload: tank_id(1) portions(1) */
+    BINARY_OP_STATUS    = 0x04, /**< payload: 无 */
+    BINARY_OP_SCHEDULE  = 0x05, /**< payload: delay_s(2) portions(1) */
+    BINARY_OP_STOP      = 0x06, /**< payload: 无 */
+} binary_opcode_t;
+
+/**
+ * @brief 帧解析结果
+ */
+typedef enum {
+    BINARY_PARSE_OK,            /**< 解析出一条完整命令 */
+    BINARY_PARSE_NEED_MORE,     /**< 数据不完整，需要继续接收 */
+    BINARY_PARSE_BAD_FRAME,     /**< 不是合法的帧头，应跳过一个字节重新同步 */
+    BINARY_PARSE_BAD_CRC,       /**< 校验失败，整帧已跳过 */
+    BINARY_PARSE_BAD_REQUEST,   /**< 帧完整但操作码或参数非法，整帧已跳过 */
+} binary_parse_result_t;
+
+/**
+ * @brief 解析出的帧信息
+ */
+typedef struct {
+    uint8_t opcode;     /**< 操作码 */
+    uint16_t seq;       /**< 序号 */
+    size_t frame_len;   /**< 整帧长度（已消费的字节数） */
+} binary_frame_info_t;
+
+/**
+ * @brief 计算CRC-16/CCITT-FALSE
+ */
+uint16_t binary_protocol_crc16(const uint8_t *data, size_t len);
+
+/**
+ * @brief 从接收缓冲区中原地解析一帧
+ * 
+ * 直接从缓冲区读取字段填充到命令结构体，不复制负载。
+ * 返回 BINARY_PARSE_OK / BAD_CRC / BAD_REQUEST 时 info 有效
+ * 
+ * @param buf 缓冲区，buf[0] 应为 SOF
+ * @param len 缓冲区中可用的字节数
+ * @param cmd 输出命令
+ * @param info 输出帧信息
+ * @return 解析结果
+ */
+binary_parse_result_t binary_protocol_parse(const uint8_t *buf, size_t len,
+                                            command_t *cmd, binary_frame_info_t *info);
+
+/**
+ * @brief 编码回复帧
+ * 
+ * @param out 输出缓冲区
+ * @param out_size 输出缓冲区大小，至少 BINARY_PROTOCOL_MAX_FRAME
+ * @param opcode 请求操作码
+ * @param seq 请求序号
+ * @param status 状态码
+ * @param data 附加数据，可为NULL
+ * @param data_len 附加数据长度
+ * @return 帧长度，0表示缓冲区不足
+ */
+size_t binary_protocol_encode_reply(uint8_t *out, size_t out_size, uint8_t opcode, uint16_t seq,
+                                    command_result_t status, const uint8_t *data, size_t data_len);
+
+/**
+ * @brief 获取命令类型对应的操作码
+ */
+uint8_t binary_protocol_opcode_for(command_type_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BINARY_PROTOCOL_H
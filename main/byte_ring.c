@@ -0,0 +1,92 @@
+/**
+ * @file byte_ring.c
+ * @brief 字节环形缓冲区实现
+ */
+
+#include "byte_ring.h"
+#include <string.h>
+
+void byte_ring_init(byte_ring_t *ring, uint8_t *buf, uint16_t size)
+{
+    ring->buf = buf;
+    ring->size = size;
+    ring->head = 0;
+    ring->tail = 0;
+}
+
+size_t byte_ring_write(byte_ring_t *ring, const void *data, size_t len)
+{
+    size_t space = byte_ring_free(ring);
+    if (len > space) {
+        len = space;
+    }
+    
+    size_t pos = ring->head & (ring->size - 1);
+    size_t first = ring->size - pos;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(ring->buf + pos, data, first);
+    memcpy(ring->buf, (const uint8_t *)data + first, len - first);
+    
+    ring->head += len;
+    return len;
+}
+
+size_t byte_ring_peek(const byte_ring_t *ring, size_t offset, void *out, size_t len)
+{
+    size_t used = byte_ring_used(ring);
+    if (offset >= used) {
+        return 0;
+    }
+    if (len > used - offset) {
+        len = used - offset;
+    }
+    
+    size_t pos = (uint16_t)(ring->tail + offset) & (ring->size - 1);
+    size_t first = ring->size - pos;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(out, ring->buf + pos, first);
+    memcpy((uint8_t *)out + first, ring->buf, len - first);
+    
+    return len;
+}
+
+const uint8_t *byte_ring_read_ptr(const byte_ring_t *ring, size_t *len)
+{
+    size_t pos = ring->tail & (ring->size - 1);
+    size_t used = byte_ring_used(ring);
+    size_t first = ring->size - pos;
+    
+    *len = used < first ? used : first;
+    return ring->buf + pos;
+}
+
+void byte_ring_consume(byte_ring_t *ring, size_t len)
+{
+    size_t used = byte_ring_used(ring);
+    if (len >= used) {
+        // 读完时回到存储区开头，下一次可以连续写满整个缓冲区
+        byte_ring_reset(ring);
+        return;
+    }
+    ring->tail += len;
+}
+
+uint8_t *byte_ring_write_ptr(byte_ring_t *ring, size_t *len)
+{
+    size_t pos = ring->head & (ring->size - 1);
+    size_t space = byte_ring_free(ring);
+    size_t first = ring->size - pos;
+    
+    *len = space < first ? space : first;
+    return ring->buf + pos;
+}
+
+void byte_ring_commit(byte_ring_t *ring, size_t len)
+{
+    size_t space = byte_ring_free(ring);
+    ring->head += len < space ? len : space;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file byte_ring.h
+ * @brief 字节环形缓冲区头文件
+ * 
+ * 使用调用方提供的静态存储，容量必须为2的幂。
+ * 读写位置为自由递增的16位计数，已用长度 = 写位置 - 读位置，不需要额外的满/空标志。
+ * 不加锁，只能由一个任务使用
+ */
+
+#ifndef BYTE_RING_H
+#define BYTE_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 字节环形缓冲区
+ */
+typedef struct {
+    uint8_t *buf;       /**< 存储区 */
+    uint16_t size;      /**< 容量（2的幂，最大32768） */
+    uint16_t head;      /**< 写位置 */
+    uint16_t tail;      /**< 读位置 */
+} byte_ring_t;
+
+/**
+ * @brief 初始化环形缓冲区
+ * @param ring 环形缓冲区
+ * @param buf 存储区
+ * @param size 容量，必须为2的幂
+ */
+void byte_ring_init(byte_ring_t *ring, uint8_t *buf, uint16_t size);
+
+/**
+ * @brief 清空环形缓冲区
+ */
+static inline void byte_ring_reset(byte_ring_t *ring)
+{
+    ring->head = 0;
+    ring->tail = 0;
+}
+
+/**
+ * @brief 已用长度
+ */
+static inline size_t byte_ring_used(const byte_ring_t *ring)
+{
+    return (uint16_t)(ring->head - ring->tail);
+}
+
+/**
+ * @brief 剩余空间
+ */
+static inline size_t byte_ring_free(const byte_ring_t *ring)
+{
+    return ring->size - byte_ring_used(ring);
+}
+
+/**
+ * @brief 写入数据
+ * @return 写入的字节数（空间不足时只写入能放下的部分）
+ */
+size_t byte_ring_write(byte_ring_t *ring, const void *data, size_t len);
+
+/**
+ * @brief 复制数据但不消费
+ * @param offset 从读位置起的偏移
+ * @return 复制的字节数
+ */
+size_t byte_ring_peek(const byte_ring_t *ring, size_t offset, void *out, size_t len);
+
+/**
+ * @brief 获取可连续读取的区域
+ * @param len 输出连续可读长度
+ * @return 读指针
+ */
+const uint8_t *byte_ring_read_ptr(const byte_ring_t *ring, size_t *len);
+
+/**
+ * @brief 消费已读取的数据，全部读完时读写位置回到存储区开头
+ */
+void byte_ring_consume(byte_ring_t *ring, size_t len);
+
+/**
+ * @brief 获取可连续写入的区域（用于recv直接写入）
+ * @param len 输出连续可写长度
+ * @return 写指针
+ */
+uint8_t *byte_ring_write_ptr(byte_ring_t *ring, size_t *len);
+
+/**
+ * @brief 提交直接写入的数据
+ */
+void byte_ring_commit(byte_ring_t *ring, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BYTE_RING_H
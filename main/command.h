@@ -0,0 +1,93 @@
+/**
+ * @file command.h
+ * @brief 控制命令类型定义
+ * 
+ * 各传输通道（TCP文本协议、二进制帧、UDP）解析出的命令统一用 command_t 表示，
+ * 由同一个命令回调分发处理。每种命令的名称、操作码、参数格式、处理函数和权限见 command_registry.h
+ */
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COMMAND_REQUEST_ID_MAX_LEN  15  /**< 请求ID最大长度 */
+
+/**
+ * @brief 命令类型
+ */
+typedef enum {
+    COMMAND_TYPE_DIGIT = 0,     /**< 旧协议数字命令 '0'-'9'，按角度映射表转动 */
+    COMMAND_TYPE_SET_ANGLE,     /**< 转到指定角度并保持指定时间 */
+    COMMAND_TYPE_FEED,          /**< 投喂指定份数 */
+    COMMAND_TYPE_STATUS,        /**< 查询状态 */
+    COMMAND_TYPE_SUBSCRIBE,     /**< 订阅事件流（由TCP服务器处理） */
+    COMMAND_TYPE_UNSUBSCRIBE,   /**< 取消订阅事件流（由TCP服务器处理） */
+    COMMAND_TYPE_SCHEDULE,      /**< 延时投喂 */
+    COMMAND_TYPE_STOP,          /**< 停止：取消排队的动作和延时投喂 */
+    COMMAND_TYPE_COUNT,         /**< 命令类型数量 */
+} command_type_t;
+
+#define COMMAND_MASK(type)      (1u << (type))  /**< 命令集合中表示一种命令的位 */
+#define COMMAND_MASK_ALL        0xFFFFFFFFu     /**< 全部命令 */
+#define COMMAND_MASK_READ_ONLY  COMMAND_MASK(COMMAND_TYPE_STATUS)  /**< 只读命令（不触发舵机动作） */
+
+/**
+ * @brief 命令权限，等级高的通道可以执行等级低的命令；请求上下文中的 perm 低于命令所需权限时分发时拒绝
+ */
+typedef enum {
+    COMMAND_PERM_READ = 0,      /**< 只读查询 */
+    COMMAND_PERM_CONTROL,       /**< 触发舵机动作 */
+    COMMAND_PERM_ADMIN,         /**< 影响其他请求（停止、计划任务） */
+} command_perm_t;
+
+/**
+ * @brief 命令处理结果（二进制协议中作为回复状态码）
+ */
+typedef enum {
+    COMMAND_RESULT_ACCEPTED = 0,    /**< 已接受，立即执行 */
+    COMMAND_RESULT_QUEUED,          /**< 已排队 */
+    COMMAND_RESULT_REJECTED_FULL,   /**< 队列已满 */
+    COMMAND_RESULT_DONE,            /**< 执行完成 */
+    COMMAND_RESULT_FAILED,          /**< 执行失败 */
+    COMMAND_RESULT_BAD_REQUEST,     /**< 请求格式或参数错误 */
+    COMMAND_RESULT_BAD_CRC,         /**< 校验失败 */
+    COMMAND_RESULT_UNSUPPORTED,     /**< 不支持的命令 */
+    COMMAND_RESULT_OK,              /**< 查询成功 */
+    COMMAND_RESULT_BUSY,            /**< 超出限流或并发限制，附带建议的重试等待时间 */
+} command_result_t;
+
+/**
+ * @brief 控制命令
+ */
+typedef struct {
+    command_type_t type;                /**< 命令类型 */
+    union {
+        struct {
+            uint8_t index;              /**< 命令序号 0-9 */
+        } digit;
+        struct {
+            uint8_t angle;              /**< 目标角度 0-180 */
+            uint16_t hold_ms;           /**< 保持时间，0表示保持在目标角度不复位 */
+        } set_angle;
+        struct {
+            uint8_t tank_id;            /**< 鱼缸/投喂器编号 */
+            uint8_t portions;           /**< 投喂份数 */
+        } feed;
+        struct {
+            uint16_t delay_s;           /**< 距现在的延时，秒 */
+            uint8_t portions;           /**< 投喂份数 */
+        } schedule;
+    } args;
+    char request_id[COMMAND_REQUEST_ID_MAX_LEN + 1]; /**< 可选的请求ID，空字符串表示没有；重试时用于去重（见 request_cache.h） */
+} command_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMMAND_H
@@ -0,0 +1,151 @@
+/**
+ * @file command_admission.c
+ * @brief 命令准入控制实现
+ * 
+ * 令牌桶和计数都在一个临界区中检查和更新，各传输通道的任务可以同时调用
+ */
+
+#include "command_admission.h"
+#include "token_bucket.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+// 按IP限流记录
+typedef struct {
+    bool valid;                 // 记录是否有效
+    uint32_t addr;              // 来源IP（网络字节序）
+    token_bucket_t bucket;      // 该IP的令牌桶
+    TickType_t last_used;       // 最后一次使用时间
+} admission_rate_entry_t;
+
+// 准入状态
+typedef struct {
+    portMUX_TYPE lock;                  // 保护整个状态
+    command_admission_config_t config;  // 准入参数
+    bool buckets_ready;                 // 令牌桶是否已按参数初始化
+    token_bucket_t global_bucket;       // 全局令牌桶
+    admission_rate_entry_t rate_table[COMMAND_ADMISSION_RATE_TABLE_SIZE]; // 按IP限流表
+    uint32_t inflight;                  // 未完成的命令数
+    uint32_t shed_count;                // 被拒绝的命令数
+} command_admission_state_t;
+
+static command_admission_state_t admission_state = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+    .config = COMMAND_ADMISSION_DEFAULT_CONFIG(),
+    .buckets_ready = false,
+};
+
+/**
+ * @brief 查找来源IP对应的令牌桶，不存在时替换最久未使用的记录（调用方持有锁）
+ */
+static token_bucket_t *rate_lookup_locked(uint32_t addr, const token_bucket_config_t *config, TickType_t now)
+{
+    admission_rate_entry_t *oldest = &admission_state.rate_table[0];
+    
+    for (int i = 0; i < COMMAND_ADMISSION_RATE_TABLE_SIZE; i++) {
+        admission_rate_entry_t *entry = &admission_state.rate_table[i];
+        if (entry->valid && entry->addr == addr) {
+            entry->last_used = now;
+            return &entry->bucket;
+        }
+        if (!entry->valid) {
+            oldest = entry;
+        } else if (oldest->valid && (now - entry->last_used) > (now - oldest->last_used)) {
+            oldest = entry;
+        }
+    }
+    
+    oldest->valid = true;
+    oldest->addr = addr;
+    oldest->last_used = now;
+    token_bucket_init(&oldest->bucket, config, now);
+    return &oldest->bucket;
+}
+
+void command_admission_configure(const command_admission_config_t *config)
+{
+    const token_bucket_config_t global_config = {
+        .rate_per_sec = config->rate_global,
+        .burst = config->burst_global,
+    };
+    TickType_t now = xTaskGetTickCount();
+    
+    portENTER_CRITICAL(&admission_state.lock);
+    admission_state.config = *config;
+    token_bucket_init(&admission_state.global_bucket, &global_config, now);
+    memset(admission_state.rate_table, 0, sizeof(admission_state.rate_table));
+    admission_state.buckets_ready = true;
+    portEXIT_CRITICAL(&admission_state.lock);
+}
+
+bool command_admission_required(command_type_t type)
+{
+    return type != COMMAND_TYPE_STATUS && type != COMMAND_TYPE_SUBSCRIBE && type != COMMAND_TYPE_UNSUBSCRIBE;
+}
+
+bool command_admission_acquire(uint32_t addr, bool track_inflight, uint32_t *retry_after_ms)
+{
+    TickType_t now = xTaskGetTickCount();
+    bool admitted = false;
+    
+    portENTER_CRITICAL(&admission_state.lock);
+    const command_admission_config_t *config = &admission_state.config;
+    const token_bucket_config_t ip_config = {
+        .rate_per_sec = config->rate_per_ip,
+        .burst = config->burst_per_ip,
+    };
+    const token_bucket_config_t global_config = {
+        .rate_per_sec = config->rate_global,
+        .burst = config->burst_global,
+    };
+    
+    // 没有调用过 command_admission_configure() 时按默认参数从满桶开始
+    if (!admission_state.buckets_ready) {
+        token_bucket_init(&admission_state.global_bucket, &global_config, now);
+        admission_state.buckets_ready = true;
+    }
+    
+    if (config->max_inflight_total > 0 && admission_state.inflight >= config->max_inflight_total) {
+        *retry_after_ms = config->inflight_retry_ms;
+    } else {
+        token_bucket_t *ip_bucket = addr != COMMAND_ADMISSION_ADDR_NONE ?
+                                    rate_lookup_locked(addr, &ip_config, now) : NULL;
+        if ((ip_bucket == NULL || token_bucket_peek(ip_bucket, &ip_config, now, retry_after_ms)) &&
+            token_bucket_peek(&admission_state.global_bucket, &global_config, now, retry_after_ms)) {
+            if (ip_bucket != NULL) {
+                token_bucket_take(ip_bucket, &ip_config);
+            }
+            token_bucket_take(&admission_state.global_bucket, &global_config);
+            if (track_inflight) {
+                admission_state.inflight++;
+            }
+            admitted = true;
+        }
+    }
+    if (!admitted) {
+        admission_state.shed_count++;
+    }
+    portEXIT_CRITICAL(&admission_state.lock);
+    
+    return admitted;
+}
+
+void command_admission_release(void)
+{
+    portENTER_CRITICAL(&admission_state.lock);
+    if (admission_state.inflight > 0) {
+        admission_state.inflight--;
+    }
+    portEXIT_CRITICAL(&admission_state.lock);
+}
+
+uint32_t command_admission_inflight(void)
+{
+    return admission_state.inflight;
+}
+
+uint32_t command_admission_shed_count(void)
+{
+    return admission_state.shed_count;
+}
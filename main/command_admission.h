@@ -0,0 +1,91 @@
+/**
+ * @file command_admission.h
+ * @brief 命令准入控制头文件
+ * 
+ * 所有传输通道（TCP、UDP、WebSocket、REST、MQTT）在分发状态查询以外的命令之前都调用
+ * command_admission_acquire()：按来源IP的令牌桶、全部通道共用的全局令牌桶，以及全局未完成命令数上限。
+ * 所有条件都满足后才消耗令牌，被任何一项拒绝都不改变其他项的状态，被拒绝的命令回复BUSY。
+ * 
+ * 只有TCP命令端口能收到动作完成通知，因此只有它占用未完成命令计数（track_inflight），
+ * 其他通道只检查上限而不计入；它们的排队数量由执行器队列长度限制
+ */
+
+#ifndef COMMAND_ADMISSION_H
+#define COMMAND_ADMISSION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "command.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COMMAND_ADMISSION_RATE_TABLE_SIZE   8   /**< 按IP限流的记录数量，超出后替换最久未使用的记录 */
+#define COMMAND_ADMISSION_ADDR_NONE         0   /**< 没有来源IP（例如经服务器转发的MQTT命令），只检查全局限制 */
+
+/**
+ * @brief 准入参数
+ */
+typedef struct {
+    uint16_t rate_per_ip;           /**< 每个来源IP每秒允许的命令数，0表示不限制 */
+    uint16_t burst_per_ip;          /**< 每个来源IP允许的突发命令数 */
+    uint16_t rate_global;           /**< 全部来源每秒允许的命令数，0表示不限制 */
+    uint16_t burst_global;          /**< 全部来源允许的突发命令数 */
+    uint8_t max_inflight_total;     /**< 未完成命令的上限，0表示不限制 */
+    uint16_t inflight_retry_ms;     /**< 超出未完成命令上限时建议的重试等待时间 */
+} command_admission_config_t;
+
+/**
+ * @brief 默认准入参数（与 TCP_SERVER_DEFAULT_OPTIONS 相同）：每个IP每秒5条（突发10条），
+ * 全局每秒20条（突发30条），最多8条未完成命令
+ */
+#define COMMAND_ADMISSION_DEFAULT_CONFIG()      \
+    {                                           \
+        .rate_per_ip = 5,                       \
+        .burst_per_ip = 10,                     \
+        .rate_global = 20,                      \
+        .burst_global = 30,                     \
+        .max_inflight_total = 8,                \
+        .inflight_retry_ms = 1000,              \
+    }
+
+/**
+ * @brief 设置准入参数，并把令牌桶重置为满桶、清空按IP限流表（未完成命令计数保留）
+ */
+void command_admission_configure(const command_admission_config_t *config);
+
+/**
+ * @brief 命令是否需要准入检查（状态查询和订阅不需要）
+ */
+bool command_admission_required(command_type_t type);
+
+/**
+ * @brief 准入检查，通过时消耗令牌（可在任意任务中调用）
+ * @param addr 来源IP（网络字节序），COMMAND_ADMISSION_ADDR_NONE 表示只检查全局限制
+ * @param track_inflight 是否占用一个未完成命令计数（之后必须调用 command_admission_release()）
+ * @param retry_after_ms 拒绝时输出建议的重试等待时间
+ * @return true 允许执行
+ */
+bool command_admission_acquire(uint32_t addr, bool track_inflight, uint32_t *retry_after_ms);
+
+/**
+ * @brief 释放一个未完成命令计数
+ */
+void command_admission_release(void);
+
+/**
+ * @brief 当前未完成的命令数
+ */
+uint32_t command_admission_inflight(void);
+
+/**
+ * @brief 因限流或并发限制被拒绝的命令数（全部通道）
+ */
+uint32_t command_admission_shed_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMMAND_ADMISSION_H
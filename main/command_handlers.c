@@ -0,0 +1,465 @@
+/**
+ * @file command_handlers.c
+ * @brief 命令处理函数实现
+ * 
+ * 动作命令放入执行器队列并立即回复；带标签的请求和二进制请求在动作完成后还会收到一条完成回复。
+ * 延时投喂使用一个FreeRTOS软件定时器，到期时在定时器任务中提交投喂动作
+ */
+
+#include "command_handlers.h"
+#include "command_registry.h"
+#include "command_admission.h"
+#include "actuator.h"
+#include "binary_protocol.h"
+#include "conn_pool.h"
+#include "event_stream.h"
+#include "request_cache.h"
+#include "wifi_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "COMMAND";
+
+// 命令处理状态
+typedef struct {
+    const sg90_config_t *servo; // 舵机配置，NULL表示尚未初始化
+    TimerHandle_t schedule_timer; // 延时投喂定时器
+    uint8_t schedule_portions;  // 到期时投喂的份数
+} command_handlers_state_t;
+
+static command_handlers_state_t handlers_state = {
+    .servo = NULL,
+    .schedule_timer = NULL,
+    .schedule_portions = 0,
+};
+
+// 舵机角度映射表 (命令0-9对应角度)
+static const uint8_t command_angle_map[10] = {
+    0,    // 命令'0' -> 0°
+    18,   // 命令'1' -> 18°
+    36,   // 命令'2' -> 36°
+    54,   // 命令'3' -> 54°
+    72,   // 命令'4' -> 72°
+    90,   // 命令'5' -> 90°
+    108,  // 命令'6' -> 108°
+    126,  // 命令'7' -> 126°
+    144,  // 命令'8' -> 144°
+    180   // 命令'9' -> 180°
+};
+
+/**
+ * @brief 发送二进制回复帧
+ */
+static void reply_binary(const tcp_request_ctx_t *ctx, const command_t *command,
+                         command_result_t status, const uint8_t *data, size_t data_len)
+{
+    uint8_t frame[BINARY_PROTOCOL_MAX_FRAME];
+    size_t len = binary_protocol_encode_reply(frame, sizeof(frame),
+                                              command_registry_opcode(command->type),
+                                              ctx->seq, status, data, data_len);
+    if (len > 0) {
+        tcp_server_reply_data(ctx, frame, len);
+    }
+}
+
+void command_reply_result(const tcp_request_ctx_t *ctx, const command_t *command,
+                          uint8_t angle, command_result_t result)
+{
+    char response[64];
+    bool tagged = ctx->tag[0] != '\0';
+    uint8_t pending = (uint8_t)actuator_pending_count();
+    
+    if (ctx->format == TCP_REPLY_FORMAT_BINARY) {
+        // 排队时附带队列中的命令数
+        reply_binary(ctx, command, result, &pending, result == COMMAND_RESULT_QUEUED ? 1 : 0);
+        return;
+    }
+    
+    if (tagged) {
+        switch (result) {
+            case COMMAND_RESULT_ACCEPTED:
+                snprintf(response, sizeof(response), "#%s ACCEPTED\n", ctx->tag);
+                break;
+            case COMMAND_RESULT_QUEUED:
+                snprintf(response, sizeof(response), "#%s QUEUED %u\n", ctx->tag, pending);
+                break;
+            case COMMAND_RESULT_REJECTED_FULL:
+                snprintf(response, sizeof(response), "#%s REJECTED full\n", ctx->tag);
+                break;
+            case COMMAND_RESULT_FAILED:
+                snprintf(response, sizeof(response), "#%s ERROR servo-not-initialized\n", ctx->tag);
+                break;
+            case COMMAND_RESULT_UNSUPPORTED:
+                snprintf(response, sizeof(response), "#%s ERROR unsupported\n", ctx->tag);
+                break;
+            default:
+                snprintf(response, sizeof(response), "#%s ERROR bad-command\n", ctx->tag);
+                break;
+        }
+    } else {
+        char command_char = command->type == COMMAND_TYPE_DIGIT ? '0' + command->args.digit.index : '?';
+        switch (result) {
+            case COMMAND_RESULT_ACCEPTED:
+                snprintf(response, sizeof(response), "ACCEPTED: Command %c -> Angle %d°\n", command_char, angle);
+                break;
+            case COMMAND_RESULT_QUEUED:
+                snprintf(response, sizeof(response), "QUEUED: Command %c -> Angle %d° (pending %u)\n",
+                         command_char, angle, pending);
+                break;
+            case COMMAND_RESULT_REJECTED_FULL:
+                snprintf(response, sizeof(response), "REJECTED: Queue full, command %c dropped\n", command_char);
+                break;
+            case COMMAND_RESULT_FAILED:
+                snprintf(response, sizeof(response), "ERROR: Servo not initialized\n");
+                break;
+            case COMMAND_RESULT_UNSUPPORTED:
+                snprintf(response, sizeof(response), "ERROR: Unsupported command\n");
+                break;
+            default:
+                snprintf(response, sizeof(response), "ERROR: Bad command\n");
+                break;
+        }
+    }
+    tcp_server_reply(ctx, response);
+}
+
+void command_reply_busy(const tcp_request_ctx_t *ctx, const command_t *command, uint32_t retry_after_ms)
+{
+    char response[64];
+    
+    if (retry_after_ms > UINT16_MAX) {
+        retry_after_ms = UINT16_MAX;
+    }
+    
+    if (ctx->format == TCP_REPLY_FORMAT_BINARY) {
+        uint8_t retry[2] = { retry_after_ms & 0xFF, retry_after_ms >> 8 };
+        reply_binary(ctx, command, COMMAND_RESULT_BUSY, retry, sizeof(retry));
+        return;
+    }
+    
+    if (ctx->tag[0] != '\0') {
+        snprintf(response, sizeof(response), "#%s BUSY retry-after=%u\n", ctx->tag, (unsigned)retry_after_ms);
+    } else {
+        snprintf(response, sizeof(response), "BUSY: retry after %u ms\n", (unsigned)retry_after_ms);
+    }
+    tcp_server_reply(ctx, response);
+}
+
+bool command_admit(const command_t *command, const tcp_request_ctx_t *ctx, uint32_t addr)
+{
+    if (!command_admission_required(command->type)) {
+        return true;
+    }
+    
+    uint32_t retry_after_ms = 0;
+    if (command_admission_acquire(addr, false, &retry_after_ms)) {
+        return true;
+    }
+    ESP_LOGW(TAG, "命令被限流: type=%d，%ums后重试", command->type, (unsigned)retry_after_ms);
+    command_reply_busy(ctx, command, retry_after_ms);
+    return false;
+}
+
+/**
+ * @brief 回复重复请求：返回去重缓存中的结果，不再执行动作
+ * 
+ * 文本格式: "#<tag> DONE <angle> cached" / "#<tag> FAILED <err> cached" / "#<tag> PENDING cached"
+ * （执行中的请求完成通知只发给原连接，控制端稍后再重试即可取得最终结果）
+ */
+static command_result_t reply_cached(const tcp_request_ctx_t *ctx, const command_t *command,
+                                     const request_result_t *cached)
+{
+    command_result_t result;
+    switch (cached->state) {
+        case REQUEST_STATE_DONE:
+            result = COMMAND_RESULT_DONE;
+            break;
+        case REQUEST_STATE_FAILED:
+            result = COMMAND_RESULT_FAILED;
+            break;
+        default:
+            result = COMMAND_RESULT_ACCEPTED;
+            break;
+    }
+    
+    if (ctx->format == TCP_REPLY_FORMAT_BINARY) {
+        reply_binary(ctx, command, result, &cached->angle, 1);
+    } else {
+        char response[64];
+        switch (cached->state) {
+            case REQUEST_STATE_DONE:
+                snprintf(response, sizeof(response), "#%s DONE %d cached\n", ctx->tag, cached->angle);
+                break;
+            case REQUEST_STATE_FAILED:
+                snprintf(response, sizeof(response), "#%s FAILED %s cached\n", ctx->tag,
+                         esp_err_to_name(cached->error));
+                break;
+            default:
+                snprintf(response, sizeof(response), "#%s PENDING cached\n", ctx->tag);
+                break;
+        }
+        tcp_server_reply(ctx, response);
+    }
+    
+    // 执行中的请求不能返回ACCEPTED，否则TCP服务器会为它再计一次未完成命令
+    return result == COMMAND_RESULT_ACCEPTED ? COMMAND_RESULT_OK : result;
+}
+
+/**
+ * @brief 命令执行完成回调（在执行器任务中调用）
+ */
+static void command_done_handler(const actuator_cmd_t *cmd, esp_err_t result)
+{
+    if (cmd->origin.request_id[0] != '\0') {
+        request_cache_complete(cmd->origin.request_scope, cmd->origin.request_id, result);
+    }
+    
+    // 没有来源连接（UDP/WebSocket/REST/MQTT的带ID请求）时只记录结果
+    if (cmd->origin.conn_id == 0) {
+        return;
+    }
+    
+    // 释放该连接的未完成命令计数
+    tcp_server_release_inflight(cmd->origin.conn_id);
+    
+    // 旧协议（无标签）不发送完成通知
+    if (cmd->origin.format == TCP_REPLY_FORMAT_TEXT && cmd->origin.tag[0] == '\0') {
+        return;
+    }
+    
+    if (cmd->origin.format == TCP_REPLY_FORMAT_BINARY) {
+        uint8_t frame[BINARY_PROTOCOL_MAX_FRAME];
+        size_t len = binary_protocol_encode_reply(frame, sizeof(frame), cmd->origin.opcode, cmd->origin.seq,
+                                                  result == ESP_OK ? COMMAND_RESULT_DONE : COMMAND_RESULT_FAILED,
+                                                  &cmd->angle, 1);
+        if (len > 0) {
+            tcp_server_send_data_to_conn(cmd->origin.conn_id, frame, len);
+        }
+        return;
+    }
+    
+    char response[64];
+    if (result == ESP_OK) {
+        snprintf(response, sizeof(response), "#%s DONE %d\n", cmd->origin.tag, cmd->angle);
+    } else {
+        snprintf(response, sizeof(response), "#%s FAILED %s\n", cmd->origin.tag, esp_err_to_name(result));
+    }
+    tcp_server_send_to_conn(cmd->origin.conn_id, response);
+}
+
+/**
+ * @brief 把命令转换为执行器命令（参数已由注册表检查）
+ * @return true 是动作命令
+ */
+static bool build_actuator_cmd(const command_t *command, actuator_cmd_t *cmd)
+{
+    switch (command->type) {
+        case COMMAND_TYPE_DIGIT:
+            // 设置目标角度，1秒后自动复位到0°
+            cmd->angle = command_angle_map[command->args.digit.index];
+            cmd->reset_delay_ms = SERVO_RESET_DELAY_MS;
+            cmd->repeat = 1;
+            return true;
+            
+        case COMMAND_TYPE_SET_ANGLE:
+            cmd->angle = command->args.set_angle.angle;
+            cmd->reset_delay_ms = command->args.set_angle.hold_ms;
+            cmd->repeat = 1;
+            return true;
+            
+        case COMMAND_TYPE_FEED:
+            cmd->angle = FEED_DISPENSE_ANGLE;
+            cmd->reset_delay_ms = SERVO_RESET_DELAY_MS;
+            cmd->repeat = command->args.feed.portions;
+            return true;
+            
+        default:
+            return false;
+    }
+}
+
+command_result_t command_handle_status(const command_t *command, const tcp_request_ctx_t *ctx)
+{
+    uint8_t status[3] = {
+        (uint8_t)actuator_pending_count(),
+        ACTUATOR_QUEUE_LENGTH,
+        wifi_is_connected() ? 1 : 0,
+    };
+    if (ctx->format == TCP_REPLY_FORMAT_BINARY) {
+        reply_binary(ctx, command, COMMAND_RESULT_OK, status, sizeof(status));
+    } else {
+        // 文本格式附带连接池占用和内部DRAM空闲量，用于长时间连接压力测试时确认堆内存不增长
+        char response[128];
+        conn_pool_stats_t pool_stats;
+        conn_pool_get_stats(&pool_stats);
+        snprintf(response, sizeof(response),
+                 "%s%s%sSTATUS pending=%u/%u wifi=%u conns=%u/%u heap=%u heap_min=%u\n",
+                 ctx->tag[0] ? "#" : "", ctx->tag, ctx->tag[0] ? " " : "",
+                 status[0], status[1], status[2], pool_stats.in_use, pool_stats.capacity,
+                 (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                 (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+        tcp_server_reply(ctx, response);
+    }
+    return COMMAND_RESULT_OK;
+}
+
+command_result_t command_handle_motion(const command_t *command, const tcp_request_ctx_t *ctx)
+{
+    actuator_cmd_t cmd = {
+        .on_done = NULL,
+    };
+    
+    if (!build_actuator_cmd(command, &cmd)) {
+        command_reply_result(ctx, command, 0, COMMAND_RESULT_UNSUPPORTED);
+        return COMMAND_RESULT_UNSUPPORTED;
+    }
+    
+    ESP_LOGI(TAG, "收到命令: type=%d -> 角度: %d°", command->type, cmd.angle);
+    
+    if (handlers_state.servo == NULL) {
+        command_reply_result(ctx, command, cmd.angle, COMMAND_RESULT_FAILED);
+        return COMMAND_RESULT_FAILED;
+    }
+    
+    // 带请求ID的重试直接返回缓存的结果，不重复执行动作；没有显式的请求ID时使用传输通道提供的去重ID
+    const char *request_id = NULL;
+    uint32_t request_scope = REQUEST_CACHE_SCOPE_GLOBAL;
+    if (command->request_id[0] != '\0') {
+        request_id = command->request_id;
+    } else if (ctx->dedupe_id != NULL && ctx->dedupe_id[0] != '\0') {
+        request_id = ctx->dedupe_id;
+        request_scope = ctx->dedupe_scope;
+    }
+    bool has_request_id = request_id != NULL;
+    if (has_request_id) {
+        request_result_t cached;
+        if (request_cache_begin(request_scope, request_id, cmd.angle, &cached)) {
+            ESP_LOGI(TAG, "重复请求: id=%s，返回缓存结果(状态 %d)", request_id, cached.state);
+            return reply_cached(ctx, command, &cached);
+        }
+        strncpy(cmd.origin.request_id, request_id, COMMAND_REQUEST_ID_MAX_LEN);
+        cmd.origin.request_id[COMMAND_REQUEST_ID_MAX_LEN] = '\0';
+        cmd.origin.request_scope = request_scope;
+        cmd.on_done = command_done_handler;
+    }
+    
+    // TCP连接需要完成通知（释放未完成命令计数，并回复带标签或二进制的请求）
+    if (ctx->conn_id != 0) {
+        cmd.origin.conn_id = ctx->conn_id;
+        cmd.origin.format = ctx->format;
+        cmd.origin.opcode = command_registry_opcode(command->type);
+        cmd.origin.seq = ctx->seq;
+        strncpy(cmd.origin.tag, ctx->tag, ACTUATOR_TAG_MAX_LEN);
+        cmd.origin.tag[ACTUATOR_TAG_MAX_LEN] = '\0';
+        cmd.on_done = command_done_handler;
+    }
+    
+    command_result_t result;
+    switch (actuator_submit(&cmd)) {
+        case ACTUATOR_SUBMIT_ACCEPTED:
+            result = COMMAND_RESULT_ACCEPTED;
+            break;
+        case ACTUATOR_SUBMIT_QUEUED:
+            result = COMMAND_RESULT_QUEUED;
+            break;
+        default:
+            result = COMMAND_RESULT_REJECTED_FULL;
+            break;
+    }
+    if (result != COMMAND_RESULT_REJECTED_FULL) {
+        event_stream_publish(EVENT_COMMAND_ACCEPTED, cmd.angle, actuator_pending_count());
+    } else if (has_request_id) {
+        request_cache_forget(request_scope, request_id);   // 未执行，重试时应重新执行
+    }
+    command_reply_result(ctx, command, cmd.angle, result);
+    return result;
+}
+
+/**
+ * @brief 延时投喂定时器到期（在定时器任务中调用）
+ */
+static void schedule_timer_callback(TimerHandle_t timer)
+{
+    actuator_cmd_t cmd = {
+        .angle = FEED_DISPENSE_ANGLE,
+        .reset_delay_ms = SERVO_RESET_DELAY_MS,
+        .repeat = handlers_state.schedule_portions,
+        .on_done = NULL,
+    };
+    
+    if (handlers_state.servo == NULL || actuator_submit(&cmd) == ACTUATOR_SUBMIT_REJECTED_FULL) {
+        ESP_LOGW(TAG, "延时投喂未能执行: %s", handlers_state.servo == NULL ? "舵机未初始化" : "队列已满");
+        event_stream_publish(EVENT_ERROR, ESP_ERR_INVALID_STATE, 0);
+        return;
+    }
+    ESP_LOGI(TAG, "延时投喂开始: %u 份", handlers_state.schedule_portions);
+    event_stream_publish(EVENT_COMMAND_ACCEPTED, cmd.angle, actuator_pending_count());
+}
+
+command_result_t command_handle_schedule(const command_t *command, const tcp_request_ctx_t *ctx)
+{
+    uint16_t delay_s = command->args.schedule.delay_s;
+    
+    // 停止旧计划后再修改份数，避免定时器任务读到一半更新的参数
+    xTimerStop(handlers_state.schedule_timer, portMAX_DELAY);
+    handlers_state.schedule_portions = command->args.schedule.portions;
+    if (xTimerChangePeriod(handlers_state.schedule_timer, pdMS_TO_TICKS((uint32_t)delay_s * 1000), portMAX_DELAY) != pdPASS) {
+        command_reply_result(ctx, command, 0, COMMAND_RESULT_FAILED);
+        return COMMAND_RESULT_FAILED;
+    }
+    
+    ESP_LOGI(TAG, "计划在 %u 秒后投喂 %u 份", delay_s, command->args.schedule.portions);
+    if (ctx->format == TCP_REPLY_FORMAT_BINARY) {
+        uint8_t data[2] = { delay_s & 0xFF, delay_s >> 8 };
+        reply_binary(ctx, command, COMMAND_RESULT_OK, data, sizeof(data));
+    } else {
+        char response[48];
+        snprintf(response, sizeof(response), "%s%s%sSCHEDULED %u\n",
+                 ctx->tag[0] ? "#" : "", ctx->tag, ctx->tag[0] ? " " : "", delay_s);
+        tcp_server_reply(ctx, response);
+    }
+    return COMMAND_RESULT_OK;
+}
+
+command_result_t command_handle_stop(const command_t *command, const tcp_request_ctx_t *ctx)
+{
+    bool had_schedule = xTimerIsTimerActive(handlers_state.schedule_timer) != pdFALSE;
+    xTimerStop(handlers_state.schedule_timer, portMAX_DELAY);
+    uint8_t cancelled = (uint8_t)actuator_cancel_pending();
+    
+    ESP_LOGI(TAG, "停止: 取消 %u 条排队命令%s", cancelled, had_schedule ? "和延时投喂" : "");
+    if (ctx->format == TCP_REPLY_FORMAT_BINARY) {
+        reply_binary(ctx, command, COMMAND_RESULT_OK, &cancelled, 1);
+    } else {
+        char response[48];
+        snprintf(response, sizeof(response), "%s%s%sSTOPPED %u\n",
+                 ctx->tag[0] ? "#" : "", ctx->tag, ctx->tag[0] ? " " : "", cancelled);
+        tcp_server_reply(ctx, response);
+    }
+    return COMMAND_RESULT_OK;
+}
+
+esp_err_t command_handlers_init(void)
+{
+    if (handlers_state.schedule_timer != NULL) {
+        return ESP_OK;
+    }
+    
+    // 周期在每次SCHEDULE时重新设置，这里只是占位
+    handlers_state.schedule_timer = xTimerCreate("schedule", pdMS_TO_TICKS(1000), pdFALSE, NULL,
+                                                 schedule_timer_callback);
+    if (handlers_state.schedule_timer == NULL) {
+        ESP_LOGE(TAG, "创建延时投喂定时器失败");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void command_handlers_set_servo(const sg90_config_t *servo)
+{
+    handlers_state.servo = servo;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file command_handlers.h
+ * @brief 命令处理函数头文件
+ * 
+ * 注册表（command_registry.h）中各命令的处理函数。处理函数只负责把动作放入执行器队列并立即回复，
+ * 不在网络任务中等待舵机动作；参数已由注册表按声明检查过
+ */
+
+#ifndef COMMAND_HANDLERS_H
+#define COMMAND_HANDLERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "command.h"
+#include "tcp_server.h"
+#include "sg90_servo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FEED_DISPENSE_ANGLE     90      /**< 每份投喂舵机转到的角度 */
+#define FEED_MAX_PORTIONS       10      /**< 单次命令最多投喂份数 */
+#define FEED_TANK_COUNT         1       /**< 投喂器数量 */
+#define SET_ANGLE_MAX_HOLD_MS   10000   /**< 设置角度命令的最大保持时间 */
+#define SCHEDULE_MAX_DELAY_S    43200   /**< 延时投喂的最长延时（12小时） */
+#define SERVO_RESET_DELAY_MS    1000    /**< 动作后保持多久复位到0° */
+
+/**
+ * @brief 初始化命令处理（创建延时投喂定时器）
+ * @return ESP_OK 成功
+ */
+esp_err_t command_handlers_init(void);
+
+/**
+ * @brief 设置舵机，设置之前动作命令回复失败
+ * @param servo 已初始化的舵机配置
+ */
+void command_handlers_set_servo(const sg90_config_t *servo);
+
+/**
+ * @brief 按请求的协议格式回复命令处理结果（不附带数据的结果）
+ * @param ctx 请求上下文
+ * @param command 命令
+ * @param angle 目标角度（旧协议回复中使用）
+ * @param result 处理结果
+ */
+void command_reply_result(const tcp_request_ctx_t *ctx, const command_t *command,
+                          uint8_t angle, command_result_t result);
+
+/**
+ * @brief 回复BUSY，告知请求方稍后重试
+ * 
+ * 文本格式 "#<tag> BUSY retry-after=<ms>"（旧协议 "BUSY: retry after <ms> ms"），
+ * 二进制格式为 COMMAND_RESULT_BUSY 附带2字节小端的重试等待毫秒数
+ * 
+ * @param ctx 请求上下文
+ * @param command 命令
+ * @param retry_after_ms 建议的重试等待时间
+ */
+void command_reply_busy(const tcp_request_ctx_t *ctx, const command_t *command, uint32_t retry_after_ms);
+
+/**
+ * @brief 不跟踪动作完成的传输通道（UDP、WebSocket、REST、MQTT）在分发命令前的准入检查
+ * 
+ * 需要准入的命令经过 command_admission_acquire()（不占用未完成命令计数），被拒绝时回复BUSY
+ * 
+ * @param command 命令
+ * @param ctx 请求上下文
+ * @param addr 来源IP（网络字节序），COMMAND_ADMISSION_ADDR_NONE 表示只检查全局限制
+ * @return true 可以分发，false 已回复BUSY
+ */
+bool command_admit(const command_t *command, const tcp_request_ctx_t *ctx, uint32_t addr);
+
+/**
+ * @brief STATUS：回复队列、WiFi、连接池和内存状态
+ */
+command_result_t command_handle_status(const command_t *command, const tcp_request_ctx_t *ctx);
+
+/**
+ * @brief 数字命令 / ANGLE / FEED：放入执行器队列
+ */
+command_result_t command_handle_motion(const command_t *command, const tcp_request_ctx_t *ctx);
+
+/**
+ * @brief SCHEDULE：延时投喂（只保留一个计划，新的计划替换旧的）
+ */
+command_result_t command_handle_schedule(const command_t *command, const tcp_request_ctx_t *ctx);
+
+/**
+ * @brief STOP：取消排队的动作和延时投喂
+ */
+command_result_t command_handle_stop(const command_t *command, const tcp_request_ctx_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMMAND_HANDLERS_H
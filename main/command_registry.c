@@ -0,0 +1,381 @@
+/**
+ * @file command_registry.c
+ * @brief 命令注册表实现
+ * 
+ * 命令表按命令类型索引，操作码表按操作码索引；文本动词用完美哈希的switch查找，
+ * 编译器把连续的case编译为跳转表
+ */
+
+#include "command_registry.h"
+#include "command_handlers.h"
+#include "binary_protocol.h"
+#include "esp_log.h"
+#include <stddef.h>
+#include <string.h>
+
+static const char *TAG = "COMMAND_REGISTRY";
+
+#define ARG(field, opt, lo, hi, dflt)                                   \
+    {                                                                   \
+        .offset = offsetof(command_t, args.field),                      \
+        .size = sizeof(((command_t *)0)->args.field),                   \
+        .optional = (opt),                                              \
+        .min = (lo),                                                    \
+        .max = (hi),                                                    \
+        .def = (dflt),                                                  \
+    }
+
+#define VERB(text)  .name = (text), .name_len = sizeof(text) - 1
+
+/**
+ * @brief 命令表
+ * 
+ * 新增命令：在 command.h 中增加命令类型，在这里声明一行，并在 VERB_HASH_CASES 中加上动词的首末字符；
+ * 首末字符写错时 command_registry_init() 的自检会失败
+ */
+static const command_spec_t command_specs[COMMAND_TYPE_COUNT] = {
+    [COMMAND_TYPE_DIGIT] = {
+        .name = NULL,           // 旧协议的单个数字，由协议层直接识别
+        .opcode = BINARY_OP_DIGIT,
+        .arg_count = 1,
+        .args = { ARG(digit.index, false, 0, 9, 0) },
+        .perm = COMMAND_PERM_CONTROL,
+        .handler = command_handle_motion,
+    },
+    [COMMAND_TYPE_SET_ANGLE] = {
+        VERB("ANGLE"),          // ANGLE <角度> [保持毫秒]
+        .opcode = BINARY_OP_SET_ANGLE,
+        .arg_count = 2,
+        .args = {
+            ARG(set_angle.angle, false, 0, 180, 0),
+            ARG(set_angle.hold_ms, true, 0, SET_ANGLE_MAX_HOLD_MS, 0),
+        },
+        .perm = COMMAND_PERM_CONTROL,
+        .handler = command_handle_motion,
+    },
+    [COMMAND_TYPE_FEED] = {
+        VERB("FEED"),           // FEED <投喂器> [份数]
+        .opcode = BINARY_OP_FEED,
+        .arg_count = 2,
+        .args = {
+            ARG(feed.tank_id, false, 0, FEED_TANK_COUNT - 1, 0),
+            ARG(feed.portions, true, 1, FEED_MAX_PORTIONS, 1),
+        },
+        .perm = COMMAND_PERM_CONTROL,
+        .handler = command_handle_motion,
+    },
+    [COMMAND_TYPE_STATUS] = {
+        VERB("STATUS"),
+        .opcode = BINARY_OP_STATUS,
+        .arg_count = 0,
+        .perm = COMMAND_PERM_READ,
+        .handler = command_handle_status,
+    },
+    [COMMAND_TYPE_SUBSCRIBE] = {
+        VERB("SUBSCRIBE"),      // 由TCP服务器处理
+        .opcode = 0,
+        .arg_count = 0,
+        .perm = COMMAND_PERM_CONTROL,
+        .handler = NULL,
+    },
+    [COMMAND_TYPE_UNSUBSCRIBE] = {
+        VERB("UNSUBSCRIBE"),    // 由TCP服务器处理
+        .opcode = 0,
+        .arg_count = 0,
+        .perm = COMMAND_PERM_CONTROL,
+        .handler = NULL,
+    },
+    [COMMAND_TYPE_SCHEDULE] = {
+        VERB("SCHEDULE"),       // SCHEDULE <延时秒> [份数]
+        .opcode = BINARY_OP_SCHEDULE,
+        .arg_count = 2,
+        .args = {
+            ARG(schedule.delay_s, false, 1, SCHEDULE_MAX_DELAY_S, 0),
+            ARG(schedule.portions, true, 1, FEED_MAX_PORTIONS, 1),
+        },
+        .perm = COMMAND_PERM_ADMIN,
+        .handler = command_handle_schedule,
+    },
+    [COMMAND_TYPE_STOP] = {
+        VERB("STOP"),
+        .opcode = BINARY_OP_STOP,
+        .arg_count = 0,
+        .perm = COMMAND_PERM_ADMIN,
+        .handler = command_handle_stop,
+    },
+};
+
+/**
+ * @brief 文本动词的完美哈希，参数均为编译期常量时结果也是常量
+ */
+#define VERB_HASH(first, last, len)  (((unsigned)(first) + (unsigned)(last) + (unsigned)(len)) & 0x0F)
+
+/**
+ * @brief 动词 -> 命令类型的switch分支：VERB_CASE(命令类型, 动词, 首字符, 末字符)
+ * 
+ * 两个动词哈希相同时出现重复的case标签，编译失败，此时应调整 VERB_HASH。
+ * 首末字符是手写的，与动词是否一致由 command_registry_init() 检查
+ */
+#define VERB_CASE(type, text, first, last)  case VERB_HASH(first, last, sizeof(text) - 1): return (type);
+#define VERB_HASH_CASES                                                         \
+    VERB_CASE(COMMAND_TYPE_SET_ANGLE,   "ANGLE",       'A', 'E')                \
+    VERB_CASE(COMMAND_TYPE_FEED,        "FEED",        'F', 'D')                \
+    VERB_CASE(COMMAND_TYPE_STATUS,      "STATUS",      'S', 'S')                \
+    VERB_CASE(COMMAND_TYPE_SUBSCRIBE,   "SUBSCRIBE",   'S', 'E')                \
+    VERB_CASE(COMMAND_TYPE_UNSUBSCRIBE, "UNSUBSCRIBE", 'U', 'E')                \
+    VERB_CASE(COMMAND_TYPE_SCHEDULE,    "SCHEDULE",    'S', 'E')                \
+    VERB_CASE(COMMAND_TYPE_STOP,        "STOP",        'S', 'P')
+
+/**
+ * @brief 按哈希取唯一的候选命令类型
+ * @return 命令类型，没有候选时返回 COMMAND_TYPE_COUNT
+ */
+static command_type_t verb_candidate(const char *word, size_t len)
+{
+    switch (VERB_HASH(word[0], word[len - 1], len)) {
+        VERB_HASH_CASES
+        default:
+            return COMMAND_TYPE_COUNT;
+    }
+}
+
+/**
+ * @brief 操作码 -> 命令类型 + 1，0表示未使用
+ */
+#define OPCODE_TABLE_SIZE   8
+static const uint8_t opcode_types[OPCODE_TABLE_SIZE] = {
+    [BINARY_OP_DIGIT] = COMMAND_TYPE_DIGIT + 1,
+    [BINARY_OP_SET_ANGLE] = COMMAND_TYPE_SET_ANGLE + 1,
+    [BINARY_OP_FEED] = COMMAND_TYPE_FEED + 1,
+    [BINARY_OP_STATUS] = COMMAND_TYPE_STATUS + 1,
+    [BINARY_OP_SCHEDULE] = COMMAND_TYPE_SCHEDULE + 1,
+    [BINARY_OP_STOP] = COMMAND_TYPE_STOP + 1,
+};
+
+_Static_assert(BINARY_OP_STOP < OPCODE_TABLE_SIZE, "opcode table too small");
+
+/**
+ * @brief 把参数值写入命令
+ */
+static void arg_store(command_t *cmd, const command_arg_spec_t *arg, uint16_t value)
+{
+    uint8_t *field = (uint8_t *)cmd + arg->offset;
+    if (arg->size == 1) {
+        *field = (uint8_t)value;
+    } else {
+        memcpy(field, &value, sizeof(value));
+    }
+}
+
+/**
+ * @brief 从命令中读取参数值
+ */
+static uint16_t arg_load(const command_t *cmd, const command_arg_spec_t *arg)
+{
+    const uint8_t *field = (const uint8_t *)cmd + arg->offset;
+    if (arg->size == 1) {
+        return *field;
+    }
+    uint16_t value;
+    memcpy(&value, field, sizeof(value));
+    return value;
+}
+
+esp_err_t command_registry_init(void)
+{
+    esp_err_t ret = ESP_OK;
+    
+    for (int type = 0; type < COMMAND_TYPE_COUNT; type++) {
+        const command_spec_t *spec = &command_specs[type];
+    
+        // 动词必须按哈希找回自己；VERB_HASH_CASES 漏写或首末字符写错时找不到或找到其他命令
+        command_type_t found;
+        if (spec->name != NULL &&
+            (spec->name_len == 0 || spec->name_len != strlen(spec->name) ||
+             !command_registry_find_verb(spec->name, spec->name_len, &found) || found != (command_type_t)type)) {
+            ESP_LOGE(TAG, "动词 %s 与哈希表不一致（检查 VERB_HASH_CASES）", spec->name);
+            ret = ESP_ERR_INVALID_STATE;
+        }
+    
+        // 操作码必须映射回自己
+        if (spec->opcode != 0 &&
+            (!command_registry_find_opcode(spec->opcode, &found) || found != (command_type_t)type)) {
+            ESP_LOGE(TAG, "命令%d的操作码0x%02X与操作码表不一致", type, spec->opcode);
+            ret = ESP_ERR_INVALID_STATE;
+        }
+    }
+    
+    // 操作码表中的每一项都必须是该命令声明的操作码
+    for (int opcode = 0; opcode < OPCODE_TABLE_SIZE; opcode++) {
+        if (opcode_types[opcode] != 0 &&
+            (opcode_types[opcode] > COMMAND_TYPE_COUNT || command_specs[opcode_types[opcode] - 1].opcode != opcode)) {
+            ESP_LOGE(TAG, "操作码0x%02X映射到的命令没有声明该操作码", opcode);
+            ret = ESP_ERR_INVALID_STATE;
+        }
+    }
+    return ret;
+}
+
+const command_spec_t *command_registry_get(command_type_t type)
+{
+    if ((unsigned)type >= COMMAND_TYPE_COUNT) {
+        return NULL;
+    }
+    return &command_specs[type];
+}
+
+bool command_registry_find_verb(const char *word, size_t len, command_type_t *type)
+{
+    if (len == 0) {
+        return false;
+    }
+    
+    command_type_t candidate = verb_candidate(word, len);
+    if (candidate == COMMAND_TYPE_COUNT) {
+        return false;
+    }
+    
+    // 哈希只看首末字符和长度，确认一次以排除碰巧同哈希的未知动词
+    const command_spec_t *spec = &command_specs[candidate];
+    if (spec->name_len != len || memcmp(spec->name, word, len) != 0) {
+        return false;
+    }
+    *type = candidate;
+    return true;
+}
+
+bool command_registry_find_opcode(uint8_t opcode, command_type_t *type)
+{
+    if (opcode >= OPCODE_TABLE_SIZE || opcode_types[opcode] == 0) {
+        return false;
+    }
+    *type = (command_type_t)(opcode_types[opcode] - 1);
+    return true;
+}
+
+uint8_t command_registry_opcode(command_type_t type)
+{
+    const command_spec_t *spec = command_registry_get(type);
+    return spec != NULL ? spec->opcode : 0;
+}
+
+bool command_registry_parse_text(const char *text, size_t len, command_t *cmd)
+{
+    const command_spec_t *spec = command_registry_get(cmd->type);
+    if (spec == NULL) {
+        return false;
+    }
+    
+    size_t pos = 0;
+    uint8_t index = 0;
+    while (true) {
+        while (pos < len && text[pos] == ' ') {
+            pos++;
+        }
+        if (pos == len) {
+            break;
+        }
+        if (index >= spec->arg_count) {
+            return false;   // 参数过多
+        }
+    
+        // 十进制数，超过范围上限即判为非法，避免溢出
+        const command_arg_spec_t *arg = &spec->args[index];
+        uint32_t value = 0;
+        size_t start = pos;
+        while (pos < len && text[pos] >= '0' && text[pos] <= '9') {
+            value = value * 10 + (text[pos] - '0');
+            if (value > arg->max) {
+                return false;
+            }
+            pos++;
+        }
+        if (pos == start || (pos < len && text[pos] != ' ') || value < arg->min) {
+            return false;
+        }
+        arg_store(cmd, arg, (uint16_t)value);
+        index++;
+    }
+    
+    // 省略的参数取默认值，必填参数不能省略
+    for (; index < spec->arg_count; index++) {
+        if (!spec->args[index].optional) {
+            return false;
+        }
+        arg_store(cmd, &spec->args[index], spec->args[index].def);
+    }
+    return true;
+}
+
+bool command_registry_decode_payload(const uint8_t *payload, size_t len, command_t *cmd)
+{
+    const command_spec_t *spec = command_registry_get(cmd->type);
+    if (spec == NULL || spec->opcode == 0) {
+        return false;
+    }
+    
+    size_t pos = 0;
+    for (uint8_t i = 0; i < spec->arg_count; i++) {
+        const command_arg_spec_t *arg = &spec->args[i];
+        if (pos + arg->size > len) {
+            return false;
+        }
+        uint16_t value = arg->size == 1 ? payload[pos] : (uint16_t)(payload[pos] | (payload[pos + 1] << 8));
+        if (value < arg->min || value > arg->max) {
+            return false;
+        }
+        arg_store(cmd, arg, value);
+        pos += arg->size;
+    }
+    return pos == len;
+}
+
+bool command_registry_validate(const command_t *cmd)
+{
+    const command_spec_t *spec = command_registry_get(cmd->type);
+    if (spec == NULL) {
+        return false;
+    }
+    
+    for (uint8_t i = 0; i < spec->arg_count; i++) {
+        uint16_t value = arg_load(cmd, &spec->args[i]);
+        if (value < spec->args[i].min || value > spec->args[i].max) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t command_registry_mask(command_perm_t perm)
+{
+    uint32_t mask = 0;
+    for (int type = 0; type < COMMAND_TYPE_COUNT; type++) {
+        if (command_specs[type].perm <= perm) {
+            mask |= COMMAND_MASK(type);
+        }
+    }
+    return mask;
+}
+
+command_result_t command_registry_dispatch(const command_t *command, const tcp_request_ctx_t *ctx)
+{
+    const command_spec_t *spec = command_registry_get(command->type);
+    if (spec == NULL || spec->handler == NULL) {
+        command_reply_result(ctx, command, 0, COMMAND_RESULT_UNSUPPORTED);
+        return COMMAND_RESULT_UNSUPPORTED;
+    }
+    
+    if (spec->perm > ctx->perm) {
+        ESP_LOGW(TAG, "权限不足: type=%d 需要%d，请求方为%d", command->type, spec->perm, ctx->perm);
+        command_reply_result(ctx, command, 0, COMMAND_RESULT_UNSUPPORTED);
+        return COMMAND_RESULT_UNSUPPORTED;
+    }
+    
+    if (!command_registry_validate(command)) {
+        ESP_LOGW(TAG, "命令参数非法: type=%d", command->type);
+        command_reply_result(ctx, command, 0, COMMAND_RESULT_BAD_REQUEST);
+        return COMMAND_RESULT_BAD_REQUEST;
+    }
+    
+    return spec->handler(command, ctx);
+}
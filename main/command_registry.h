@@ -0,0 +1,140 @@
+/**
+ * @file command_registry.h
+ * @brief 命令注册表头文件
+ * 
+ * 每种命令在注册表中声明一行：文本协议动词、二进制操作码、参数格式、处理函数和权限。
+ * 文本协议、二进制帧和各传输通道都通过注册表解析和分发命令，
+ * 新增命令只需在 command_registry.c 的表中加一行并实现处理函数，不需要修改socket层。
+ * 
+ * 查找都是O(1)：命令类型和操作码直接索引数组；文本动词按（首字符 + 末字符 + 长度）做完美哈希，
+ * 哈希值在编译期由表中的字符常量算出并作为switch分支，出现冲突时编译失败，
+ * 命中后只与唯一的候选动词比较一次以排除未知动词；字符常量与动词是否一致在 command_registry_init() 中自检
+ */
+
+#ifndef COMMAND_REGISTRY_H
+#define COMMAND_REGISTRY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "command.h"
+#include "tcp_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COMMAND_ARG_MAX     2   /**< 每条命令最多的参数个数 */
+
+/**
+ * @brief 参数格式：写入 command_t 中的位置、宽度和取值范围
+ * 
+ * 文本协议按表中顺序以空格分隔的十进制数给出，末尾的可选参数可以省略；
+ * 二进制帧按表中顺序以小端编码，所有参数都必须给出
+ */
+typedef struct {
+    uint8_t offset;             /**< 在 command_t 中的偏移（offsetof） */
+    uint8_t size;               /**< 字节数，1或2 */
+    bool optional;              /**< 文本协议中是否可省略 */
+    uint16_t min;               /**< 最小值 */
+    uint16_t max;               /**< 最大值 */
+    uint16_t def;               /**< 省略时的默认值 */
+} command_arg_spec_t;
+
+/**
+ * @brief 命令处理函数，与 command_callback_t 相同
+ */
+typedef command_result_t (*command_handler_fn_t)(const command_t *command, const tcp_request_ctx_t *ctx);
+
+/**
+ * @brief 命令声明
+ */
+typedef struct {
+    const char *name;           /**< 文本协议动词，NULL表示没有动词（旧协议数字命令） */
+    uint8_t name_len;           /**< 动词长度 */
+    uint8_t opcode;             /**< 二进制操作码，0表示不支持二进制帧 */
+    uint8_t arg_count;          /**< 参数个数 */
+    command_arg_spec_t args[COMMAND_ARG_MAX]; /**< 参数格式 */
+    command_perm_t perm;        /**< 所需权限 */
+    command_handler_fn_t handler; /**< 处理函数，NULL表示由传输层自行处理（如事件订阅） */
+} command_spec_t;
+
+/**
+ * @brief 自检注册表：每个动词和操作码都能查找回自己的命令类型，操作码表与命令表一致
+ * 
+ * 应在任何传输通道启动前调用，失败时说明表被改坏，调用方应中止启动
+ * 
+ * @return ESP_OK 一致；ESP_ERR_INVALID_STATE 不一致（详情见日志）
+ */
+esp_err_t command_registry_init(void);
+
+/**
+ * @brief 按命令类型获取声明
+ * @return 声明，类型非法时返回NULL
+ */
+const command_spec_t *command_registry_get(command_type_t type);
+
+/**
+ * @brief 按文本动词查找命令类型（区分大小写）
+ * @param word 动词，不要求以'\0'结尾
+ * @param len 动词长度
+ * @param type 输出命令类型
+ * @return true 找到
+ */
+bool command_registry_find_verb(const char *word, size_t len, command_type_t *type);
+
+/**
+ * @brief 按二进制操作码查找命令类型
+ * @return true 找到
+ */
+bool command_registry_find_opcode(uint8_t opcode, command_type_t *type);
+
+/**
+ * @brief 获取命令类型的二进制操作码，不支持二进制帧的命令返回0
+ */
+uint8_t command_registry_opcode(command_type_t type);
+
+/**
+ * @brief 解析文本协议的参数并写入命令（cmd->type 必须已设置）
+ * @param text 动词之后、请求ID之前的部分，可以有首尾空格
+ * @param len 长度
+ * @param cmd 命令
+ * @return true 参数个数和取值都合法
+ */
+bool command_registry_parse_text(const char *text, size_t len, command_t *cmd);
+
+/**
+ * @brief 解码二进制帧负载并写入命令（cmd->type 必须已设置）
+ * @return true 负载长度和取值都合法
+ */
+bool command_registry_decode_payload(const uint8_t *payload, size_t len, command_t *cmd);
+
+/**
+ * @brief 按声明检查命令参数的取值范围（用于REST/JSON等自行填充命令的通道）
+ * @return true 合法
+ */
+bool command_registry_validate(const command_t *cmd);
+
+/**
+ * @brief 获取所需权限不高于 perm 的全部命令集合（COMMAND_MASK位），用于配置端口的命令集合
+ */
+uint32_t command_registry_mask(command_perm_t perm);
+
+/**
+ * @brief 分发命令：检查权限和参数后调用声明中的处理函数
+ * 
+ * ctx->perm 低于命令所需权限时回复 COMMAND_RESULT_UNSUPPORTED，与端口命令集合之外的命令相同；
+ * 可以直接注册为各传输通道的命令回调
+ * 
+ * @param command 命令
+ * @param ctx 请求上下文
+ * @return 命令处理结果
+ */
+command_result_t command_registry_dispatch(const command_t *command, const tcp_request_ctx_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMMAND_REGISTRY_H
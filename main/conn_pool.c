@@ -0,0 +1,107 @@
+/**
+ * @file conn_pool.c
+ * @brief TCP连接槽位池实现
+ */
+
+#include "conn_pool.h"
+#include "freertos/task.h"
+#include <string.h>
+
+// 连接池（全部为静态存储）
+typedef struct {
+    conn_slot_t slots[CONN_POOL_SIZE];  // 槽位
+    conn_pool_stats_t stats;            // 统计
+} conn_pool_t;
+
+static conn_pool_t pool;
+
+void conn_pool_init(void)
+{
+    for (int i = 0; i < CONN_POOL_SIZE; i++) {
+        conn_slot_t *slot = &pool.slots[i];
+        slot->state = CONN_STATE_FREE;
+        slot->fd = -1;
+        slot->id = 0;
+        byte_ring_init(&slot->rx, slot->rx_storage, sizeof(slot->rx_storage));
+        byte_ring_init(&slot->tx, slot->tx_storage, sizeof(slot->tx_storage));
+    }
+    
+    memset(&pool.stats, 0, sizeof(pool.stats));
+    pool.stats.capacity = CONN_POOL_SIZE;
+}
+
+conn_slot_t *conn_pool_acquire(int fd, uint32_t id)
+{
+    conn_slot_t *slot = NULL;
+    for (int i = 0; i < CONN_POOL_SIZE; i++) {
+        if (pool.slots[i].state == CONN_STATE_FREE) {
+            slot = &pool.slots[i];
+            break;
+        }
+    }
+    
+    if (slot == NULL) {
+        pool.stats.rejected++;
+        return NULL;
+    }
+    
+    slot->fd = fd;
+    slot->id = id;
+    slot->inflight = 0;
+    slot->tls = NULL;
+    slot->handshaking = false;
+    slot->last_active = xTaskGetTickCount();
+    byte_ring_reset(&slot->rx);
+    byte_ring_reset(&slot->tx);
+    stream_parser_init(&slot->parser, STREAM_PARSER_FRAMING_MIXED);
+    slot->subscriber = false;
+    memset(&slot->stats, 0, sizeof(slot->stats));
+    slot->stats.opened_at = slot->last_active;
+    slot->state = CONN_STATE_OPEN;
+    
+    pool.stats.accepted++;
+    pool.stats.in_use++;
+    if (pool.stats.in_use > pool.stats.peak) {
+        pool.stats.peak = pool.stats.in_use;
+    }
+    
+    return slot;
+}
+
+void conn_pool_release(conn_slot_t *slot)
+{
+    if (slot->state == CONN_STATE_FREE) {
+        return;
+    }
+    
+    slot->state = CONN_STATE_FREE;
+    slot->fd = -1;
+    slot->id = 0;
+    
+    pool.stats.released++;
+    pool.stats.in_use--;
+}
+
+conn_slot_t *conn_pool_at(int index)
+{
+    return &pool.slots[index];
+}
+
+conn_slot_t *conn_pool_find(uint32_t id)
+{
+    if (id == 0) {
+        return NULL;
+    }
+    
+    for (int i = 0; i < CONN_POOL_SIZE; i++) {
+        if (pool.slots[i].state != CONN_STATE_FREE && pool.slots[i].id == id) {
+            return &pool.slots[i];
+        }
+    }
+    return NULL;
+}
+
+void conn_pool_get_stats(conn_pool_stats_t *stats)
+{
+    *stats = pool.stats;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file conn_pool.h
+ * @brief TCP连接槽位池头文件
+ * 
+ * 编译期确定大小的连接槽位池，每个槽位自带预分配的接收/发送环形缓冲区、
+ * 连接状态和统计信息。建立和关闭明文连接都不分配或释放堆内存，
+ * 反复建立和断开连接不会造成DRAM碎片（TLS连接的会话由mbedTLS在堆上分配，见 tls_session.h）
+ * 
+ * 槽位状态:
+ * 
+ *   FREE --acquire--> OPEN --(对端关闭/需要断开)--> DRAINING --(发送缓冲区清空)--> FREE
+ *                      |                                                         ^
+ *                      +---------------------(出错/超时)--------------------------+
+ *                      |                                                         |
+ *                      +--(发送积压超限/发送出错)--> ABORTING --(本轮事件循环结束)--+
+ */
+
+#ifndef CONN_POOL_H
+#define CONN_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "byte_ring.h"
+#include "stream_parser.h"
+#include "socket_budget.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 槽位数量 CONN_POOL_SIZE 由 socket_budget.h 按lwIP的socket总数扣除其他模块的占用得出
+
+struct esp_tls;
+
+#define CONN_POOL_RX_SIZE       64      /**< 每个槽位的接收环形缓冲区大小（2的幂） */
+#define CONN_POOL_TX_SIZE       512     /**< 每个槽位的发送环形缓冲区大小（2的幂） */
+
+_Static_assert((CONN_POOL_RX_SIZE & (CONN_POOL_RX_SIZE - 1)) == 0, "RX ring size must be a power of two");
+_Static_assert((CONN_POOL_TX_SIZE & (CONN_POOL_TX_SIZE - 1)) == 0, "TX ring size must be a power of two");
+
+/**
+ * @brief 槽位状态
+ */
+typedef enum {
+    CONN_STATE_FREE = 0,        /**< 空闲 */
+    CONN_STATE_OPEN,            /**< 连接正常收发 */
+    CONN_STATE_DRAINING,        /**< 不再接收，发送完缓冲区中的数据后关闭 */
+    CONN_STATE_ABORTING,        /**< 发送积压超限或发送出错，服务器任务在本轮事件循环结束时关闭 */
+} conn_state_t;
+
+/**
+ * @brief 单个连接的统计
+ */
+typedef struct {
+    uint32_t rx_bytes;          /**< 接收字节数 */
+    uint32_t tx_bytes;          /**< 发送字节数 */
+    uint32_t commands;          /**< 分发的命令数 */
+    uint32_t shed;              /**< 被限流拒绝的命令数 */
+    uint16_t tx_peak;           /**< 发送缓冲区的最大积压字节数 */
+    TickType_t opened_at;       /**< 建立连接的时间 */
+} conn_stats_t;
+
+/**
+ * @brief 连接槽位
+ */
+typedef struct {
+    conn_state_t state;                     /**< 槽位状态 */
+    int fd;                                 /**< socket描述符，-1表示空闲 */
+    uint32_t id;                            /**< 连接ID，每个新连接递增 */
+    char ip[16];                            /**< 客户端IP */
+    uint32_t addr;                          /**< 客户端IP（网络字节序），用于限流 */
+    uint16_t port;                          /**< 客户端端口 */
+    struct esp_tls *tls;                    /**< TLS会话，NULL表示明文连接 */
+    bool handshaking;                       /**< TLS握手尚未完成 */
+    uint8_t inflight;                       /**< 未完成的命令数 */
+    TickType_t last_active;                 /**< 最后一次收到数据的时间 */
+    byte_ring_t rx;                         /**< 接收环形缓冲区 */
+    byte_ring_t tx;                         /**< 发送环形缓冲区 */
+    stream_parser_t parser;                 /**< 请求分帧器（保存跨TCP段未收完的请求） */
+    bool subscriber;                        /**< 已订阅事件流 */
+    uint32_t event_cursor;                  /**< 事件流读取位置 */
+    conn_stats_t stats;                     /**< 连接统计 */
+    uint8_t rx_storage[CONN_POOL_RX_SIZE];  /**< 接收缓冲区存储 */
+    uint8_t tx_storage[CONN_POOL_TX_SIZE];  /**< 发送缓冲区存储 */
+} conn_slot_t;
+
+/**
+ * @brief 连接池统计
+ */
+typedef struct {
+    uint16_t capacity;          /**< 槽位总数 */
+    uint16_t in_use;            /**< 使用中的槽位数 */
+    uint16_t peak;              /**< 同时使用的最大槽位数 */
+    uint32_t accepted;          /**< 累计分配次数 */
+    uint32_t rejected;          /**< 槽位用尽而被拒绝的连接数 */
+    uint32_t released;          /**< 累计释放次数 */
+} conn_pool_stats_t;
+
+/**
+ * @brief 初始化连接池，所有槽位置为空闲
+ */
+void conn_pool_init(void);
+
+/**
+ * @brief 分配槽位并初始化缓冲区、协议状态和统计
+ * @param fd socket描述符
+ * @param id 连接ID
+ * @return 槽位，NULL表示槽位已用尽
+ */
+conn_slot_t *conn_pool_acquire(int fd, uint32_t id);
+
+/**
+ * @brief 释放槽位（不关闭socket）
+ */
+void conn_pool_release(conn_slot_t *slot);
+
+/**
+ * @brief 按下标获取槽位（用于遍历，包括空闲槽位）
+ */
+conn_slot_t *conn_pool_at(int index);
+
+/**
+ * @brief 按连接ID查找使用中的槽位
+ * @return 槽位，NULL表示连接不存在
+ */
+conn_slot_t *conn_pool_find(uint32_t id);
+
+/**
+ * @brief 获取连接池统计
+ */
+void conn_pool_get_stats(conn_pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONN_POOL_H
@@ -0,0 +1,151 @@
+/**
+ * @file event_stream.c
+ * @brief 状态事件广播环形缓冲区实现
+ */
+
+#include "event_stream.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+
+// 环形缓冲区槽位
+typedef struct {
+    uint8_t len;                            // 事件长度
+    char data[EVENT_STREAM_EVENT_MAX_LEN];  // 序列化后的事件
+} event_slot_t;
+
+// 事件流状态
+typedef struct {
+    portMUX_TYPE lock;                              // 保护环形缓冲区
+    uint32_t head;                                  // 下一个事件序号
+    event_slot_t ring[EVENT_STREAM_RING_SIZE];      // 环形缓冲区
+    event_listener_t listeners[EVENT_STREAM_MAX_LISTENERS]; // 新事件通知回调
+} event_stream_state_t;
+
+static event_stream_state_t stream_state = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+    .head = 0,
+};
+
+/**
+ * @brief 序列化事件正文（不含序号前缀）
+ */
+static int event_format(char *buf, size_t size, event_type_t type, int32_t arg0, int32_t arg1)
+{
+    switch (type) {
+        case EVENT_COMMAND_ACCEPTED:
+            return snprintf(buf, size, "ACCEPTED angle=%d pending=%d\n", (int)arg0, (int)arg1);
+        case EVENT_MOTION_STARTED:
+            return snprintf(buf, size, "MOTION_START angle=%d\n", (int)arg0);
+        case EVENT_MOTION_FINISHED:
+            return snprintf(buf, size, "MOTION_DONE angle=%d result=%d\n", (int)arg0, (int)arg1);
+        case EVENT_WIFI_STATE:
+            return snprintf(buf, size, "WIFI %s\n", arg0 ? "up" : "down");
+        case EVENT_ERROR:
+        default:
+            return snprintf(buf, size, "ERROR code=0x%x\n", (unsigned)arg0);
+    }
+}
+
+/**
+ * @brief 写入序号前缀 "!<seq> "，在临界区中调用，不使用snprintf
+ * @return 写入的字节数
+ */
+static size_t event_write_prefix(char *buf, uint32_t seq)
+{
+    char digits[10];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + seq % 10);
+        seq /= 10;
+    } while (seq > 0);
+    
+    size_t len = 0;
+    buf[len++] = '!';
+    while (n > 0) {
+        buf[len++] = digits[--n];
+    }
+    buf[len++] = ' ';
+    return len;
+}
+
+void event_stream_publish(event_type_t type, int32_t arg0, int32_t arg1)
+{
+    // 序号前缀最长 "!4294967295 " 共12字节，正文在锁外序列化
+    char body[EVENT_STREAM_EVENT_MAX_LEN];
+    int body_len = event_format(body, sizeof(body), type, arg0, arg1);
+    if (body_len < 0) {
+        body_len = 0;
+    } else if (body_len >= (int)sizeof(body)) {
+        body_len = sizeof(body) - 1;
+    }
+    
+    // 占用序号和写入槽位在同一个临界区内完成，读者不会看到写了一半或空的槽位
+    portENTER_CRITICAL(&stream_state.lock);
+    uint32_t seq = stream_state.head;
+    event_slot_t *slot = &stream_state.ring[seq & (EVENT_STREAM_RING_SIZE - 1)];
+    size_t len = event_write_prefix(slot->data, seq);
+    size_t copy = body_len;
+    if (copy > EVENT_STREAM_EVENT_MAX_LEN - 1 - len) {
+        copy = EVENT_STREAM_EVENT_MAX_LEN - 1 - len;
+    }
+    memcpy(slot->data + len, body, copy);
+    len += copy;
+    slot->data[len - 1] = '\n';
+    slot->len = len;
+    stream_state.head = seq + 1;
+    portEXIT_CRITICAL(&stream_state.lock);
+    
+    for (int i = 0; i < EVENT_STREAM_MAX_LISTENERS; i++) {
+        if (stream_state.listeners[i]) {
+            stream_state.listeners[i]();
+        }
+    }
+}
+
+uint32_t event_stream_head(void)
+{
+    portENTER_CRITICAL(&stream_state.lock);
+    uint32_t head = stream_state.head;
+    portEXIT_CRITICAL(&stream_state.lock);
+    return head;
+}
+
+size_t event_stream_read(uint32_t *cursor, char *buf, uint32_t *missed)
+{
+    size_t len = 0;
+    *missed = 0;
+    
+    portENTER_CRITICAL(&stream_state.lock);
+    
+    uint32_t head = stream_state.head;
+    
+    // 落后超过缓冲区容量，跳到最旧的可用事件
+    if (head - *cursor > EVENT_STREAM_RING_SIZE) {
+        *missed = head - EVENT_STREAM_RING_SIZE - *cursor;
+        *cursor = head - EVENT_STREAM_RING_SIZE;
+    }
+    
+    // head 之前的槽位都已写完
+    if (*cursor != head) {
+        event_slot_t *slot = &stream_state.ring[*cursor & (EVENT_STREAM_RING_SIZE - 1)];
+        len = slot->len;
+        memcpy(buf, slot->data, len);
+        (*cursor)++;
+    }
+    
+    portEXIT_CRITICAL(&stream_state.lock);
+    
+    return len;
+}
+
+esp_err_t event_stream_add_listener(event_listener_t listener)
+{
+    for (int i = 0; i < EVENT_STREAM_MAX_LISTENERS; i++) {
+        if (stream_state.listeners[i] == NULL || stream_state.listeners[i] == listener) {
+            stream_state.listeners[i] = listener;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file event_stream.h
+ * @brief 状态事件广播环形缓冲区头文件
+ * 
+ * 事件在发布时序列化一次写入环形缓冲区，所有订阅者各自维护读取位置，
+ * 发布者从不等待订阅者。订阅者落后超过缓冲区容量时会被告知丢失的事件数
+ * 
+ * 事件格式（一行文本）: "!<seq> <TYPE> <参数>\n"
+ */
+
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_STREAM_RING_SIZE      32  /**< 环形缓冲区事件数（必须为2的幂） */
+#define EVENT_STREAM_EVENT_MAX_LEN  64  /**< 单个事件序列化后的最大长度 */
+#define EVENT_STREAM_MAX_LISTENERS  4   /**< 新事件通知回调的最大数量 */
+
+/**
+ * @brief 事件类型
+ */
+typedef enum {
+    EVENT_COMMAND_ACCEPTED,     /**< 命令已接受: arg0=角度, arg1=队列中命令数 */
+    EVENT_MOTION_STARTED,       /**< 开始动作: arg0=角度 */
+    EVENT_MOTION_FINISHED,      /**< 动作完成: arg0=角度, arg1=esp_err_t结果 */
+    EVENT_WIFI_STATE,           /**< WiFi状态变化: arg0=1已连接/0已断开 */
+    EVENT_ERROR,                /**< 错误: arg0=esp_err_t错误码 */
+} event_type_t;
+
+/**
+ * @brief 新事件通知回调，在发布者的任务中调用，不得阻塞
+ */
+typedef void (*event_listener_t)(void);
+
+/**
+ * @brief 发布事件（可在任意任务中调用，不阻塞）
+ * @param type 事件类型
+ * @param arg0 参数0
+ * @param arg1 参数1
+ */
+void event_stream_publish(event_type_t type, int32_t arg0, int32_t arg1);
+
+/**
+ * @brief 获取下一个事件的序号，新订阅者从该位置开始读取
+ */
+uint32_t event_stream_head(void);
+
+/**
+ * @brief 读取订阅者的下一个事件
+ * 
+ * @param cursor 订阅者读取位置，成功读取后递增
+ * @param buf 输出缓冲区，至少 EVENT_STREAM_EVENT_MAX_LEN 字节
+ * @param missed 输出因落后而丢失的事件数
+ * @return 事件长度，0表示没有新事件
+ */
+size_t event_stream_read(uint32_t *cursor, char *buf, uint32_t *missed);
+
+/**
+ * @brief 注册新事件通知回调
+ * @param listener 回调函数
+ * @return ESP_OK 成功，ESP_ERR_NO_MEM 回调数量已满
+ */
+esp_err_t event_stream_add_listener(event_listener_t listener);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_STREAM_H
@@ -0,0 +1,106 @@
+/**
+ * @file line_protocol.c
+ * @brief 标签行协议解析实现
+ */
+
+#include "line_protocol.h"
+#include "command_registry.h"
+#include <ctype.h>
+#include <string.h>
+
+bool line_protocol_is_tag_char(char c)
+{
+    return isalnum((unsigned char)c) || c == '_' || c == '-' || c == '.';
+}
+
+line_protocol_result_t line_protocol_parse(const char *line, size_t len, char *tag, command_t *cmd)
+{
+    size_t pos = 0;
+    size_t tag_len = 0;
+    
+    cmd->request_id[0] = '\0';
+    
+    // 解析标签
+    while (pos < len && line_protocol_is_tag_char(line[pos])) {
+        if (tag_len < LINE_PROTOCOL_TAG_MAX_LEN) {
+            tag[tag_len] = line[pos];
+        }
+        tag_len++;
+        pos++;
+    }
+    
+    if (tag_len == 0 || tag_len > LINE_PROTOCOL_TAG_MAX_LEN ||
+        (pos < len && line[pos] != ' ')) {
+        tag[0] = '\0';
+        return LINE_PROTOCOL_BAD_TAG;
+    }
+    tag[tag_len] = '\0';
+    
+    // 解析命令，允许前后有空格
+    while (pos < len && line[pos] == ' ') {
+        pos++;
+    }
+    size_t start = pos;
+    while (pos < len && line[pos] != ' ') {
+        pos++;
+    }
+    size_t word_len = pos - start;
+    
+    // 参数：动词之后到请求ID或行尾之间的部分，由注册表按参数格式解析
+    size_t args_start = pos;
+    size_t args_end = pos;
+    while (pos < len) {
+        while (pos < len && line[pos] == ' ') {
+            pos++;
+        }
+        if (pos + 3 <= len && memcmp(line + pos, "id=", 3) == 0) {
+            break;
+        }
+        while (pos < len && line[pos] != ' ') {
+            pos++;
+        }
+        args_end = pos;
+    }
+    
+    // 可选的请求ID: "id=<rid>"
+    if (pos + 3 <= len && memcmp(line + pos, "id=", 3) == 0) {
+        pos += 3;
+        size_t id_len = 0;
+        while (pos < len && line_protocol_is_tag_char(line[pos])) {
+            if (id_len < COMMAND_REQUEST_ID_MAX_LEN) {
+                cmd->request_id[id_len] = line[pos];
+            }
+            id_len++;
+            pos++;
+        }
+        if (id_len == 0 || id_len > COMMAND_REQUEST_ID_MAX_LEN) {
+            cmd->request_id[0] = '\0';
+            return LINE_PROTOCOL_BAD_COMMAND;
+        }
+        cmd->request_id[id_len] = '\0';
+        while (pos < len && line[pos] == ' ') {
+            pos++;
+        }
+    }
+    
+    if (word_len == 0 || pos != len) {
+        return LINE_PROTOCOL_BAD_COMMAND;
+    }
+    
+    const char *word = line + start;
+    if (word_len == 1 && word[0] >= '0' && word[0] <= '9' && args_end == args_start) {
+        cmd->type = COMMAND_TYPE_DIGIT;
+        cmd->args.digit.index = word[0] - '0';
+        return LINE_PROTOCOL_OK;
+    }
+    
+    command_type_t type;
+    if (!command_registry_find_verb(word, word_len, &type)) {
+        return LINE_PROTOCOL_BAD_COMMAND;
+    }
+    cmd->type = type;
+    if (!command_registry_parse_text(line + args_start, args_end - args_start, cmd)) {
+        return LINE_PROTOCOL_BAD_COMMAND;
+    }
+    return LINE_PROTOCOL_OK;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file line_protocol.h
+ * @brief 标签行协议解析头文件
+ * 
+ * 解析 "#<tag> <cmd>[ <参数>...][ id=<rid>]" 格式的请求，TCP和UDP控制通道共用。
+ * cmd为单个数字'0'-'9'，或注册表（command_registry.h）中的动词，如 STATUS、FEED 0 2、ANGLE 90 500、
+ * SCHEDULE 3600、STOP、SUBSCRIBE；参数为十进制数，个数和范围由注册表中的声明决定；
+ * 可选的请求ID rid 与标签使用相同的字符集，重试同一个rid不会重复执行动作
+ */
+
+#ifndef LINE_PROTOCOL_H
+#define LINE_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "command.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LINE_PROTOCOL_PREFIX       '#' /**< 标签请求起始字符 */
+#define LINE_PROTOCOL_TAG_MAX_LEN  15  /**< 标签最大长度 */
+
+/**
+ * @brief 解析结果
+ */
+typedef enum {
+    LINE_PROTOCOL_OK,           /**< 解析成功 */
+    LINE_PROTOCOL_BAD_TAG,      /**< 标签缺失或非法 */
+    LINE_PROTOCOL_BAD_COMMAND,  /**< 命令缺失或非法 */
+} line_protocol_result_t;
+
+/**
+ * @brief 检查字符是否可用于标签（字母、数字、'_'、'-'、'.'）
+ */
+bool line_protocol_is_tag_char(char c);
+
+/**
+ * @brief 解析一条标签请求
+ * 
+ * @param line 请求内容，不含行首的'#'和行尾换行符
+ * @param len 请求长度
+ * @param tag 输出标签，至少 LINE_PROTOCOL_TAG_MAX_LEN + 1 字节；
+ *            返回 LINE_PROTOCOL_BAD_COMMAND 时也会填充
+ * @param cmd 输出命令（含可选的请求ID）
+ * @return 解析结果
+ */
+line_protocol_result_t line_protocol_parse(const char *line, size_t len, char *tag, command_t *cmd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LINE_PROTOCOL_H
@@ -16,59 +16,27 @@
 #include "sg90_servo.h"
 #include "wifi_config.h"
 #include "tcp_server.h"
+#include "udp_server.h"
+#include "tcp_listener.h"
+#include "ws_server.h"
+#include "rest_api.h"
+#include "mqtt_control.h"
+#include "actuator.h"
+#include "event_stream.h"
+#include "request_cache.h"
+#include "command_registry.h"
+#include "command_handlers.h"
 
 static const char *TAG = "MAIN";
 
 // 舵机配置
 #define SERVO_SIGNAL_PIN    GPIO_NUM_17
+#define SERVO_IDLE_DETACH_MS 2000   // 静止2秒后断开舵机信号（长于默认的保持复位时间）
 #define TCP_SERVER_PORT     8080
-
-// 全局舵机配置指针
-static sg90_config_t *g_servo_config = NULL;
-
-// 舵机角度映射表 (命令0-9对应角度)
-static const uint8_t command_angle_map[10] = {
-    0,    // 命令'0' -> 0°
-    18,   // 命令'1' -> 18°
-    36,   // 命令'2' -> 36°
-    54,   // 命令'3' -> 54°
-    72,   // 命令'4' -> 72°
-    90,   // 命令'5' -> 90°
-    108,  // 命令'6' -> 108°
-    126,  // 命令'7' -> 126°
-    144,  // 命令'8' -> 144°
-    180   // 命令'9' -> 180°
-};
-
-/**
- * @brief 命令处理回调函数
- */
-static void command_handler(char command, int client_fd)
-{
-    if (command < '0' || command > '9') {
-        return;
-    }
-    
-    uint8_t angle = command_angle_map[command - '0'];
-    
-    ESP_LOGI(TAG, "收到命令: %c -> 角度: %d°", command, angle);
-    
-    // 控制舵机转动
-    if (g_servo_config != NULL) {
-        // 设置目标角度，1秒后自动复位到0°
-        sg90_set_angle_with_reset(g_servo_config, angle, 1000);
-        ESP_LOGI(TAG, "舵机已转动到 %d°，1秒后将自动复位", angle);
-        
-        // 发送响应
-        char response[64];
-        snprintf(response, sizeof(response), "OK: Command %c -> Angle %d° (auto reset in 1s)\n", command, angle);
-        tcp_server_send_response(client_fd, response);
-    } else {
-        char response[64];
-        snprintf(response, sizeof(response), "ERROR: Servo not initialized\n");
-        tcp_server_send_response(client_fd, response);
-    }
-}
+#define UDP_SERVER_PORT     8081
+#define STATUS_LISTENER_PORT 8082
+#define WS_SERVER_PORT      80
+#define TLS_SERVER_PORT     8443
 
 /**
  * @brief 舵机控制任务
@@ -86,13 +54,20 @@ void servo_control_task(void *pvParameters)
         .generator = NULL,
         .min_pulse_width_us = 500.0f,   // 0.5ms for 0°
         .max_pulse_width_us = 2500.0f,  // 2.5ms for 180°
+        .idle_detach_ms = SERVO_IDLE_DETACH_MS,
     };
     
-    g_servo_config = &servo_config;
+    command_handlers_set_servo(&servo_config);
+    
+    // 自检命令注册表，表被改坏时中止启动
+    ESP_ERROR_CHECK(command_registry_init());
     
     // 初始化舵机
     ESP_ERROR_CHECK(sg90_init(&servo_config));
     
+    // 启动执行器任务，舵机动作均在该任务中完成
+    ESP_ERROR_CHECK(actuator_init(&servo_config));
+    
     // 延时等待舵机稳定
     vTaskDelay(pdMS_TO_TICKS(1000));
     
@@ -109,12 +84,62 @@ void servo_control_task(void *pvParameters)
     ESP_LOGI(TAG, "初始化TCP服务器，端口: %d", TCP_SERVER_PORT);
     ESP_ERROR_CHECK(tcp_server_init(TCP_SERVER_PORT));
     
+    // 服务器选项：合并同一批命令的响应，并关闭Nagle算法；命令端口任务绑定核心0
+    tcp_server_options_t server_options = TCP_SERVER_DEFAULT_OPTIONS();
+    server_options.core_id = 0;
+    ESP_ERROR_CHECK(tcp_server_set_options(&server_options));
+    
+#ifdef TLS_SERVER_ENABLED
+    // 可选：TLS控制端口，与明文端口共用命令协议（编译时 main/certs/ 下有证书和私钥时启用）
+    if (tcp_server_enable_tls(TLS_SERVER_PORT) != ESP_OK) {
+        ESP_LOGW(TAG, "TLS端口启用失败，只提供明文端口");
+    }
+#endif
+    
     // 注册命令回调
-    tcp_server_register_command_callback(command_handler);
+    tcp_server_register_command_callback(command_registry_dispatch);
     
     // 启动TCP服务器
     ESP_ERROR_CHECK(tcp_server_start());
     
+    // 只读状态端口：更高优先级、绑定核心1，命令端口满载时健康检查仍能及时回复
+    tcp_listener_config_t status_config = TCP_LISTENER_STATUS_CONFIG(STATUS_LISTENER_PORT);
+    status_config.command_mask = command_registry_mask(status_config.perm);
+    if (tcp_listener_start(&status_config, command_registry_dispatch) != ESP_OK) {
+        ESP_LOGW(TAG, "状态端口启动失败，状态查询只能经由命令端口");
+    }
+    
+    // 启动UDP控制通道，与TCP共用命令回调
+    ESP_LOGI(TAG, "初始化UDP控制通道，端口: %d", UDP_SERVER_PORT);
+    ESP_ERROR_CHECK(udp_server_init(UDP_SERVER_PORT));
+    udp_server_register_command_callback(command_registry_dispatch);
+    ESP_ERROR_CHECK(udp_server_start());
+    
+    // 启动WebSocket服务器，供浏览器控制面板使用
+    ESP_LOGI(TAG, "初始化WebSocket服务器，端口: %d", WS_SERVER_PORT);
+    ESP_ERROR_CHECK(ws_server_init(WS_SERVER_PORT));
+    ws_server_register_command_callback(command_registry_dispatch);
+    ESP_ERROR_CHECK(ws_server_start());
+    
+    // REST API与WebSocket共用同一个HTTP服务器
+    ESP_ERROR_CHECK(rest_api_register(ws_server_get_handle(), command_registry_dispatch));
+    
+#ifdef MQTT_BROKER_URI
+    // 可选：连接MQTT服务器，接收设备和分组命令
+    mqtt_control_config_t mqtt_config = {
+        .broker_uri = MQTT_BROKER_URI,
+#ifdef MQTT_DEVICE_ID
+        .device_id = MQTT_DEVICE_ID,
+#endif
+#ifdef MQTT_GROUP
+        .group = MQTT_GROUP,
+#endif
+    };
+    ESP_ERROR_CHECK(mqtt_control_init(&mqtt_config));
+    mqtt_control_register_command_callback(command_registry_dispatch);
+    ESP_ERROR_CHECK(mqtt_control_start());
+#endif
+    
     const char* ip_addr = wifi_get_ip_address();
     ESP_LOGI(TAG, "=================================================");
     ESP_LOGI(TAG, "SmartFishFeeder 服务已就绪");
@@ -123,14 +148,21 @@ void servo_control_task(void *pvParameters)
         ESP_LOGI(TAG, "IP地址: %s", ip_addr);
     }
     ESP_LOGI(TAG, "TCP服务器端口: %d", TCP_SERVER_PORT);
+#ifdef TLS_SERVER_ENABLED
+    ESP_LOGI(TAG, "TLS端口: %d", TLS_SERVER_PORT);
+#endif
+    ESP_LOGI(TAG, "状态端口: %d（只读，\"#<tag> STATUS\"）", STATUS_LISTENER_PORT);
+    ESP_LOGI(TAG, "UDP控制端口: %d", UDP_SERVER_PORT);
+    ESP_LOGI(TAG, "WebSocket地址: ws://%s:%d/ws", ip_addr, WS_SERVER_PORT);
+    ESP_LOGI(TAG, "REST API地址: http://%s:%d/status", ip_addr, WS_SERVER_PORT);
     ESP_LOGI(TAG, "=================================================");
     ESP_LOGI(TAG, "发送命令 '0'-'9' 控制舵机角度 (0°-180°)");
+    ESP_LOGI(TAG, "或发送 \"#<tag> <0-9>\\n\" 使用带标签的流水线协议");
     
     // 延时等待TCP服务器启动
     vTaskDelay(pdMS_TO_TICKS(500));
     
-    // 默认转动到0°
-    sg90_set_angle(&servo_config, 0);
+    // sg90_init 已将舵机转到0°，这里不再直接设置角度，以免打断执行器中的平滑动作
     ESP_LOGI(TAG, "舵机初始角度: 0°");
     
     // 主循环 - 舵机控制
@@ -152,12 +184,14 @@ static void wifi_event_handler(void* handler_arg, esp_event_base_t event_base,
                 break;
             case WIFI_EVENT_STA_DISCONNECTED:
                 ESP_LOGW(TAG, "WiFi已断开连接");
+                event_stream_publish(EVENT_WIFI_STATE, 0, 0);
                 break;
         }
     } else if (strcmp(event_base, IP_EVENT) == 0) {
         switch (event_id) {
             case IP_EVENT_STA_GOT_IP:
                 ESP_LOGI(TAG, "获取到IP地址，可以访问TCP服务器了");
+                event_stream_publish(EVENT_WIFI_STATE, 1, 0);
                 break;
         }
     }
@@ -174,6 +208,12 @@ void app_main(void)
     ESP_LOGI(TAG, "功能: WiFi连接 + TCP网络控制");
     ESP_LOGI(TAG, "=================================================");
     
+    // 请求ID去重缓存，必须在任何控制通道启动之前初始化
+    request_cache_init();
+    
+    // 命令处理（延时投喂定时器）
+    ESP_ERROR_CHECK(command_handlers_init());
+    
     // 注册WiFi事件回调
     wifi_register_event_callback(wifi_event_handler, NULL);
     
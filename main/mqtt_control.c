@@ -0,0 +1,477 @@
+/**
+ * @file mqtt_control.c
+ * @brief MQTT控制通道实现
+ * 
+ * 命令在MQTT客户端任务中解析并分发给与TCP服务器共用的命令回调，回复合并后以QoS1发布。
+ * 状态发布任务在收到新事件后等待一个聚合窗口，把窗口内的全部事件合并为一条QoS1消息；
+ * 没有事件时按固定周期发布一次状态
+ */
+
+#include "mqtt_control.h"
+#include "line_protocol.h"
+#include "binary_protocol.h"
+#include "event_stream.h"
+#include "command_handlers.h"
+#include "command_admission.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "mqtt_client.h"
+#include <string.h>
+#include <stdio.h>
+
+static const char *TAG = "MQTT_CONTROL";
+
+#define MQTT_CONTROL_TOPIC_MAX      64      // 主题最大长度
+#define MQTT_CONTROL_ID_MAX         24      // 设备ID最大长度
+#define MQTT_CONTROL_RX_MAX         512     // 单条命令消息最大长度
+#define MQTT_CONTROL_TX_MAX         512     // 单条回复/状态消息最大长度
+#define MQTT_CONTROL_QOS            1       // 命令订阅和发布的QoS
+#define MQTT_CONTROL_BATCH_MS       200     // 状态事件聚合窗口
+#define MQTT_CONTROL_TELEMETRY_MS   30000   // 定期状态发布周期
+#define MQTT_CONTROL_LAG_MAX_LEN    24      // 事件丢失提示的最大长度
+
+// 回复合并缓冲区
+typedef struct {
+    const char *topic;                  // 发布主题
+    char buf[MQTT_CONTROL_TX_MAX];      // 合并的消息
+    size_t len;                         // 已用长度
+} mqtt_batch_t;
+
+// MQTT控制通道状态
+typedef struct {
+    esp_mqtt_client_handle_t client;    // MQTT客户端句柄
+    volatile bool connected;            // 是否已连接服务器
+    volatile bool running;              // 状态发布任务运行状态
+    TaskHandle_t status_task;           // 状态发布任务句柄
+    command_callback_t callback;        // 命令回调函数
+    uint32_t event_cursor;              // 事件流读取位置
+    char device_id[MQTT_CONTROL_ID_MAX];            // 设备ID
+    char cmd_topic[MQTT_CONTROL_TOPIC_MAX];         // 设备命令主题
+    char group_topic[MQTT_CONTROL_TOPIC_MAX];       // 分组命令主题
+    char reply_topic[MQTT_CONTROL_TOPIC_MAX];       // 回复主题
+    char status_topic[MQTT_CONTROL_TOPIC_MAX];      // 状态主题
+    char online_topic[MQTT_CONTROL_TOPIC_MAX];      // 在线状态主题
+    mqtt_batch_t reply_batch;           // 命令回复缓冲区（只在MQTT客户端任务中使用）
+    mqtt_batch_t status_batch;          // 状态缓冲区（只在状态发布任务中使用）
+} mqtt_control_state_t;
+
+static mqtt_control_state_t mqtt_state = {
+    .client = NULL,
+    .connected = false,
+    .running = false,
+    .status_task = NULL,
+    .callback = NULL,
+};
+
+/**
+ * @brief 以QoS1发布合并缓冲区中的消息
+ * 
+ * 使用非阻塞的入队接口，实际发送和重传由MQTT客户端任务完成
+ */
+static void batch_flush(mqtt_batch_t *batch)
+{
+    if (batch->len == 0) {
+        return;
+    }
+    
+    if (mqtt_state.connected) {
+        int msg_id = esp_mqtt_client_enqueue(mqtt_state.client, batch->topic, batch->buf, batch->len,
+                                             MQTT_CONTROL_QOS, 0, true);
+        if (msg_id < 0) {
+            ESP_LOGW(TAG, "发布失败: %s (长度: %u)", batch->topic, (unsigned)batch->len);
+        }
+    }
+    batch->len = 0;
+}
+
+/**
+ * @brief 追加数据到合并缓冲区，放不下时先发布已有内容
+ */
+static int batch_write(mqtt_batch_t *batch, const void *data, size_t len)
+{
+    if (batch->len + len > sizeof(batch->buf)) {
+        batch_flush(batch);
+    }
+    if (len > sizeof(batch->buf)) {
+        return -1;
+    }
+    
+    memcpy(batch->buf + batch->len, data, len);
+    batch->len += len;
+    return len;
+}
+
+/**
+ * @brief 命令回调的回复函数
+ */
+static int mqtt_reply(const tcp_request_ctx_t *ctx, const void *data, size_t len)
+{
+    return batch_write(ctx->transport, data, len);
+}
+
+/**
+ * @brief 分发命令
+ * 
+ * MQTT请求不支持异步完成回复（conn_id为0），动作完成通过状态主题通知
+ */
+static void dispatch_command(mqtt_batch_t *batch, const command_t *cmd, const char *tag,
+                             tcp_reply_format_t format, uint16_t seq)
+{
+    if (mqtt_state.callback == NULL) {
+        return;
+    }
+    
+    tcp_request_ctx_t ctx = {
+        .client_fd = -1,
+        .conn_id = 0,
+        .format = format,
+        .seq = seq,
+        .reply = mqtt_reply,
+        .transport = batch,
+        .perm = COMMAND_PERM_ADMIN,
+    };
+    strncpy(ctx.tag, tag, TCP_SERVER_TAG_MAX_LEN);
+    ctx.tag[TCP_SERVER_TAG_MAX_LEN] = '\0';
+    
+    // 命令都经服务器转发，没有来源IP，只受全局令牌桶限制
+    if (!command_admit(cmd, &ctx, COMMAND_ADMISSION_ADDR_NONE)) {
+        return;
+    }
+    mqtt_state.callback(cmd, &ctx);
+}
+
+/**
+ * @brief 处理一行文本命令 "#<tag> <cmd>"
+ */
+static void handle_text_line(mqtt_batch_t *batch, const char *line, size_t len)
+{
+    char tag[LINE_PROTOCOL_TAG_MAX_LEN + 1];
+    char response[LINE_PROTOCOL_TAG_MAX_LEN + 32];
+    command_t cmd;
+    
+    if (len == 0) {
+        return;
+    }
+    
+    // MQTT消息可能来自多个控制端，必须带标签才能对应回复
+    if (line[0] != LINE_PROTOCOL_PREFIX) {
+        batch_write(batch, "#? ERROR request-id-required\n", strlen("#? ERROR request-id-required\n"));
+        return;
+    }
+    
+    line_protocol_result_t result = line_protocol_parse(line + 1, len - 1, tag, &cmd);
+    if (result == LINE_PROTOCOL_BAD_TAG) {
+        batch_write(batch, "#? ERROR bad-tag\n", strlen("#? ERROR bad-tag\n"));
+        return;
+    }
+    if (result != LINE_PROTOCOL_OK ||
+        cmd.type == COMMAND_TYPE_SUBSCRIBE || cmd.type == COMMAND_TYPE_UNSUBSCRIBE) {
+        // 事件始终发布到状态主题，不需要订阅命令
+        int n = snprintf(response, sizeof(response), "#%s ERROR bad-command\n", tag);
+        batch_write(batch, response, n);
+        return;
+    }
+    
+    dispatch_command(batch, &cmd, tag, TCP_REPLY_FORMAT_TEXT, 0);
+}
+
+/**
+ * @brief 处理一条命令消息
+ */
+static void handle_command_message(const char *data, size_t len)
+{
+    mqtt_batch_t *batch = &mqtt_state.reply_batch;
+    batch->len = 0;
+    
+    if (len > 0 && (uint8_t)data[0] == BINARY_PROTOCOL_SOF) {
+        size_t pos = 0;
+        while (pos < len) {
+            command_t cmd;
+            binary_frame_info_t info;
+            binary_parse_result_t result = binary_protocol_parse((const uint8_t *)data + pos, len - pos,
+                                                                 &cmd, &info);
+            if (result == BINARY_PARSE_NEED_MORE || result == BINARY_PARSE_BAD_FRAME) {
+                ESP_LOGW(TAG, "丢弃不完整的二进制帧 (剩余长度: %u)", (unsigned)(len - pos));
+                break;
+            }
+            if (result == BINARY_PARSE_OK) {
+                dispatch_command(batch, &cmd, "", TCP_REPLY_FORMAT_BINARY, info.seq);
+            } else {
+                uint8_t reply[BINARY_PROTOCOL_MAX_FRAME];
+                size_t n = binary_protocol_encode_reply(reply, sizeof(reply), info.opcode, info.seq,
+                                                        result == BINARY_PARSE_BAD_CRC ?
+                                                        COMMAND_RESULT_BAD_CRC : COMMAND_RESULT_BAD_REQUEST,
+                                                        NULL, 0);
+                batch_write(batch, reply, n);
+            }
+            pos += info.frame_len;
+        }
+    } else {
+        size_t start = 0;
+        for (size_t i = 0; i <= len; i++) {
+            if (i == len || data[i] == '\n' || data[i] == '\r') {
+                handle_text_line(batch, data + start, i - start);
+                start = i + 1;
+            }
+        }
+    }
+    
+    // 同一条消息的所有回复合并为一条消息发布
+    batch_flush(batch);
+}
+
+/**
+ * @brief 检查主题是否为命令主题
+ */
+static bool is_command_topic(const char *topic, int topic_len)
+{
+    return (topic_len == (int)strlen(mqtt_state.cmd_topic) &&
+            memcmp(topic, mqtt_state.cmd_topic, topic_len) == 0) ||
+           (topic_len == (int)strlen(mqtt_state.group_topic) &&
+            memcmp(topic, mqtt_state.group_topic, topic_len) == 0);
+}
+
+/**
+ * @brief MQTT事件处理（在MQTT客户端任务中调用）
+ */
+static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    esp_mqtt_event_handle_t event = event_data;
+    
+    switch ((esp_mqtt_event_id_t)event_id) {
+        case MQTT_EVENT_CONNECTED:
+            ESP_LOGI(TAG, "已连接MQTT服务器");
+            mqtt_state.connected = true;
+            esp_mqtt_client_subscribe(mqtt_state.client, mqtt_state.cmd_topic, MQTT_CONTROL_QOS);
+            esp_mqtt_client_subscribe(mqtt_state.client, mqtt_state.group_topic, MQTT_CONTROL_QOS);
+            esp_mqtt_client_enqueue(mqtt_state.client, mqtt_state.online_topic, "1", 1, MQTT_CONTROL_QOS, 1, true);
+            // 立即发布一次状态
+            if (mqtt_state.status_task) {
+                xTaskNotifyGive(mqtt_state.status_task);
+            }
+            break;
+            
+        case MQTT_EVENT_DISCONNECTED:
+            ESP_LOGW(TAG, "与MQTT服务器断开连接");
+            mqtt_state.connected = false;
+            break;
+            
+        case MQTT_EVENT_DATA:
+            if (!is_command_topic(event->topic, event->topic_len)) {
+                break;
+            }
+            // 分片到达的超长消息直接丢弃
+            if (event->total_data_len != event->data_len || event->data_len > MQTT_CONTROL_RX_MAX) {
+                if (event->current_data_offset == 0) {
+                    ESP_LOGW(TAG, "命令消息过长，丢弃 (长度: %d)", event->total_data_len);
+                }
+                break;
+            }
+            handle_command_message(event->data, event->data_len);
+            break;
+            
+        case MQTT_EVENT_ERROR:
+            ESP_LOGE(TAG, "MQTT错误");
+            break;
+            
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 把新事件写入状态缓冲区
+ */
+static void status_drain_events(mqtt_batch_t *batch)
+{
+    char event[EVENT_STREAM_EVENT_MAX_LEN + MQTT_CONTROL_LAG_MAX_LEN];
+    
+    while (true) {
+        uint32_t missed = 0;
+        size_t len = event_stream_read(&mqtt_state.event_cursor, event + MQTT_CONTROL_LAG_MAX_LEN, &missed);
+        char *out = event + MQTT_CONTROL_LAG_MAX_LEN;
+        
+        if (missed > 0) {
+            // 丢失提示放在本事件之前
+            char lag[MQTT_CONTROL_LAG_MAX_LEN];
+            int lag_len = snprintf(lag, sizeof(lag), "!LAG missed=%u\n", (unsigned)missed);
+            out -= lag_len;
+            memcpy(out, lag, lag_len);
+            len += lag_len;
+        }
+        
+        if (len == 0) {
+            break;
+        }
+        batch_write(batch, out, len);
+    }
+}
+
+/**
+ * @brief 新事件通知，在发布者的任务中调用
+ */
+static void mqtt_event_listener(void)
+{
+    if (mqtt_state.status_task) {
+        xTaskNotifyGive(mqtt_state.status_task);
+    }
+}
+
+/**
+ * @brief 状态发布任务
+ * 收到新事件后等待一个聚合窗口，把窗口内的事件合并为一条消息；周期性地附带一次状态查询结果
+ */
+static void mqtt_status_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "状态发布任务启动");
+    
+    mqtt_batch_t *batch = &mqtt_state.status_batch;
+    batch->topic = mqtt_state.status_topic;
+    batch->len = 0;
+    
+    while (mqtt_state.running) {
+        uint32_t notified = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MQTT_CONTROL_TELEMETRY_MS));
+        if (!mqtt_state.running) {
+            break;
+        }
+        
+        if (!mqtt_state.connected) {
+            // 断线期间不发布，重连后事件流会提示丢失的事件数
+            continue;
+        }
+        
+        if (notified) {
+            vTaskDelay(pdMS_TO_TICKS(MQTT_CONTROL_BATCH_MS));
+            status_drain_events(batch);
+        } else {
+            // 周期状态：经同一回调执行状态查询，回复写入状态缓冲区
+            const command_t cmd = {
+                .type = COMMAND_TYPE_STATUS,
+            };
+            dispatch_command(batch, &cmd, "", TCP_REPLY_FORMAT_TEXT, 0);
+        }
+        
+        batch_flush(batch);
+    }
+    
+    ESP_LOGI(TAG, "状态发布任务退出");
+    mqtt_state.status_task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t mqtt_control_init(const mqtt_control_config_t *config)
+{
+    if (config == NULL || config->broker_uri == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (mqtt_state.client != NULL) {
+        ESP_LOGW(TAG, "MQTT控制通道已经初始化");
+        return ESP_OK;
+    }
+    
+    if (config->device_id != NULL) {
+        strncpy(mqtt_state.device_id, config->device_id, sizeof(mqtt_state.device_id) - 1);
+        mqtt_state.device_id[sizeof(mqtt_state.device_id) - 1] = '\0';
+    } else {
+        uint8_t mac[6];
+        ESP_ERROR_CHECK(esp_read_mac(mac, ESP_MAC_WIFI_STA));
+        snprintf(mqtt_state.device_id, sizeof(mqtt_state.device_id), "feeder-%02x%02x%02x",
+                 mac[3], mac[4], mac[5]);
+    }
+    
+    const char *group = config->group != NULL ? config->group : "all";
+    snprintf(mqtt_state.cmd_topic, sizeof(mqtt_state.cmd_topic), "feeder/%s/cmd", mqtt_state.device_id);
+    snprintf(mqtt_state.group_topic, sizeof(mqtt_state.group_topic), "feeder/group/%s/cmd", group);
+    snprintf(mqtt_state.reply_topic, sizeof(mqtt_state.reply_topic), "feeder/%s/reply", mqtt_state.device_id);
+    snprintf(mqtt_state.status_topic, sizeof(mqtt_state.status_topic), "feeder/%s/status", mqtt_state.device_id);
+    snprintf(mqtt_state.online_topic, sizeof(mqtt_state.online_topic), "feeder/%s/online", mqtt_state.device_id);
+    mqtt_state.reply_batch.topic = mqtt_state.reply_topic;
+    
+    ESP_LOGI(TAG, "初始化MQTT控制通道: %s, 设备ID: %s, 分组: %s",
+             config->broker_uri, mqtt_state.device_id, group);
+    
+    const esp_mqtt_client_config_t mqtt_config = {
+        .broker.address.uri = config->broker_uri,
+        .credentials.client_id = mqtt_state.device_id,
+        .session.last_will = {
+            .topic = mqtt_state.online_topic,
+            .msg = "0",
+            .msg_len = 1,
+            .qos = MQTT_CONTROL_QOS,
+            .retain = 1,
+        },
+        .buffer.size = MQTT_CONTROL_RX_MAX + MQTT_CONTROL_TOPIC_MAX,
+    };
+    
+    mqtt_state.client = esp_mqtt_client_init(&mqtt_config);
+    if (mqtt_state.client == NULL) {
+        ESP_LOGE(TAG, "创建MQTT客户端失败");
+        return ESP_FAIL;
+    }
+    
+    esp_mqtt_client_register_event(mqtt_state.client, MQTT_EVENT_ANY, mqtt_event_handler, NULL);
+    
+    return event_stream_add_listener(mqtt_event_listener);
+}
+
+esp_err_t mqtt_control_start(void)
+{
+    if (mqtt_state.client == NULL) {
+        ESP_LOGE(TAG, "MQTT控制通道未初始化");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (mqtt_state.running) {
+        ESP_LOGW(TAG, "MQTT控制通道已经在运行");
+        return ESP_OK;
+    }
+    
+    mqtt_state.running = true;
+    mqtt_state.event_cursor = event_stream_head();
+    
+    BaseType_t ret = xTaskCreate(
+        mqtt_status_task,          // 任务函数
+        "mqtt_status",            // 任务名称
+        3072,                      // 堆栈大小
+        NULL,                      // 参数
+        4,                         // 优先级
+        &mqtt_state.status_task    // 任务句柄
+    );
+    
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "创建任务失败");
+        mqtt_state.running = false;
+        return ESP_FAIL;
+    }
+    
+    return esp_mqtt_client_start(mqtt_state.client);
+}
+
+void mqtt_control_stop(void)
+{
+    ESP_LOGI(TAG, "停止MQTT控制通道");
+    
+    mqtt_state.running = false;
+    if (mqtt_state.status_task) {
+        xTaskNotifyGive(mqtt_state.status_task);
+    }
+    
+    if (mqtt_state.client != NULL) {
+        esp_mqtt_client_stop(mqtt_state.client);
+        mqtt_state.connected = false;
+    }
+}
+
+void mqtt_control_register_command_callback(command_callback_t callback)
+{
+    mqtt_state.callback = callback;
+    ESP_LOGI(TAG, "命令回调已注册");
+}
+
+bool mqtt_control_is_connected(void)
+{
+    return mqtt_state.connected;
+}
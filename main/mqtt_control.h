@@ -0,0 +1,79 @@
+/**
+ * @file mqtt_control.h
+ * @brief MQTT控制通道头文件
+ * 
+ * 可选的MQTT客户端，用于集中控制多台喂鱼器（在 .env 中配置 MQTT_BROKER_URI 时启用）。
+ * 
+ * 主题（<id>为设备ID，<group>为分组名）:
+ *   - feeder/<id>/cmd           订阅，发给本设备的命令
+ *   - feeder/group/<group>/cmd  订阅，发给整组设备的命令
+ *   - feeder/<id>/reply         发布(QoS1)，命令回复
+ *   - feeder/<id>/status        发布(QoS1)，批量的状态事件和定期状态
+ *   - feeder/<id>/online        发布(QoS1, retain)，"1"在线 / "0"离线（遗嘱消息）
+ * 
+ * 命令消息格式与TCP标签协议相同，一条消息可以包含多行 "#<tag> <cmd>"，
+ * 也可以是一个或多个二进制命令帧。同一条消息产生的回复合并为一条回复消息。
+ * 
+ * QoS1是至少一次投递，同一条命令可能到达两次（控制端在收到PUBACK前断线后重发）。
+ * 只有带请求ID的命令（"#<tag> <cmd> id=<rid>"，见 request_cache.h）会去重，
+ * 没有请求ID的重复动作命令会再执行一次。MQTT报文ID不能代替请求ID：设备以清除会话连接，
+ * 服务器不会向设备重新投递；控制端重发的消息由服务器转发时分配新的报文ID，
+ * 而报文ID在确认后还会被重用
+ */
+
+#ifndef MQTT_CONTROL_H
+#define MQTT_CONTROL_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "tcp_server.h"
+#include "socket_budget.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief MQTT控制通道配置
+ */
+typedef struct {
+    const char *broker_uri;     /**< 服务器地址，例如 "mqtt://192.168.1.10:1883" */
+    const char *device_id;      /**< 设备ID，NULL表示使用 "feeder-<MAC后三字节>" */
+    const char *group;          /**< 分组名，NULL表示 "all" */
+} mqtt_control_config_t;
+
+/**
+ * @brief 初始化MQTT控制通道
+ * @param config 配置
+ * @return ESP_OK 成功，其他值失败
+ */
+esp_err_t mqtt_control_init(const mqtt_control_config_t *config);
+
+/**
+ * @brief 连接服务器并启动状态发布任务
+ * @return ESP_OK 成功
+ */
+esp_err_t mqtt_control_start(void);
+
+/**
+ * @brief 断开连接并停止
+ */
+void mqtt_control_stop(void);
+
+/**
+ * @brief 注册控制命令回调（与TCP服务器使用同一回调类型）
+ * @param callback 回调函数
+ */
+void mqtt_control_register_command_callback(command_callback_t callback);
+
+/**
+ * @brief 获取与服务器的连接状态
+ * @return true 已连接
+ */
+bool mqtt_control_is_connected(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MQTT_CONTROL_H
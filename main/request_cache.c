@@ -0,0 +1,268 @@
+/**
+ * @file request_cache.c
+ * @brief 请求ID去重缓存实现
+ * 
+ * 表项同时挂在两条链上：哈希桶链（单向，用于查找）和LRU链（双向，头部为最近使用）。
+ * 空闲表项也在LRU链上并始终移到尾部，分配时从尾部向前取第一个不在执行中的表项
+ */
+
+#include "request_cache.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+#define REQUEST_CACHE_NONE  (-1)    // 链表结束
+
+_Static_assert((REQUEST_CACHE_BUCKETS & (REQUEST_CACHE_BUCKETS - 1)) == 0, "bucket count must be a power of two");
+_Static_assert(REQUEST_CACHE_SIZE <= 127, "entry index must fit in int8_t");
+
+// 缓存表项
+typedef struct {
+    bool valid;                                 // 是否在使用
+    uint32_t scope;                             // 请求ID的作用域
+    char id[COMMAND_REQUEST_ID_MAX_LEN + 1];    // 请求ID
+    uint32_t hash;                              // ID哈希值
+    TickType_t updated;                         // 最后更新时间
+    request_result_t result;                    // 请求结果
+    int8_t chain_next;                          // 同一哈希桶中的下一个表项
+    int8_t lru_prev;                            // LRU链表前一项（更近使用）
+    int8_t lru_next;                            // LRU链表后一项（更久未使用）
+} request_cache_entry_t;
+
+// 缓存状态
+typedef struct {
+    portMUX_TYPE lock;                              // 保护整个表
+    request_cache_entry_t entries[REQUEST_CACHE_SIZE]; // 表项
+    int8_t buckets[REQUEST_CACHE_BUCKETS];          // 哈希桶，指向桶中第一个表项
+    int8_t lru_head;                                // 最近使用的表项
+    int8_t lru_tail;                                // 最久未使用的表项
+    request_cache_stats_t stats;                    // 统计
+} request_cache_state_t;
+
+static request_cache_state_t cache_state = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+/**
+ * @brief FNV-1a哈希（作用域和ID）
+ */
+static uint32_t id_hash(uint32_t scope, const char *id)
+{
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < 4; i++) {
+        hash ^= (uint8_t)(scope >> (8 * i));
+        hash *= 16777619u;
+    }
+    while (*id) {
+        hash ^= (uint8_t)*id++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief 从LRU链表中摘下表项
+ */
+static void lru_unlink(int8_t index)
+{
+    request_cache_entry_t *entry = &cache_state.entries[index];
+    if (entry->lru_prev != REQUEST_CACHE_NONE) {
+        cache_state.entries[entry->lru_prev].lru_next = entry->lru_next;
+    } else {
+        cache_state.lru_head = entry->lru_next;
+    }
+    if (entry->lru_next != REQUEST_CACHE_NONE) {
+        cache_state.entries[entry->lru_next].lru_prev = entry->lru_prev;
+    } else {
+        cache_state.lru_tail = entry->lru_prev;
+    }
+}
+
+/**
+ * @brief 把表项放到LRU链表头部
+ */
+static void lru_push_head(int8_t index)
+{
+    request_cache_entry_t *entry = &cache_state.entries[index];
+    entry->lru_prev = REQUEST_CACHE_NONE;
+    entry->lru_next = cache_state.lru_head;
+    if (cache_state.lru_head != REQUEST_CACHE_NONE) {
+        cache_state.entries[cache_state.lru_head].lru_prev = index;
+    } else {
+        cache_state.lru_tail = index;
+    }
+    cache_state.lru_head = index;
+}
+
+/**
+ * @brief 把表项放到LRU链表尾部
+ */
+static void lru_push_tail(int8_t index)
+{
+    request_cache_entry_t *entry = &cache_state.entries[index];
+    entry->lru_next = REQUEST_CACHE_NONE;
+    entry->lru_prev = cache_state.lru_tail;
+    if (cache_state.lru_tail != REQUEST_CACHE_NONE) {
+        cache_state.entries[cache_state.lru_tail].lru_next = index;
+    } else {
+        cache_state.lru_head = index;
+    }
+    cache_state.lru_tail = index;
+}
+
+/**
+ * @brief 在哈希桶中查找ID
+ * @return 表项序号，未找到返回 REQUEST_CACHE_NONE
+ */
+static int8_t bucket_find(uint32_t scope, const char *id, uint32_t hash)
+{
+    int8_t index = cache_state.buckets[hash & (REQUEST_CACHE_BUCKETS - 1)];
+    while (index != REQUEST_CACHE_NONE) {
+        request_cache_entry_t *entry = &cache_state.entries[index];
+        if (entry->hash == hash && entry->scope == scope && strcmp(entry->id, id) == 0) {
+            return index;
+        }
+        index = entry->chain_next;
+    }
+    return REQUEST_CACHE_NONE;
+}
+
+/**
+ * @brief 把表项从哈希桶中移除并标记为空闲
+ */
+static void entry_remove(int8_t index)
+{
+    request_cache_entry_t *entry = &cache_state.entries[index];
+    int8_t *link = &cache_state.buckets[entry->hash & (REQUEST_CACHE_BUCKETS - 1)];
+    while (*link != REQUEST_CACHE_NONE) {
+        if (*link == index) {
+            *link = entry->chain_next;
+            break;
+        }
+        link = &cache_state.entries[*link].chain_next;
+    }
+    entry->valid = false;
+}
+
+/**
+ * @brief 分配表项：从LRU尾部取第一个空闲、已过期或已完成的表项
+ * @return 表项序号，全部在执行中时返回 REQUEST_CACHE_NONE
+ */
+static int8_t entry_alloc(TickType_t now)
+{
+    for (int8_t index = cache_state.lru_tail; index != REQUEST_CACHE_NONE;
+         index = cache_state.entries[index].lru_prev) {
+        request_cache_entry_t *entry = &cache_state.entries[index];
+        if (!entry->valid) {
+            return index;
+        }
+        bool expired = (now - entry->updated) > pdMS_TO_TICKS(REQUEST_CACHE_TTL_MS);
+        if (expired || entry->result.state != REQUEST_STATE_PENDING) {
+            if (!expired) {
+                cache_state.stats.evictions++;
+            }
+            entry_remove(index);
+            return index;
+        }
+    }
+    return REQUEST_CACHE_NONE;
+}
+
+void request_cache_init(void)
+{
+    portENTER_CRITICAL(&cache_state.lock);
+    memset(cache_state.entries, 0, sizeof(cache_state.entries));
+    memset(&cache_state.stats, 0, sizeof(cache_state.stats));
+    for (int i = 0; i < REQUEST_CACHE_BUCKETS; i++) {
+        cache_state.buckets[i] = REQUEST_CACHE_NONE;
+    }
+    cache_state.lru_head = REQUEST_CACHE_NONE;
+    cache_state.lru_tail = REQUEST_CACHE_NONE;
+    for (int8_t i = 0; i < REQUEST_CACHE_SIZE; i++) {
+        lru_push_tail(i);
+    }
+    portEXIT_CRITICAL(&cache_state.lock);
+}
+
+bool request_cache_begin(uint32_t scope, const char *id, uint8_t angle, request_result_t *cached)
+{
+    uint32_t hash = id_hash(scope, id);
+    TickType_t now = xTaskGetTickCount();
+    bool duplicate = false;
+    
+    portENTER_CRITICAL(&cache_state.lock);
+    int8_t index = bucket_find(scope, id, hash);
+    if (index != REQUEST_CACHE_NONE &&
+        (now - cache_state.entries[index].updated) <= pdMS_TO_TICKS(REQUEST_CACHE_TTL_MS)) {
+        *cached = cache_state.entries[index].result;
+        cache_state.stats.hits++;
+        lru_unlink(index);
+        lru_push_head(index);
+        duplicate = true;
+    } else {
+        if (index != REQUEST_CACHE_NONE) {
+            entry_remove(index);    // 已过期，按新请求处理
+        } else {
+            index = entry_alloc(now);
+        }
+        if (index != REQUEST_CACHE_NONE) {
+            request_cache_entry_t *entry = &cache_state.entries[index];
+            entry->valid = true;
+            entry->scope = scope;
+            strncpy(entry->id, id, COMMAND_REQUEST_ID_MAX_LEN);
+            entry->id[COMMAND_REQUEST_ID_MAX_LEN] = '\0';
+            entry->hash = hash;
+            entry->updated = now;
+            entry->result.state = REQUEST_STATE_PENDING;
+            entry->result.angle = angle;
+            entry->result.error = ESP_OK;
+            int8_t *bucket = &cache_state.buckets[hash & (REQUEST_CACHE_BUCKETS - 1)];
+            entry->chain_next = *bucket;
+            *bucket = index;
+            lru_unlink(index);
+            lru_push_head(index);
+            cache_state.stats.inserts++;
+        } else {
+            cache_state.stats.full++;   // 无法记录，本次请求照常执行但不受去重保护
+        }
+    }
+    portEXIT_CRITICAL(&cache_state.lock);
+    
+    return duplicate;
+}
+
+void request_cache_complete(uint32_t scope, const char *id, esp_err_t result)
+{
+    uint32_t hash = id_hash(scope, id);
+    
+    portENTER_CRITICAL(&cache_state.lock);
+    int8_t index = bucket_find(scope, id, hash);
+    if (index != REQUEST_CACHE_NONE) {
+        request_cache_entry_t *entry = &cache_state.entries[index];
+        entry->result.state = result == ESP_OK ? REQUEST_STATE_DONE : REQUEST_STATE_FAILED;
+        entry->result.error = result;
+        entry->updated = xTaskGetTickCount();
+    }
+    portEXIT_CRITICAL(&cache_state.lock);
+}
+
+void request_cache_forget(uint32_t scope, const char *id)
+{
+    uint32_t hash = id_hash(scope, id);
+    
+    portENTER_CRITICAL(&cache_state.lock);
+    int8_t index = bucket_find(scope, id, hash);
+    if (index != REQUEST_CACHE_NONE) {
+        entry_remove(index);
+        lru_unlink(index);
+        lru_push_tail(index);
+    }
+    portEXIT_CRITICAL(&cache_state.lock);
+}
+
+void request_cache_get_stats(request_cache_stats_t *stats)
+{
+    portENTER_CRITICAL(&cache_state.lock);
+    *stats = cache_state.stats;
+    portEXIT_CRITICAL(&cache_state.lock);
+}
@@ -0,0 +1,108 @@
+/**
+ * @file request_cache.h
+ * @brief 请求ID去重缓存头文件
+ *
+ * 命令可以附带可选的请求ID（文本协议 "#<tag> <cmd> id=<rid>"，REST的 Idempotency-Key 头）。
+ * 缓存记录最近执行的请求ID及其结果，控制端超时重试同一个ID时直接返回缓存的结果，
+ * 不会重复执行舵机动作，因此控制端可以用很短的超时积极重试。
+ *
+ * 固定大小的静态表：按ID哈希分桶查找（O(1)），表满时淘汰最久未使用的已完成记录。
+ * 请求ID在所有传输通道间共享（同一个ID通过TCP发出、超时后改用MQTT重试也能命中），
+ * 因此应由控制端保证唯一，例如 "<控制端名>-<序号>"。
+ * 
+ * 作用域（scope）区分不同来源的同名ID：显式的请求ID（id=、Idempotency-Key）作用域为
+ * REQUEST_CACHE_SCOPE_GLOBAL；UDP以必填的请求标签（或二进制帧序号）去重，作用域为源IP，
+ * 不同客户端使用相同的标签互不影响
+ */
+
+#ifndef REQUEST_CACHE_H
+#define REQUEST_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "command.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REQUEST_CACHE_SIZE      32      /**< 缓存的请求数 */
+#define REQUEST_CACHE_BUCKETS   64      /**< 哈希桶数量（必须为2的幂） */
+#define REQUEST_CACHE_TTL_MS    600000  /**< 记录有效期，过期后同一个ID按新请求执行 */
+
+#define REQUEST_CACHE_SCOPE_GLOBAL  0   /**< 跨传输通道共享的请求ID */
+
+/**
+ * @brief 请求状态
+ */
+typedef enum {
+    REQUEST_STATE_PENDING = 0,  /**< 已接受，尚未执行完成 */
+    REQUEST_STATE_DONE,         /**< 执行完成 */
+    REQUEST_STATE_FAILED,       /**< 执行失败 */
+} request_state_t;
+
+/**
+ * @brief 缓存的请求结果
+ */
+typedef struct {
+    request_state_t state;      /**< 请求状态 */
+    uint8_t angle;              /**< 目标角度 */
+    esp_err_t error;            /**< 执行失败时的错误码 */
+} request_result_t;
+
+/**
+ * @brief 缓存统计
+ */
+typedef struct {
+    uint32_t hits;              /**< 命中（重复请求）次数 */
+    uint32_t inserts;           /**< 新记录数 */
+    uint32_t evictions;         /**< 淘汰的未过期记录数 */
+    uint32_t full;              /**< 表中全是执行中的请求、无法记录的次数 */
+} request_cache_stats_t;
+
+/**
+ * @brief 初始化缓存
+ */
+void request_cache_init(void);
+
+/**
+ * @brief 开始一个带ID的请求（可在任意任务中调用）
+ *
+ * 查找和插入在同一个临界区中完成：ID已存在时返回缓存的结果；
+ * 否则记录为执行中，调用方继续执行命令，之后必须调用
+ * request_cache_complete() 或 request_cache_forget()
+ *
+ * @param scope 请求ID的作用域
+ * @param id 请求ID
+ * @param angle 本次请求的目标角度（记录到执行中的表项）
+ * @param cached 命中时输出缓存的结果
+ * @return true 重复请求，false 新请求
+ */
+bool request_cache_begin(uint32_t scope, const char *id, uint8_t angle, request_result_t *cached);
+
+/**
+ * @brief 记录请求的执行结果（在执行器任务的完成回调中调用）
+ * @param scope 请求ID的作用域
+ * @param id 请求ID
+ * @param result 执行结果
+ */
+void request_cache_complete(uint32_t scope, const char *id, esp_err_t result);
+
+/**
+ * @brief 删除请求记录（命令未被执行，例如队列已满，重试时应重新执行）
+ * @param scope 请求ID的作用域
+ * @param id 请求ID
+ */
+void request_cache_forget(uint32_t scope, const char *id);
+
+/**
+ * @brief 获取缓存统计
+ */
+void request_cache_get_stats(request_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REQUEST_CACHE_H
@@ -0,0 +1,358 @@
+/**
+ * @file rest_api.c
+ * @brief HTTP REST API实现
+ * 
+ * 请求转换为command_t后以二进制协议格式分发给命令回调，
+ * 回调的二进制回复帧带有结构化的状态码和数据，再按静态JSON模板生成响应。
+ * 请求和响应都只使用栈上的小缓冲区，每个请求不分配堆内存。
+ * 请求头 Idempotency-Key 作为请求ID，重试同一个Key返回缓存的结果（见 request_cache.h）
+ */
+
+#include "rest_api.h"
+#include "binary_protocol.h"
+#include "line_protocol.h"
+#include "command_handlers.h"
+#include "tcp_loop.h"
+#include "esp_log.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *TAG = "REST_API";
+
+#define REST_API_BODY_MAX       128     // 请求体最大长度
+#define REST_API_RECV_TIMEOUTS  2       // 读取请求体时允许的接收超时次数，超出后回复408并关闭连接
+
+// 预先生成的静态响应
+static const char JSON_ACCEPTED[]    = "{\"result\":\"accepted\"}";
+static const char JSON_REJECTED[]    = "{\"result\":\"rejected\",\"reason\":\"queue-full\"}";
+static const char JSON_BUSY[]        = "{\"result\":\"busy\"}";
+static const char JSON_BAD_REQUEST[] = "{\"result\":\"error\",\"reason\":\"bad-request\"}";
+static const char JSON_FAILED[]      = "{\"result\":\"error\",\"reason\":\"servo-failed\"}";
+static const char JSON_NO_HANDLER[]  = "{\"result\":\"error\",\"reason\":\"no-handler\"}";
+
+// 带数据的响应模板
+#define JSON_QUEUED_FMT     "{\"result\":\"queued\",\"pending\":%u}"
+#define JSON_DONE_FMT       "{\"result\":\"done\",\"angle\":%u}"
+#define JSON_STATUS_FMT     "{\"pending\":%u,\"capacity\":%u,\"wifi\":%s}"
+
+// 命令回调的回复（从二进制回复帧中解出）
+typedef struct {
+    bool valid;                                 // 是否收到回复
+    command_result_t status;                    // 状态码
+    uint8_t data[BINARY_PROTOCOL_MAX_PAYLOAD];  // 附加数据
+    size_t data_len;                            // 附加数据长度
+} rest_reply_t;
+
+static command_callback_t rest_callback = NULL;
+
+/**
+ * @brief 命令回调的回复函数，解出二进制回复帧的状态码和附加数据
+ */
+static int rest_reply(const tcp_request_ctx_t *ctx, const void *data, size_t len)
+{
+    rest_reply_t *reply = ctx->transport;
+    const uint8_t *frame = data;
+    
+    if (len < BINARY_PROTOCOL_HEADER_LEN + 1 + BINARY_PROTOCOL_CRC_LEN || frame[0] != BINARY_PROTOCOL_SOF) {
+        return -1;
+    }
+    
+    size_t payload_len = frame[1];
+    if (payload_len < 1 || payload_len > BINARY_PROTOCOL_MAX_PAYLOAD) {
+        return -1;
+    }
+    
+    reply->valid = true;
+    reply->status = (command_result_t)frame[BINARY_PROTOCOL_HEADER_LEN];
+    reply->data_len = payload_len - 1;
+    memcpy(reply->data, frame + BINARY_PROTOCOL_HEADER_LEN + 1, reply->data_len);
+    return len;
+}
+
+/**
+ * @brief 从JSON请求体中读取非负整数字段（只支持扁平对象）
+ * @return true 找到该字段
+ */
+static bool json_get_uint(const char *body, const char *key, uint32_t *value)
+{
+    char pattern[24];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    
+    const char *p = strstr(body, pattern);
+    if (p == NULL) {
+        return false;
+    }
+    p += strlen(pattern);
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    if (*p++ != ':') {
+        return false;
+    }
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    if (*p < '0' || *p > '9') {
+        return false;
+    }
+    
+    *value = strtoul(p, NULL, 10);
+    return true;
+}
+
+/**
+ * @brief 读取请求体
+ * 
+ * httpd任务由全部REST请求和WebSocket共用，声明了Content-Length却不发送请求体的客户端
+ * 不能一直占住它：接收超时超过 REST_API_RECV_TIMEOUTS 次即放弃
+ * 
+ * @return ESP_OK 成功；ESP_ERR_INVALID_SIZE 请求体过长；ESP_ERR_TIMEOUT 接收超时；ESP_FAIL 连接出错
+ */
+static esp_err_t read_body(httpd_req_t *req, char *body, size_t size)
+{
+    if (req->content_len >= size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    size_t received = 0;
+    int timeouts = 0;
+    while (received < req->content_len) {
+        int n = httpd_req_recv(req, body + received, req->content_len - received);
+        if (n <= 0) {
+            if (n == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < REST_API_RECV_TIMEOUTS) {
+                continue;
+            }
+            return n == HTTPD_SOCK_ERR_TIMEOUT ? ESP_ERR_TIMEOUT : ESP_FAIL;
+        }
+        received += n;
+    }
+    body[received] = '\0';
+    return ESP_OK;
+}
+
+/**
+ * @brief 读取请求头 Idempotency-Key 作为请求ID
+ * @return false 请求头存在但不合法（过长或含标签之外的字符）
+ */
+static bool read_request_id(httpd_req_t *req, char *request_id)
+{
+    request_id[0] = '\0';
+    
+    size_t len = httpd_req_get_hdr_value_len(req, "Idempotency-Key");
+    if (len == 0) {
+        return true;
+    }
+    if (len > COMMAND_REQUEST_ID_MAX_LEN ||
+        httpd_req_get_hdr_value_str(req, "Idempotency-Key", request_id, COMMAND_REQUEST_ID_MAX_LEN + 1) != ESP_OK) {
+        request_id[0] = '\0';
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (!line_protocol_is_tag_char(request_id[i])) {
+            request_id[0] = '\0';
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 发送JSON响应
+ */
+static esp_err_t send_json(httpd_req_t *req, const char *status, const char *json)
+{
+    httpd_resp_set_status(req, status);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, json, HTTPD_RESP_USE_STRLEN);
+}
+
+/**
+ * @brief 读取请求体失败时的响应
+ * 
+ * 接收超时回复408、连接出错不回复，两者都返回ESP_FAIL让httpd关闭连接；请求体过长回复400
+ */
+static esp_err_t respond_body_error(httpd_req_t *req, esp_err_t err)
+{
+    if (err == ESP_ERR_TIMEOUT) {
+        ESP_LOGW(TAG, "读取请求体超时，关闭连接");
+        httpd_resp_send_err(req, HTTPD_408_REQ_TIMEOUT, NULL);
+        return ESP_FAIL;
+    }
+    if (err != ESP_ERR_INVALID_SIZE) {
+        return ESP_FAIL;
+    }
+    return send_json(req, "400 Bad Request", JSON_BAD_REQUEST);
+}
+
+/**
+ * @brief 分发命令并按回复生成响应
+ */
+static esp_err_t dispatch_and_respond(httpd_req_t *req, command_t *cmd)
+{
+    char json[64];
+    rest_reply_t reply = {
+        .valid = false,
+    };
+    
+    if (rest_callback == NULL) {
+        return send_json(req, "500 Internal Server Error", JSON_NO_HANDLER);
+    }
+    if (!read_request_id(req, cmd->request_id)) {
+        return send_json(req, "400 Bad Request", JSON_BAD_REQUEST);
+    }
+    
+    // 以二进制格式分发，回复带结构化状态码；HTTP请求不支持异步完成回复（conn_id为0）
+    tcp_request_ctx_t ctx = {
+        .client_fd = httpd_req_to_sockfd(req),
+        .conn_id = 0,
+        .tag = "",
+        .format = TCP_REPLY_FORMAT_BINARY,
+        .seq = 0,
+        .reply = rest_reply,
+        .transport = &reply,
+        .perm = COMMAND_PERM_ADMIN,
+    };
+    
+    // 与TCP共用按源IP和全局的令牌桶，超限时 command_admit() 已写入BUSY回复
+    command_result_t result = COMMAND_RESULT_BUSY;
+    if (command_admit(cmd, &ctx, tcp_loop_peer_addr(ctx.client_fd))) {
+        result = rest_callback(cmd, &ctx);
+    }
+    if (reply.valid) {
+        result = reply.status;
+    }
+    
+    switch (result) {
+        case COMMAND_RESULT_OK:
+            if (cmd->type == COMMAND_TYPE_STATUS && reply.data_len >= 3) {
+                snprintf(json, sizeof(json), JSON_STATUS_FMT,
+                         reply.data[0], reply.data[1], reply.data[2] ? "true" : "false");
+                return send_json(req, "200 OK", json);
+            }
+            return send_json(req, "200 OK", JSON_ACCEPTED);
+        case COMMAND_RESULT_ACCEPTED:
+            return send_json(req, "202 Accepted", JSON_ACCEPTED);
+        case COMMAND_RESULT_QUEUED:
+            snprintf(json, sizeof(json), JSON_QUEUED_FMT, reply.data_len > 0 ? reply.data[0] : 0);
+            return send_json(req, "202 Accepted", json);
+        case COMMAND_RESULT_DONE:
+            // 重试的请求已执行完成（去重缓存中的结果）
+            snprintf(json, sizeof(json), JSON_DONE_FMT, reply.data_len > 0 ? reply.data[0] : 0);
+            return send_json(req, "200 OK", json);
+        case COMMAND_RESULT_REJECTED_FULL:
+            httpd_resp_set_hdr(req, "Retry-After", "1");
+            return send_json(req, "503 Service Unavailable", JSON_REJECTED);
+        case COMMAND_RESULT_BUSY: {
+            // 回复数据为建议的重试等待时间（毫秒，小端），换算为向上取整的秒数
+            char retry_after[8] = "1";
+            if (reply.data_len >= 2) {
+                uint32_t retry_ms = reply.data[0] | (reply.data[1] << 8);
+                snprintf(retry_after, sizeof(retry_after), "%u", (unsigned)((retry_ms + 999) / 1000));
+            }
+            httpd_resp_set_hdr(req, "Retry-After", retry_after);
+            return send_json(req, "503 Service Unavailable", JSON_BUSY);
+        }
+        case COMMAND_RESULT_FAILED:
+            return send_json(req, "500 Internal Server Error", JSON_FAILED);
+        default:
+            return send_json(req, "400 Bad Request", JSON_BAD_REQUEST);
+    }
+}
+
+/**
+ * @brief POST /feed
+ */
+static esp_err_t feed_handler(httpd_req_t *req)
+{
+    char body[REST_API_BODY_MAX];
+    uint32_t tank_id = 0;
+    uint32_t portions = 1;
+    
+    esp_err_t err = read_body(req, body, sizeof(body));
+    if (err != ESP_OK) {
+        return respond_body_error(req, err);
+    }
+    json_get_uint(body, "tank", &tank_id);
+    json_get_uint(body, "portions", &portions);
+    
+    if (tank_id > UINT8_MAX || portions > UINT8_MAX) {
+        return send_json(req, "400 Bad Request", JSON_BAD_REQUEST);
+    }
+    
+    command_t cmd = {
+        .type = COMMAND_TYPE_FEED,
+        .args.feed.tank_id = tank_id,
+        .args.feed.portions = portions,
+    };
+    ESP_LOGI(TAG, "POST /feed: tank=%u, portions=%u", (unsigned)tank_id, (unsigned)portions);
+    return dispatch_and_respond(req, &cmd);
+}
+
+/**
+ * @brief POST /servo/angle
+ */
+static esp_err_t angle_handler(httpd_req_t *req)
+{
+    char body[REST_API_BODY_MAX];
+    uint32_t angle = 0;
+    uint32_t hold_ms = 0;
+    
+    esp_err_t err = read_body(req, body, sizeof(body));
+    if (err != ESP_OK) {
+        return respond_body_error(req, err);
+    }
+    if (!json_get_uint(body, "angle", &angle)) {
+        return send_json(req, "400 Bad Request", JSON_BAD_REQUEST);
+    }
+    json_get_uint(body, "hold_ms", &hold_ms);
+    
+    if (angle > UINT8_MAX || hold_ms > UINT16_MAX) {
+        return send_json(req, "400 Bad Request", JSON_BAD_REQUEST);
+    }
+    
+    command_t cmd = {
+        .type = COMMAND_TYPE_SET_ANGLE,
+        .args.set_angle.angle = angle,
+        .args.set_angle.hold_ms = hold_ms,
+    };
+    ESP_LOGI(TAG, "POST /servo/angle: angle=%u, hold_ms=%u", (unsigned)angle, (unsigned)hold_ms);
+    return dispatch_and_respond(req, &cmd);
+}
+
+/**
+ * @brief GET /status
+ */
+static esp_err_t status_handler(httpd_req_t *req)
+{
+    command_t cmd = {
+        .type = COMMAND_TYPE_STATUS,
+    };
+    return dispatch_and_respond(req, &cmd);
+}
+
+esp_err_t rest_api_register(httpd_handle_t server, command_callback_t callback)
+{
+    if (server == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    rest_callback = callback;
+    
+    static const httpd_uri_t uris[] = {
+        { .uri = "/feed",        .method = HTTP_POST, .handler = feed_handler },
+        { .uri = "/servo/angle", .method = HTTP_POST, .handler = angle_handler },
+        { .uri = "/status",      .method = HTTP_GET,  .handler = status_handler },
+    };
+    
+    for (size_t i = 0; i < sizeof(uris) / sizeof(uris[0]); i++) {
+        esp_err_t err = httpd_register_uri_handler(server, &uris[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "注册URI失败: %s, %s", uris[i].uri, esp_err_to_name(err));
+            return err;
+        }
+    }
+    
+    ESP_LOGI(TAG, "REST API已注册: POST /feed, POST /servo/angle, GET /status");
+    return ESP_OK;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file rest_api.h
+ * @brief HTTP REST API头文件
+ * 
+ * 在WebSocket服务器所用的httpd实例上注册REST接口（HTTP/1.1，默认保持连接）:
+ *   - POST /feed          请求体 {"tank":0,"portions":1}，字段均可省略
+ *   - POST /servo/angle   请求体 {"angle":90,"hold_ms":0}，angle必填
+ *   - GET  /status        返回 {"pending":0,"capacity":8,"wifi":true}
+ * 
+ * 命令与TCP/UDP/WebSocket共用同一个命令回调。命令进入执行队列时返回202，
+ * 队列满返回503，参数错误返回400。动作完成不单独回复，可通过WebSocket事件流获知。
+ * 
+ * POST请求可带 Idempotency-Key 头（1-15个标签字符：字母、数字、'-'、'_'、'.'）作为请求ID：
+ * 重试同一个Key不会重复执行，已完成返回200 {"result":"done","angle":n}，
+ * 执行失败返回500，仍在执行中返回202 {"result":"accepted"}
+ */
+
+#ifndef REST_API_H
+#define REST_API_H
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "tcp_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 在httpd实例上注册REST接口
+ * @param server httpd服务器句柄
+ * @param callback 命令回调函数
+ * @return ESP_OK 成功，其他值失败
+ */
+esp_err_t rest_api_register(httpd_handle_t server, command_callback_t callback);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REST_API_H
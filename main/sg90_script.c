@@ -0,0 +1,134 @@
+/**
+ * @file sg90_script.c
+ * @brief 舵机动作脚本编译
+ * 
+ * 编译只在任务上下文中进行一次；中断中的执行器（sg90_servo.c）假定脚本已通过这里的检查，
+ * 不再做范围判断
+ */
+
+#include "sg90_script.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "SG90_SCRIPT";
+
+/**
+ * @brief 步骤是否占用周期
+ */
+static inline bool step_is_timed(const sg90_script_step_t *step)
+{
+    return step->op == SG90_SCRIPT_OP_SET || step->op == SG90_SCRIPT_OP_RAMP || step->op == SG90_SCRIPT_OP_HOLD;
+}
+
+/**
+ * @brief 检查单个步骤的参数
+ */
+static bool step_valid(const sg90_script_step_t *steps, size_t index)
+{
+    const sg90_script_step_t *step = &steps[index];
+    switch (step->op) {
+        case SG90_SCRIPT_OP_SET:
+            return step->angle_deci <= SG90_ANGLE_DECI_MAX;
+        case SG90_SCRIPT_OP_RAMP:
+            return step->angle_deci <= SG90_ANGLE_DECI_MAX && step->periods > 0 &&
+                   (unsigned)step->profile < SG90_PROFILE_COUNT;
+        case SG90_SCRIPT_OP_HOLD:
+            return step->periods > 0;
+        case SG90_SCRIPT_OP_LOOP:
+            if (step->target >= index || step->count == 0) {
+                return false;
+            }
+            // 循环体中至少一条步骤占用周期，中断中不会连续跳转
+            for (size_t i = step->target; i < index; i++) {
+                if (step_is_timed(&steps[i])) {
+                    return true;
+                }
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+esp_err_t sg90_script_compile(const sg90_script_step_t *steps, size_t count, sg90_script_t *script)
+{
+    if (script == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    script->len = 0;
+    if (steps == NULL || count == 0 || count > SG90_SCRIPT_MAX_STEPS) {
+        ESP_LOGE(TAG, "步骤数非法: %u", (unsigned)count);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        if (!step_valid(steps, i)) {
+            ESP_LOGE(TAG, "步骤%u非法 (op=%d)", (unsigned)i, steps[i].op);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        const sg90_script_step_t *step = &steps[i];
+        sg90_script_insn_t *insn = &script->insns[i];
+        memset(insn, 0, sizeof(*insn));
+        insn->op = step->op;
+    
+        // 外层循环：范围 [target, j] 包含 i 的其他循环；与 i 交叉的循环直接拒绝
+        uint32_t depth = 0;
+        uint64_t repeat = 1;
+        for (size_t j = 0; j < count; j++) {
+            const sg90_script_step_t *loop = &steps[j];
+            if (j == i || loop->op != SG90_SCRIPT_OP_LOOP) {
+                continue;
+            }
+            if (step->op == SG90_SCRIPT_OP_LOOP && j < i && loop->target < step->target && j >= step->target) {
+                ESP_LOGE(TAG, "步骤%u和步骤%u的循环交叉", (unsigned)j, (unsigned)i);
+                return ESP_ERR_INVALID_ARG;
+            }
+            if (loop->target <= (step->op == SG90_SCRIPT_OP_LOOP ? step->target : i) && j > i) {
+                depth++;
+                // 超过 UINT32_MAX 后总周期数必然饱和，截断后 repeat * periods 和累加都不会溢出uint64
+                repeat *= loop->count;
+                if (repeat > UINT32_MAX) {
+                    repeat = (uint64_t)UINT32_MAX + 1;
+                }
+            }
+        }
+    
+        switch (step->op) {
+            case SG90_SCRIPT_OP_SET:
+                insn->arg = step->angle_deci;
+                total += repeat;
+                break;
+            case SG90_SCRIPT_OP_RAMP:
+                insn->aux = step->profile;
+                insn->arg = step->angle_deci;
+                insn->count = step->periods;
+                total += repeat * step->periods;
+                break;
+            case SG90_SCRIPT_OP_HOLD:
+                insn->count = step->periods;
+                total += repeat * step->periods;
+                break;
+            case SG90_SCRIPT_OP_LOOP:
+                if (depth >= SG90_SCRIPT_LOOP_DEPTH) {
+                    ESP_LOGE(TAG, "步骤%u循环嵌套超过%d层", (unsigned)i, SG90_SCRIPT_LOOP_DEPTH);
+                    return ESP_ERR_INVALID_ARG;
+                }
+                insn->aux = (uint8_t)depth;
+                insn->arg = step->target;
+                insn->count = step->count;
+                break;
+            default:
+                break;
+        }
+    }
+    
+    memset(&script->insns[count], 0, sizeof(script->insns[count]));
+    script->insns[count].op = SG90_SCRIPT_OP_END;
+    script->total_periods = total > UINT32_MAX ? UINT32_MAX : (uint32_t)total;
+    script->len = (uint16_t)(count + 1);
+    return ESP_OK;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file sg90_script.h
+ * @brief 舵机动作脚本头文件
+ * 
+ * 动作脚本是一串步骤：立即设置角度、按速度曲线转动、保持若干周期、循环。
+ * 脚本先由 sg90_script_compile 检查并编译为紧凑的指令（每条6字节），
+ * 之后由 sg90_script_run 交给舵机驱动，在每个20ms周期的TEZ中断中逐条执行，
+ * 不经过任务调度，时序精确到周期。
+ * 
+ * 每条指令占用的周期数是确定的：SET 1个周期，RAMP 和 HOLD 各 periods 个周期，LOOP 不占时间。
+ * 例如投喂时开盖、停留、抖动3次、关盖:
+ * @code
+ * static const sg90_script_step_t feed_steps[] = {
+ *     SG90_SCRIPT_RAMP(900, 10, SG90_PROFILE_SCURVE),     // 0: 200ms转到90°
+ *     SG90_SCRIPT_HOLD(25),                               // 1: 停留500ms
+ *     SG90_SCRIPT_RAMP(700, 3, SG90_PROFILE_TRAPEZOID),   // 2: 抖动
+ *     SG90_SCRIPT_RAMP(900, 3, SG90_PROFILE_TRAPEZOID),   // 3
+ *     SG90_SCRIPT_LOOP(2, 3),                             // 4: 步骤2-3共执行3次
+ *     SG90_SCRIPT_RAMP(0, 10, SG90_PROFILE_SCURVE),       // 5: 关盖
+ * };
+ * static sg90_script_t feed_script;
+ * sg90_script_compile(feed_steps, 6, &feed_script);
+ * sg90_script_run(&servo, &feed_script, xTaskGetCurrentTaskHandle());
+ * @endcode
+ */
+
+#ifndef SG90_SCRIPT_H
+#define SG90_SCRIPT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "sg90_servo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SG90_SCRIPT_MAX_STEPS   32      /**< 单个脚本最多步骤数 */
+#define SG90_SCRIPT_LOOP_DEPTH  4       /**< 循环最多嵌套层数 */
+
+/** 毫秒换算为周期数（向上取整） */
+#define SG90_MS_TO_PERIODS(ms)  (((ms) + SG90_PERIOD_MS - 1) / SG90_PERIOD_MS)
+
+/**
+ * @brief 脚本操作
+ */
+typedef enum {
+    SG90_SCRIPT_OP_END = 0,     /**< 结束（编译时自动追加，步骤中不能使用） */
+    SG90_SCRIPT_OP_SET,         /**< 立即设置角度，占1个周期 */
+    SG90_SCRIPT_OP_RAMP,        /**< 从当前位置按速度曲线转到目标角度，占 periods 个周期 */
+    SG90_SCRIPT_OP_HOLD,        /**< 保持当前位置 periods 个周期 */
+    SG90_SCRIPT_OP_LOOP,        /**< 跳回 target 步骤，target 到本步骤之间共执行 count 次 */
+} sg90_script_op_t;
+
+/**
+ * @brief 脚本步骤（编译前的源格式）
+ */
+typedef struct {
+    sg90_script_op_t op;        /**< 操作 */
+    uint16_t angle_deci;        /**< SET/RAMP：目标角度，单位0.1° */
+    uint16_t periods;           /**< RAMP/HOLD：周期数，至少1 */
+    sg90_profile_t profile;     /**< RAMP：速度曲线 */
+    uint16_t target;            /**< LOOP：跳回的步骤下标，必须在本步骤之前 */
+    uint16_t count;             /**< LOOP：循环体执行次数，至少1 */
+} sg90_script_step_t;
+
+#define SG90_SCRIPT_SET(deci)               { .op = SG90_SCRIPT_OP_SET, .angle_deci = (deci) }
+#define SG90_SCRIPT_RAMP(deci, n, prof)     { .op = SG90_SCRIPT_OP_RAMP, .angle_deci = (deci), .periods = (n), .profile = (prof) }
+#define SG90_SCRIPT_HOLD(n)                 { .op = SG90_SCRIPT_OP_HOLD, .periods = (n) }
+#define SG90_SCRIPT_LOOP(to, times)         { .op = SG90_SCRIPT_OP_LOOP, .target = (to), .count = (times) }
+
+/**
+ * @brief 编译后的指令
+ */
+typedef struct {
+    uint8_t op;                 /**< 操作（sg90_script_op_t） */
+    uint8_t aux;                /**< RAMP：速度曲线；LOOP：循环计数器编号（嵌套层数） */
+    uint16_t arg;               /**< SET/RAMP：角度（0.1°）；LOOP：跳转目标 */
+    uint16_t count;             /**< RAMP/HOLD：周期数；LOOP：执行次数 */
+} sg90_script_insn_t;
+
+/**
+ * @brief 编译后的脚本，执行期间必须保持有效且不能修改（中断直接读取，应放在DRAM中）
+ */
+typedef struct {
+    uint16_t len;                                       /**< 指令数（含结尾的END），0表示未编译 */
+    uint32_t total_periods;                             /**< 完整执行的总周期数 */
+    sg90_script_insn_t insns[SG90_SCRIPT_MAX_STEPS + 1]; /**< 指令 */
+} sg90_script_t;
+
+/**
+ * @brief 检查并编译脚本
+ * 
+ * 检查内容：参数范围；循环目标在循环之前、循环体中至少有一条占用周期的步骤（不会在中断中空转）、
+ * 多个循环只能嵌套不能交叉、嵌套不超过 SG90_SCRIPT_LOOP_DEPTH 层
+ * 
+ * @param steps 步骤数组
+ * @param count 步骤数，1-SG90_SCRIPT_MAX_STEPS
+ * @param script 输出的脚本
+ * @return ESP_OK 成功；ESP_ERR_INVALID_ARG 脚本非法（script->len 置0）
+ */
+esp_err_t sg90_script_compile(const sg90_script_step_t *steps, size_t count, sg90_script_t *script);
+
+/**
+ * @brief 开始执行脚本，立即返回（实现见 sg90_servo.c）
+ * 
+ * 打断正在进行的动作或脚本（它的等待任务收到 SG90_MOTION_PREEMPTED）；脚本从当前位置开始，
+ * 第一条指令在下一个TEZ中断中执行。执行中可被 sg90_set_angle / sg90_move_to / 新的脚本打断
+ * 
+ * @param config 舵机配置
+ * @param script 已编译的脚本
+ * @param notify_task 执行结束时通知的任务（通知值 SG90_MOTION_DONE），NULL表示不通知
+ * @return ESP_OK 已开始；ESP_ERR_INVALID_ARG 脚本未编译；ESP_ERR_INVALID_STATE 舵机未初始化
+ */
+esp_err_t sg90_script_run(const sg90_config_t *config, const sg90_script_t *script, TaskHandle_t notify_task);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SG90_SCRIPT_H
@@ -4,11 +4,32 @@
  * 
  * 使用ESP32 MCPWM外设控制Tower Pro SG90舵机
  * 使用新的mcpwm_prelude.h API (ESP-IDF v5+)
+ * 
+ * 平滑动作的位置曲线在初始化时用浮点数算成定点表，TEZ中断中只做整数插值
+ * （ESP32的中断中不能使用浮点运算）。每组定时器的TEZ中断推进本组全部通道，
+ * 所有通道状态由同一个自旋锁保护，多通道的更新在中断中一次完成
+ * 
+ * 动作脚本（sg90_script.h）也在TEZ中断中执行：每个周期执行到一条占用周期的指令为止，
+ * RAMP 复用平滑动作的插值状态，角度在中断中查角度表换算
+ * 
+ * 空闲断开由每个通道比较器的匹配中断（脉冲下降沿之后）执行：此时输出已经是低电平，
+ * 持续强制低电平从下一个TEZ起屏蔽脉冲；撤销强制同样在下降沿之后，下一个TEZ输出完整的脉冲。
+ * 无论强制电平立即生效还是在TEZ生效，都不会截断正在输出的脉冲。未启用空闲断开的通道不注册该中断
+ * 
+ * 设置角度是热路径：查角度表、写比较值，不使用浮点、不输出日志（见 SG90_HOT_LOG_LEVEL），
+ * 出错时返回错误码而不是中止
+ * 
+ * 通道号 c 对应: 组 c / 6，组内操作符 (c % 6) / 2，操作符内比较器/生成器 c % 2。
+ * sg90_init / sg90_deinit 不能在多个任务中并发调用
  */
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/timers.h"
+#include "freertos/task.h"
 #include "sg90_servo.h"
+#include "sg90_script.h"
+#include "esp_attr.h"
+#include "esp_check.h"
 #include "esp_log.h"
 
 static const char *TAG = "SG90_SERVO";
@@ -18,103 +39,877 @@ static const char *TAG = "SG90_SERVO";
 #define SG90_RESOLUTION_HZ     1000000 // 1MHz分辨率 = 1us
 #define SG90_PERIOD_TICKS      20000   // 20000 ticks @ 1MHz = 20ms = 50Hz
 
-esp_err_t sg90_init(const sg90_config_t *config)
+// 速度曲线表：位置进度（0-SG90_PROFILE_ONE）按时间等分为 SG90_PROFILE_SEGMENTS 段
+#define SG90_PROFILE_SEGMENTS  64
+#define SG90_PROFILE_ONE       32768   // 进度1.0，Q15
+
+#define SG90_OPERS_PER_GROUP   (SG90_CHANNELS_PER_GROUP / 2)
+
+// 热路径（设置角度）日志的编译期级别，默认不编译进去；调试时定义为 ESP_LOG_INFO
+#ifndef SG90_HOT_LOG_LEVEL
+#define SG90_HOT_LOG_LEVEL     ESP_LOG_NONE
+#endif
+
+#define SG90_HOT_LOGI(format, ...)                          \
+    do {                                                    \
+        if (SG90_HOT_LOG_LEVEL >= ESP_LOG_INFO) {           \
+            ESP_LOGI(TAG, format, ##__VA_ARGS__);           \
+        }                                                   \
+    } while (0)
+
+// 定义为1时第一个舵机初始化后测量设置角度的CPU周期数并输出日志
+#ifndef SG90_CYCLE_PROFILE
+#define SG90_CYCLE_PROFILE     0
+#endif
+
+#if SG90_CYCLE_PROFILE
+#include "esp_cpu.h"
+#endif
+
+// 单个通道：平滑动作状态由调用方任务写入、TEZ中断推进，都在自旋锁内访问
+typedef struct {
+    const sg90_config_t *config;    // 绑定的舵机，NULL表示空闲
+    mcpwm_cmpr_handle_t comparator; // 比较器，NULL表示尚未创建完成（中断不访问）
+    mcpwm_gen_handle_t generator;   // 生成器（空闲断开时强制电平）
+    const uint16_t *lut;            // 角度（0.1°）-> 比较值表
+    uint32_t ticks;                 // 最近一次写入的比较值
+    uint32_t start_ticks;           // 动作起点的比较值
+    int32_t delta_ticks;            // 终点 - 起点
+    uint16_t step;                  // 已写入的步数（脚本的HOLD指令中为已保持的周期数）
+    uint16_t steps;                 // 总步数（周期数）
+    uint8_t profile;                // 速度曲线
+    bool active;                    // 动作进行中（最后一步写入后还要等一个周期生效）
+    TaskHandle_t notify_task;       // 结束时通知的任务
+    uint16_t motion_id;             // 所属的多舵机动作，同一次 sg90_move_multi 的通道相同，0表示单独的动作
+    const sg90_script_t *script;    // 执行中的脚本，NULL表示单次平滑动作
+    uint16_t pc;                    // 脚本的当前指令
+    uint16_t loop_left[SG90_SCRIPT_LOOP_DEPTH]; // 各层循环剩余次数，0表示不在循环中
+    uint16_t idle_periods;          // 静止多少个周期后断开，0表示不断开
+    uint16_t idle_count;            // 已静止的周期数
+    bool detached;                  // 输出已强制为低电平
+    bool attach_request;            // 等待下一次比较事件恢复输出
+} sg90_channel_t;
+
+// MCPWM组：一个定时器，三个操作符按需创建
+typedef struct {
+    uint8_t group_id;                                   // 组号
+    mcpwm_timer_handle_t timer;                         // 50Hz定时器，NULL表示未创建
+    mcpwm_oper_handle_t opers[SG90_OPERS_PER_GROUP];    // 操作符
+} sg90_group_t;
+
+// 角度表：按一种校准（0°和180°的比较值）生成，users为共用的通道数，0表示空闲
+typedef struct {
+    uint16_t users;
+    uint16_t ticks[SG90_ANGLE_DECI_MAX + 1];
+} sg90_lut_t;
+
+typedef struct {
+    portMUX_TYPE lock;                          // 保护所有通道的动作状态
+    bool profile_ready;                         // 速度曲线表已计算
+    sg90_group_t groups[SG90_GROUP_COUNT];      // MCPWM组
+    sg90_channel_t channels[SG90_MAX_SERVOS];   // 通道
+    sg90_lut_t luts[SG90_CALIBRATION_MAX];      // 角度表
+    uint16_t motion_seq;                        // 上一个多舵机动作的编号
+} sg90_state_t;
+
+static sg90_state_t sg90_state = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+    .profile_ready = false,
+    .groups = {
+        { .group_id = 0 },
+        { .group_id = 1 },
+    },
+};
+
+// 各速度曲线的位置进度表（DRAM中，中断可直接读取）
+static uint16_t sg90_profile_table[SG90_PROFILE_COUNT][SG90_PROFILE_SEGMENTS + 1];
+
+/**
+ * @brief 计算速度曲线表（任务上下文，使用浮点）
+ */
+static void sg90_profile_init(void)
+{
+    for (int i = 0; i <= SG90_PROFILE_SEGMENTS; i++) {
+        float t = (float)i / SG90_PROFILE_SEGMENTS;
+        
+        // 梯形：加速、匀速、减速各1/3，最大速度1.5
+        const float ta = 1.0f / 3.0f;
+        const float vmax = 1.0f / (1.0f - ta);
+        float trapezoid;
+        if (t < ta) {
+            trapezoid = 0.5f * vmax / ta * t * t;
+        } else if (t <= 1.0f - ta) {
+            trapezoid = 0.5f * vmax * ta + vmax * (t - ta);
+        } else {
+            trapezoid = 1.0f - 0.5f * vmax / ta * (1.0f - t) * (1.0f - t);
+        }
+        
+        // S形：6t^5 - 15t^4 + 10t^3
+        float scurve = t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+        
+        sg90_profile_table[SG90_PROFILE_TRAPEZOID][i] = (uint16_t)(trapezoid * SG90_PROFILE_ONE + 0.5f);
+        sg90_profile_table[SG90_PROFILE_SCURVE][i] = (uint16_t)(scurve * SG90_PROFILE_ONE + 0.5f);
+    }
+}
+
+/**
+ * @brief 取得校准对应的角度表：已有相同校准的表时共用，否则生成一张（任务上下文）
+ * @return 角度表，表已用完时返回NULL
+ */
+static const uint16_t *sg90_lut_acquire(uint32_t min_ticks, uint32_t max_ticks)
+{
+    sg90_lut_t *free_lut = NULL;
+    for (int i = 0; i < SG90_CALIBRATION_MAX; i++) {
+        sg90_lut_t *lut = &sg90_state.luts[i];
+        if (lut->users == 0) {
+            if (free_lut == NULL) {
+                free_lut = lut;
+            }
+        } else if (lut->ticks[0] == min_ticks && lut->ticks[SG90_ANGLE_DECI_MAX] == max_ticks) {
+            lut->users++;
+            return lut->ticks;
+        }
+    }
+    if (free_lut == NULL) {
+        return NULL;
+    }
+    
+    // 0° -> min_ticks, 180° -> max_ticks，线性插值四舍五入
+    uint32_t span = max_ticks - min_ticks;
+    for (uint32_t deci = 0; deci <= SG90_ANGLE_DECI_MAX; deci++) {
+        free_lut->ticks[deci] = (uint16_t)(min_ticks + (deci * span + SG90_ANGLE_DECI_MAX / 2) / SG90_ANGLE_DECI_MAX);
+    }
+    free_lut->users = 1;
+    return free_lut->ticks;
+}
+
+/**
+ * @brief 释放通道对角度表的引用
+ */
+static void sg90_lut_release(const uint16_t *ticks)
+{
+    for (int i = 0; i < SG90_CALIBRATION_MAX; i++) {
+        sg90_lut_t *lut = &sg90_state.luts[i];
+        if (lut->ticks == ticks && lut->users > 0) {
+            lut->users--;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 角度转换为0.1°单位并限制在0-180°（NaN按0°处理）
+ */
+static uint16_t sg90_angle_to_deci(float angle)
+{
+    if (!(angle > 0.0f)) {
+        return 0;
+    }
+    if (angle >= 180.0f) {
+        return SG90_ANGLE_DECI_MAX;
+    }
+    return (uint16_t)(angle * 10.0f + 0.5f);
+}
+
+/**
+ * @brief 查找舵机绑定的通道
+ * @return 通道，舵机未初始化时返回NULL
+ */
+static sg90_channel_t *sg90_channel_of(const sg90_config_t *config)
+{
+    if (config == NULL || config->channel >= SG90_MAX_SERVOS) {
+        return NULL;
+    }
+    sg90_channel_t *channel = &sg90_state.channels[config->channel];
+    return channel->config == config && channel->comparator != NULL ? channel : NULL;
+}
+
+/**
+ * @brief 第step步的比较值（整数运算，可在中断中调用）
+ */
+static inline uint32_t IRAM_ATTR sg90_channel_ticks_at(const sg90_channel_t *channel)
 {
+    // 步数映射到曲线表的位置，低8位为两点之间的插值比例
+    uint32_t phase = ((uint32_t)channel->step * (SG90_PROFILE_SEGMENTS << 8)) / channel->steps;
+    uint32_t index = phase >> 8;
+    const uint16_t *table = sg90_profile_table[channel->profile];
+    int32_t progress = table[index];
+    if (index < SG90_PROFILE_SEGMENTS) {
+        progress += ((int32_t)(table[index + 1] - table[index]) * (int32_t)(phase & 0xFF)) >> 8;
+    }
+    return (uint32_t)((int32_t)channel->start_ticks + channel->delta_ticks * progress / SG90_PROFILE_ONE);
+}
+
+/**
+ * @brief 写入比较值（调用方持有自旋锁）
+ */
+static inline void IRAM_ATTR sg90_channel_write(sg90_channel_t *channel, uint32_t ticks)
+{
+    channel->ticks = ticks;
+    mcpwm_comparator_set_compare_value(channel->comparator, ticks);
+}
+
+/**
+ * @brief 执行脚本的一个周期：执行到一条占用周期的指令为止（中断中，调用方持有自旋锁）
+ * 
+ * 编译时已保证每个循环体中有占用周期的指令，这里不会无限跳转
+ * @return 脚本已结束（上一条指令写入的比较值已在本次TEZ生效）
+ */
+static bool IRAM_ATTR sg90_channel_script_step(sg90_channel_t *channel)
+{
+    while (true) {
+        const sg90_script_insn_t *insn = &channel->script->insns[channel->pc];
+        switch (insn->op) {
+            case SG90_SCRIPT_OP_SET:
+                sg90_channel_write(channel, channel->lut[insn->arg]);
+                channel->pc++;
+                return false;
+    
+            case SG90_SCRIPT_OP_RAMP:
+                if (channel->step == 0) {
+                    channel->start_ticks = channel->ticks;
+                    channel->delta_ticks = (int32_t)channel->lut[insn->arg] - (int32_t)channel->ticks;
+                    channel->steps = insn->count;
+                    channel->profile = insn->aux;
+                }
+                channel->step++;
+                sg90_channel_write(channel, sg90_channel_ticks_at(channel));
+                if (channel->step >= channel->steps) {
+                    channel->step = 0;
+                    channel->pc++;
+                }
+                return false;
+    
+            case SG90_SCRIPT_OP_HOLD:
+                if (++channel->step >= insn->count) {
+                    channel->step = 0;
+                    channel->pc++;
+                }
+                return false;
+    
+            case SG90_SCRIPT_OP_LOOP: {
+                // 第一次到达时装入次数，减到0时落到下一条，计数器回到0供下次进入
+                uint16_t *left = &channel->loop_left[insn->aux];
+                if (*left == 0) {
+                    *left = insn->count;
+                }
+                channel->pc = --*left > 0 ? insn->arg : channel->pc + 1;
+                break;
+            }
+    
+            default:
+                return true;
+        }
+    }
+}
+
+/**
+ * @brief 同一个多舵机动作中是否还有其他通道未结束（调用方持有自旋锁）
+ * 
+ * 两组定时器相位不同步，动作的最后一个通道可能在任一组的TEZ中结束，所以按动作编号查找全部通道
+ */
+static bool IRAM_ATTR sg90_motion_pending_locked(const sg90_channel_t *channel)
+{
+    if (channel->motion_id == 0) {
+        return false;
+    }
+    for (int i = 0; i < SG90_MAX_SERVOS; i++) {
+        const sg90_channel_t *other = &sg90_state.channels[i];
+        if (other != channel && other->active && other->motion_id == channel->motion_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 定时器计数到0（TEZ）中断：推进本组所有通道的平滑动作和脚本
+ * 
+ * 本周期写入的比较值在下一次TEZ时同时生效，所以最后一步写入后再等一个周期才通知动作结束
+ */
+static bool IRAM_ATTR sg90_on_timer_empty(mcpwm_timer_handle_t timer, const mcpwm_timer_event_data_t *edata,
+                                          void *user_ctx)
+{
+    const sg90_group_t *group = (const sg90_group_t *)user_ctx;
+    sg90_channel_t *channels = &sg90_state.channels[group->group_id * SG90_CHANNELS_PER_GROUP];
+    TaskHandle_t notify[SG90_CHANNELS_PER_GROUP];
+    int notify_count = 0;
+    BaseType_t woken = pdFALSE;
+    
+    portENTER_CRITICAL_ISR(&sg90_state.lock);
+    for (int i = 0; i < SG90_CHANNELS_PER_GROUP; i++) {
+        sg90_channel_t *channel = &channels[i];
+        if (!channel->active || channel->detached) {
+            continue;       // 断开的通道等输出恢复后再推进动作，第一步不会丢失
+        }
+        bool finished;
+        if (channel->script != NULL) {
+            finished = sg90_channel_script_step(channel);
+        } else if (channel->step < channel->steps) {
+            channel->step++;
+            sg90_channel_write(channel, sg90_channel_ticks_at(channel));
+            finished = false;
+        } else {
+            finished = true;
+        }
+        if (finished) {
+            channel->active = false;
+            channel->script = NULL;
+            // 多舵机动作在最后一个通道结束时才通知
+            if (channel->notify_task != NULL && !sg90_motion_pending_locked(channel)) {
+                notify[notify_count++] = channel->notify_task;
+            }
+            channel->notify_task = NULL;
+        }
+    }
+    portEXIT_CRITICAL_ISR(&sg90_state.lock);
+    
+    for (int i = 0; i < notify_count; i++) {
+        xTaskNotifyFromISR(notify[i], SG90_MOTION_DONE, eSetValueWithOverwrite, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+/**
+ * @brief 比较事件中断（脉冲下降沿之后）：静止计时、断开和恢复输出
+ */
+static bool IRAM_ATTR sg90_on_compare_reach(mcpwm_cmpr_handle_t comparator, const mcpwm_compare_event_data_t *edata,
+                                            void *user_ctx)
+{
+    sg90_channel_t *channel = (sg90_channel_t *)user_ctx;
+    
+    portENTER_CRITICAL_ISR(&sg90_state.lock);
+    if (channel->generator == NULL) {
+        // 通道尚未就绪或正在释放
+    } else if (channel->detached) {
+        if (channel->attach_request) {
+            mcpwm_generator_set_force_level(channel->generator, -1, true);
+            channel->detached = false;
+            channel->attach_request = false;
+            channel->idle_count = 0;
+        }
+    } else if (channel->active) {
+        channel->idle_count = 0;
+    } else if (channel->idle_count < channel->idle_periods && ++channel->idle_count == channel->idle_periods) {
+        mcpwm_generator_set_force_level(channel->generator, 0, true);
+        channel->detached = true;
+    }
+    portEXIT_CRITICAL_ISR(&sg90_state.lock);
+    return false;
+}
+
+/**
+ * @brief 有新的目标：重新开始静止计时，已断开的输出在下一次比较事件恢复（调用方持有自旋锁）
+ */
+static inline void sg90_channel_wake_locked(sg90_channel_t *channel)
+{
+    channel->idle_count = 0;
+    if (channel->detached) {
+        channel->attach_request = true;
+    }
+}
+
+/**
+ * @brief 停止通道正在进行的动作（调用方持有自旋锁）
+ * 
+ * 通道属于多舵机动作时，整个动作视为被打断：同一动作的其他通道继续转到各自的目标，
+ * 但不再通知等待的任务，等待的任务只收到一次 SG90_MOTION_PREEMPTED
+ * 
+ * @return 需要通知被打断的任务，NULL表示没有
+ */
+static TaskHandle_t sg90_channel_cancel_locked(sg90_channel_t *channel)
+{
+    TaskHandle_t preempted = channel->active ? channel->notify_task : NULL;
+    if (preempted != NULL && channel->motion_id != 0) {
+        for (int i = 0; i < SG90_MAX_SERVOS; i++) {
+            sg90_channel_t *other = &sg90_state.channels[i];
+            if (other->motion_id == channel->motion_id) {
+                other->notify_task = NULL;
+            }
+        }
+    }
+    channel->active = false;
+    channel->script = NULL;
+    channel->notify_task = NULL;
+    channel->motion_id = 0;
+    return preempted;
+}
+
+/**
+ * @brief 创建组的定时器并注册TEZ中断（组内第一个舵机初始化时调用）
+ */
+static esp_err_t sg90_group_start(sg90_group_t *group)
+{
+    esp_err_t ret = ESP_OK;
+    mcpwm_timer_config_t timer_config = {
+        .group_id = group->group_id,
+        .clk_src = MCPWM_TIMER_CLK_SRC_DEFAULT,
+        .resolution_hz = SG90_RESOLUTION_HZ,  // 1MHz分辨率 = 1us
+        .count_mode = MCPWM_TIMER_COUNT_MODE_UP,
+        .period_ticks = SG90_PERIOD_TICKS,      // 20ms = 50Hz
+    };
+    ESP_RETURN_ON_ERROR(mcpwm_new_timer(&timer_config, &group->timer), TAG, "MCPWM组%d定时器创建失败", group->group_id);
+    
+    // 平滑动作由TEZ中断推进，回调必须在使能定时器之前注册
+    mcpwm_timer_event_callbacks_t timer_callbacks = {
+        .on_empty = sg90_on_timer_empty,
+    };
+    ESP_GOTO_ON_ERROR(mcpwm_timer_register_event_callbacks(group->timer, &timer_callbacks, group),
+                      err, TAG, "注册定时器中断失败");
+    
+    ESP_GOTO_ON_ERROR(mcpwm_timer_enable(group->timer), err, TAG, "使能定时器失败");
+    ESP_GOTO_ON_ERROR(mcpwm_timer_start_stop(group->timer, MCPWM_TIMER_START_NO_STOP), err_disable, TAG, "启动定时器失败");
+    
+    ESP_LOGI(TAG, "MCPWM组%d定时器已启动", group->group_id);
+    return ESP_OK;
+    
+err_disable:
+    mcpwm_timer_disable(group->timer);
+err:
+    mcpwm_del_timer(group->timer);
+    group->timer = NULL;
+    return ret;
+}
+
+/**
+ * @brief 组内是否还有使用中的通道，oper_index >= 0 时只检查该操作符的两个通道
+ */
+static bool sg90_group_in_use(const sg90_group_t *group, int oper_index)
+{
+    int first = group->group_id * SG90_CHANNELS_PER_GROUP;
+    for (int i = 0; i < SG90_CHANNELS_PER_GROUP; i++) {
+        if (oper_index >= 0 && i / 2 != oper_index) {
+            continue;
+        }
+        if (sg90_state.channels[first + i].config != NULL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 释放通道及其资源，组内不再使用的操作符和定时器一并删除（反初始化和初始化失败时调用）
+ */
+static void sg90_channel_release(sg90_config_t *config, sg90_channel_t *channel)
+{
+    sg90_group_t *group = &sg90_state.groups[config->channel / SG90_CHANNELS_PER_GROUP];
+    int oper_index = (config->channel % SG90_CHANNELS_PER_GROUP) / 2;
+    
+    // 先释放通道，之后中断不再访问它的比较器
+    portENTER_CRITICAL(&sg90_state.lock);
+    TaskHandle_t preempted = sg90_channel_cancel_locked(channel);
+    const uint16_t *lut = channel->lut;
+    channel->comparator = NULL;
+    channel->generator = NULL;
+    channel->lut = NULL;
+    channel->config = NULL;
+    portEXIT_CRITICAL(&sg90_state.lock);
+    if (preempted != NULL) {
+        xTaskNotify(preempted, SG90_MOTION_PREEMPTED, eSetValueWithOverwrite);
+    }
+    if (lut != NULL) {
+        sg90_lut_release(lut);
+    }
+    
+    // 停止并删除生成器
+    if (config->generator) {
+        mcpwm_generator_set_actions_on_timer_event(config->generator,
+            MCPWM_GEN_TIMER_EVENT_ACTION_END());
+        mcpwm_generator_set_actions_on_compare_event(config->generator,
+            MCPWM_GEN_COMPARE_EVENT_ACTION_END());
+        mcpwm_del_generator(config->generator);
+        config->generator = NULL;
+    }
+    
+    // 删除比较器
+    if (config->comparator) {
+        mcpwm_del_comparator(config->comparator);
+        config->comparator = NULL;
+    }
+    
+    // 操作符的两个通道都释放后删除操作符
+    if (!sg90_group_in_use(group, oper_index) && group->opers[oper_index] != NULL) {
+        mcpwm_del_operator(group->opers[oper_index]);
+        group->opers[oper_index] = NULL;
+    }
+    config->oper = NULL;
+    
+    // 组内最后一个舵机释放后停止并删除定时器
+    if (!sg90_group_in_use(group, -1) && group->timer != NULL) {
+        mcpwm_timer_start_stop(group->timer, MCPWM_TIMER_STOP_EMPTY);
+        mcpwm_timer_disable(group->timer);
+        mcpwm_del_timer(group->timer);
+        group->timer = NULL;
+        ESP_LOGI(TAG, "MCPWM组%d定时器已删除", group->group_id);
+    }
+    config->timer = NULL;
+}
+
+#if SG90_CYCLE_PROFILE
+/**
+ * @brief 测量设置角度的平均CPU周期数（初始化时执行一次，结果输出到日志）
+ * 
+ * 旧路径复现改动前的 sg90_set_angle：浮点插值、ESP_LOGI格式化浮点数、写比较值；
+ * 新路径为查表的 sg90_set_angle_deci。两者都写0°的比较值，不改变舵机位置
+ */
+static void sg90_cycle_profile(const sg90_config_t *config)
+{
+    const uint32_t rounds = 16;
+    volatile float angle = 0.0f;    // 防止编译期算出旧路径的结果
+    uint32_t legacy_cycles = 0;
+    uint32_t lut_cycles = 0;
+    
+    for (uint32_t i = 0; i < rounds; i++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        float pulse_width = config->min_pulse_width_us +
+                            (angle / 180.0f) *
+                            (config->max_pulse_width_us - config->min_pulse_width_us);
+        ESP_LOGI(TAG, "设置角度: %.1f° (脉冲宽度: %uus)", angle, (unsigned)pulse_width);
+        portENTER_CRITICAL(&sg90_state.lock);
+        mcpwm_comparator_set_compare_value(config->comparator, (uint32_t)pulse_width);
+        portEXIT_CRITICAL(&sg90_state.lock);
+        legacy_cycles += esp_cpu_get_cycle_count() - start;
+    
+        start = esp_cpu_get_cycle_count();
+        sg90_set_angle_deci(config, 0);
+        lut_cycles += esp_cpu_get_cycle_count() - start;
+    }
+    
+    ESP_LOGI(TAG, "设置角度平均耗时: 浮点+日志 %u 周期, 查表 %u 周期",
+             (unsigned)(legacy_cycles / rounds), (unsigned)(lut_cycles / rounds));
+}
+#endif
+
+esp_err_t sg90_init(sg90_config_t *config)
+{
+    esp_err_t ret = ESP_OK;
+    ESP_RETURN_ON_FALSE(config != NULL, ESP_ERR_INVALID_ARG, TAG, "舵机配置为空");
+    
     ESP_LOGI(TAG, "初始化SG90舵机");
     ESP_LOGI(TAG, "信号引脚: GPIO%d", config->signal_pin);
     ESP_LOGI(TAG, "脉冲宽度范围: %.1f-%.1fus", 
              config->min_pulse_width_us, 
              config->max_pulse_width_us);
     
-    // 1. 配置GPIO
+    // 比较值分辨率为1us，脉冲宽度按整数微秒生成角度表
+    ESP_RETURN_ON_FALSE(config->min_pulse_width_us >= 0.0f &&
+                        config->max_pulse_width_us > config->min_pulse_width_us &&
+                        config->max_pulse_width_us < SG90_PERIOD_TICKS,
+                        ESP_ERR_INVALID_ARG, TAG, "脉冲宽度范围非法");
+    ESP_RETURN_ON_FALSE(config->idle_detach_ms <= SG90_IDLE_DETACH_MAX_MS, ESP_ERR_INVALID_ARG, TAG,
+                        "空闲断开时间超过%dms", SG90_IDLE_DETACH_MAX_MS);
+    uint32_t min_ticks = (uint32_t)(config->min_pulse_width_us + 0.5f);
+    uint32_t max_ticks = (uint32_t)(config->max_pulse_width_us + 0.5f);
+    
+    if (!sg90_state.profile_ready) {
+        sg90_profile_init();
+        sg90_state.profile_ready = true;
+    }
+    
+    // 1. 分配通道：先用满第一组，再用第二组
+    int index = -1;
+    portENTER_CRITICAL(&sg90_state.lock);
+    for (int i = 0; i < SG90_MAX_SERVOS; i++) {
+        if (sg90_state.channels[i].config == NULL) {
+            sg90_state.channels[i].config = config;
+            sg90_state.channels[i].comparator = NULL;
+            sg90_state.channels[i].generator = NULL;
+            sg90_state.channels[i].lut = NULL;
+            sg90_state.channels[i].active = false;
+            sg90_state.channels[i].notify_task = NULL;
+            sg90_state.channels[i].motion_id = 0;
+            sg90_state.channels[i].script = NULL;
+            sg90_state.channels[i].idle_count = 0;
+            sg90_state.channels[i].detached = false;
+            sg90_state.channels[i].attach_request = false;
+            index = i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&sg90_state.lock);
+    if (index < 0) {
+        ESP_LOGE(TAG, "舵机通道已用完（最多%d路）", SG90_MAX_SERVOS);
+        return ESP_ERR_NO_MEM;
+    }
+    sg90_channel_t *channel = &sg90_state.channels[index];
+    sg90_group_t *group = &sg90_state.groups[index / SG90_CHANNELS_PER_GROUP];
+    int oper_index = (index % SG90_CHANNELS_PER_GROUP) / 2;
+    config->channel = index;
+    config->timer = NULL;
+    config->oper = NULL;
+    config->comparator = NULL;
+    config->generator = NULL;
+    
+    // 2. 角度表
+    channel->lut = sg90_lut_acquire(min_ticks, max_ticks);
+    ESP_GOTO_ON_FALSE(channel->lut != NULL, ESP_ERR_NO_MEM, err, TAG,
+                      "角度表已用完（最多%d种校准）", SG90_CALIBRATION_MAX);
+    
+    // 3. 配置GPIO
     gpio_config_t io_conf = {
         .mode = GPIO_MODE_OUTPUT,
         .pin_bit_mask = (1ULL << config->signal_pin),
         .pull_down_en = 0,
         .pull_up_en = 0,
     };
-    ESP_ERROR_CHECK(gpio_config(&io_conf));
+    ESP_GOTO_ON_ERROR(gpio_config(&io_conf), err, TAG, "GPIO%d配置失败", config->signal_pin);
     gpio_set_level(config->signal_pin, 0);
     
-    // 2. 创建MCPWM定时器
-    mcpwm_timer_config_t timer_config = {
-        .group_id = 0,
-        .clk_src = MCPWM_TIMER_CLK_SRC_DEFAULT,
-        .resolution_hz = SG90_RESOLUTION_HZ,  // 1MHz分辨率 = 1us
-        .count_mode = MCPWM_TIMER_COUNT_MODE_UP,
-        .period_ticks = SG90_PERIOD_TICKS,      // 20ms = 50Hz
-    };
-    ESP_ERROR_CHECK(mcpwm_new_timer(&timer_config, &config->timer));
-    
-    // 3. 创建MCPWM操作符
-    mcpwm_operator_config_t oper_config = {
-        .group_id = 0,
-    };
-    ESP_ERROR_CHECK(mcpwm_new_operator(&oper_config, &config->oper));
+    // 4. 组内共用的定时器
+    if (group->timer == NULL) {
+        ESP_GOTO_ON_ERROR(sg90_group_start(group), err, TAG, "MCPWM组%d启动失败", group->group_id);
+    }
+    config->timer = group->timer;
     
-    // 4. 连接定时器到操作符
-    ESP_ERROR_CHECK(mcpwm_operator_connect_timer(config->oper, config->timer));
+    // 5. 相邻两个通道共用的操作符，连接到组定时器
+    if (group->opers[oper_index] == NULL) {
+        mcpwm_operator_config_t oper_config = {
+            .group_id = group->group_id,
+        };
+        ESP_GOTO_ON_ERROR(mcpwm_new_operator(&oper_config, &group->opers[oper_index]), err, TAG, "创建操作符失败");
+        ESP_GOTO_ON_ERROR(mcpwm_operator_connect_timer(group->opers[oper_index], group->timer), err, TAG,
+                          "操作符连接定时器失败");
+    }
+    config->oper = group->opers[oper_index];
     
-    // 5. 创建比较器
+    // 6. 创建比较器
     mcpwm_comparator_config_t comp_config = {
         .flags.update_cmp_on_tez = true,  // 在定时器计数到0时更新
     };
-    ESP_ERROR_CHECK(mcpwm_new_comparator(config->oper, &comp_config, &config->comparator));
+    ESP_GOTO_ON_ERROR(mcpwm_new_comparator(config->oper, &comp_config, &config->comparator), err, TAG, "创建比较器失败");
     
-    // 6. 创建PWM生成器
+    // 7. 创建PWM生成器
     mcpwm_generator_config_t gen_config = {
         .gen_gpio_num = config->signal_pin,
     };
-    ESP_ERROR_CHECK(mcpwm_new_generator(config->oper, &gen_config, &config->generator));
+    ESP_GOTO_ON_ERROR(mcpwm_new_generator(config->oper, &gen_config, &config->generator), err, TAG, "创建生成器失败");
     
-    // 7. 配置生成器动作 - 在计数到0时输出高电平，在比较值时输出低电平
-    ESP_ERROR_CHECK(mcpwm_generator_set_actions_on_timer_event(config->generator,
+    // 8. 配置生成器动作 - 在计数到0时输出高电平，在比较值时输出低电平
+    ESP_GOTO_ON_ERROR(mcpwm_generator_set_actions_on_timer_event(config->generator,
         MCPWM_GEN_TIMER_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, 
                                       MCPWM_TIMER_EVENT_EMPTY, 
                                       MCPWM_GEN_ACTION_HIGH),
-        MCPWM_GEN_TIMER_EVENT_ACTION_END()));
+        MCPWM_GEN_TIMER_EVENT_ACTION_END()), err, TAG, "配置生成器失败");
     
-    ESP_ERROR_CHECK(mcpwm_generator_set_actions_on_compare_event(config->generator,
+    ESP_GOTO_ON_ERROR(mcpwm_generator_set_actions_on_compare_event(config->generator,
         MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP,
                                         config->comparator,
                                         MCPWM_GEN_ACTION_LOW),
-        MCPWM_GEN_COMPARE_EVENT_ACTION_END()));
+        MCPWM_GEN_COMPARE_EVENT_ACTION_END()), err, TAG, "配置生成器失败");
     
-    // 8. 启动定时器
-    ESP_ERROR_CHECK(mcpwm_timer_enable(config->timer));
-    ESP_ERROR_CHECK(mcpwm_timer_start_stop(config->timer, MCPWM_TIMER_START_NO_STOP));
+    // 9. 空闲断开：静止计时在比较事件中断中进行
+    if (config->idle_detach_ms > 0) {
+        channel->idle_periods = (config->idle_detach_ms + SG90_PERIOD_MS - 1) / SG90_PERIOD_MS;
+        mcpwm_comparator_event_callbacks_t comp_callbacks = {
+            .on_reach = sg90_on_compare_reach,
+        };
+        ESP_GOTO_ON_ERROR(mcpwm_comparator_register_event_callbacks(config->comparator, &comp_callbacks, channel),
+                          err, TAG, "注册比较事件中断失败");
+    } else {
+        channel->idle_periods = 0;
+    }
+    
+    // 10. 通道就绪，设置初始角度为0度
+    portENTER_CRITICAL(&sg90_state.lock);
+    channel->generator = config->generator;
+    channel->comparator = config->comparator;
+    portEXIT_CRITICAL(&sg90_state.lock);
+    ESP_GOTO_ON_ERROR(sg90_set_angle_deci(config, 0), err, TAG, "设置初始角度失败");
     
-    // 9. 设置初始角度为0度
-    sg90_set_angle(config, 0.0f);
+#if SG90_CYCLE_PROFILE
+    if (index == 0) {
+        sg90_cycle_profile(config);
+    }
+#endif
     
-    ESP_LOGI(TAG, "SG90舵机初始化完成");
+    ESP_LOGI(TAG, "SG90舵机初始化完成: 通道%d (MCPWM组%d, 操作符%d), 空闲%ums后断开输出", index, group->group_id,
+             oper_index, (unsigned)(channel->idle_periods * SG90_PERIOD_MS));
     return ESP_OK;
+    
+err:
+    sg90_channel_release(config, channel);
+    return ret;
 }
 
 esp_err_t sg90_set_angle(const sg90_config_t *config, float angle)
 {
-    // 限制角度范围
-    if (angle < 0.0f) {
-        angle = 0.0f;
-    } else if (angle > 180.0f) {
-        angle = 180.0f;
+    return sg90_set_angle_deci(config, sg90_angle_to_deci(angle));
+}
+
+esp_err_t sg90_set_angle_deci(const sg90_config_t *config, uint16_t angle_deci)
+{
+    sg90_channel_t *channel = sg90_channel_of(config);
+    if (channel == NULL) {
+        return ESP_ERR_INVALID_STATE;
     }
+    if (angle_deci > SG90_ANGLE_DECI_MAX) {
+        angle_deci = SG90_ANGLE_DECI_MAX;
+    }
+    uint32_t ticks = channel->lut[angle_deci];
+    
+    SG90_HOT_LOGI("通道%u 设置角度: %u.%u° (脉冲宽度: %uus)", (unsigned)config->channel,
+                  (unsigned)(angle_deci / 10), (unsigned)(angle_deci % 10), (unsigned)ticks);
     
-    // 根据公式计算脉冲宽度
-    // 0° -> min_pulse, 180° -> max_pulse
-    float pulse_width = config->min_pulse_width_us + 
-                        (angle / 180.0f) * 
-                        (config->max_pulse_width_us - config->min_pulse_width_us);
+    // 打断平滑动作后直接设置比较值
+    portENTER_CRITICAL(&sg90_state.lock);
+    TaskHandle_t preempted = sg90_channel_cancel_locked(channel);
+    esp_err_t ret = mcpwm_comparator_set_compare_value(channel->comparator, ticks);
+    if (ret == ESP_OK) {
+        channel->ticks = ticks;
+        sg90_channel_wake_locked(channel);
+    }
+    portEXIT_CRITICAL(&sg90_state.lock);
+    
+    if (preempted != NULL) {
+        xTaskNotify(preempted, SG90_MOTION_PREEMPTED, eSetValueWithOverwrite);
+    }
+    return ret;
+}
+
+esp_err_t sg90_move_multi(const sg90_target_t *targets, size_t count, uint32_t duration_ms,
+                          sg90_profile_t profile, TaskHandle_t notify_task)
+{
+    if (targets == NULL || count == 0 || count > SG90_MAX_SERVOS ||
+        (unsigned)profile >= SG90_PROFILE_COUNT || duration_ms > SG90_MOVE_MAX_MS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // 锁外完成查找和查表换算
+    sg90_channel_t *channels[SG90_MAX_SERVOS];
+    uint32_t target_ticks[SG90_MAX_SERVOS];
+    for (size_t i = 0; i < count; i++) {
+        channels[i] = sg90_channel_of(targets[i].servo);
+        if (channels[i] == NULL) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        target_ticks[i] = channels[i]->lut[sg90_angle_to_deci(targets[i].angle)];
+    }
+    
+    uint16_t steps = duration_ms / SG90_PERIOD_MS;
+    if (steps == 0) {
+        steps = 1;
+    }
+    
+    // 一次加锁设置全部目标，同组的中断看到的要么全是旧目标要么全是新目标；
+    // 从当前位置出发，打断的动作不会跳变
+    TaskHandle_t preempted[SG90_MAX_SERVOS];
+    int preempted_count = 0;
+    portENTER_CRITICAL(&sg90_state.lock);
+    uint16_t motion_id = 0;
+    if (count > 1) {
+        // 所有通道都带上等待的任务，最后结束的通道负责通知
+        motion_id = ++sg90_state.motion_seq;
+        if (motion_id == 0) {
+            motion_id = ++sg90_state.motion_seq;
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        sg90_channel_t *channel = channels[i];
+        TaskHandle_t task = sg90_channel_cancel_locked(channel);
+        if (task != NULL) {
+            preempted[preempted_count++] = task;
+        }
+        channel->start_ticks = channel->ticks;
+        channel->delta_ticks = (int32_t)target_ticks[i] - (int32_t)channel->ticks;
+        channel->step = 0;
+        channel->steps = steps;
+        channel->profile = profile;
+        channel->notify_task = notify_task;
+        channel->motion_id = motion_id;
+        channel->active = true;
+        sg90_channel_wake_locked(channel);
+    }
+    portEXIT_CRITICAL(&sg90_state.lock);
     
-    ESP_LOGI(TAG, "设置角度: %.1f° (脉冲宽度: %.1fus)", angle, pulse_width);
+    for (int i = 0; i < preempted_count; i++) {
+        xTaskNotify(preempted[i], SG90_MOTION_PREEMPTED, eSetValueWithOverwrite);
+    }
+    return ESP_OK;
+}
+
+esp_err_t sg90_move_to(const sg90_config_t *config, float angle, uint32_t duration_ms,
+                       sg90_profile_t profile, TaskHandle_t notify_task)
+{
+    sg90_target_t target = {
+        .servo = config,
+        .angle = angle,
+    };
+    return sg90_move_multi(&target, 1, duration_ms, profile, notify_task);
+}
+
+esp_err_t sg90_script_run(const sg90_config_t *config, const sg90_script_t *script, TaskHandle_t notify_task)
+{
+    if (script == NULL || script->len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sg90_channel_t *channel = sg90_channel_of(config);
+    if (channel == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
     
-    // 设置比较值（以微秒为单位）
-    ESP_ERROR_CHECK(mcpwm_comparator_set_compare_value(config->comparator, 
-                                                        (uint32_t)pulse_width));
+    portENTER_CRITICAL(&sg90_state.lock);
+    TaskHandle_t preempted = sg90_channel_cancel_locked(channel);
+    channel->script = script;
+    channel->pc = 0;
+    channel->step = 0;
+    for (int i = 0; i < SG90_SCRIPT_LOOP_DEPTH; i++) {
+        channel->loop_left[i] = 0;
+    }
+    channel->notify_task = notify_task;
+    channel->active = true;
+    sg90_channel_wake_locked(channel);
+    portEXIT_CRITICAL(&sg90_state.lock);
     
+    if (preempted != NULL) {
+        xTaskNotify(preempted, SG90_MOTION_PREEMPTED, eSetValueWithOverwrite);
+    }
     return ESP_OK;
 }
 
+esp_err_t sg90_stop(const sg90_config_t *config)
+{
+    sg90_channel_t *channel = sg90_channel_of(config);
+    if (channel == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    portENTER_CRITICAL(&sg90_state.lock);
+    TaskHandle_t preempted = sg90_channel_cancel_locked(channel);
+    portEXIT_CRITICAL(&sg90_state.lock);
+    
+    if (preempted != NULL) {
+        xTaskNotify(preempted, SG90_MOTION_PREEMPTED, eSetValueWithOverwrite);
+    }
+    return ESP_OK;
+}
+
+bool sg90_is_moving(const sg90_config_t *config)
+{
+    sg90_channel_t *channel = sg90_channel_of(config);
+    if (channel == NULL) {
+        return false;
+    }
+    
+    portENTER_CRITICAL(&sg90_state.lock);
+    bool active = channel->active;
+    portEXIT_CRITICAL(&sg90_state.lock);
+    return active;
+}
+
+bool sg90_is_detached(const sg90_config_t *config)
+{
+    sg90_channel_t *channel = sg90_channel_of(config);
+    if (channel == NULL) {
+        return false;
+    }
+    
+    portENTER_CRITICAL(&sg90_state.lock);
+    bool detached = channel->detached;
+    portEXIT_CRITICAL(&sg90_state.lock);
+    return detached;
+}
+
 esp_err_t sg90_set_angle_with_reset(const sg90_config_t *config, float angle, uint32_t reset_delay_ms)
 {
     esp_err_t ret = ESP_OK;
@@ -139,34 +934,10 @@ esp_err_t sg90_deinit(sg90_config_t *config)
 {
     ESP_LOGI(TAG, "反初始化SG90舵机");
     
-    // 停止并删除生成器
-    if (config->generator) {
-        mcpwm_generator_set_actions_on_timer_event(config->generator,
-            MCPWM_GEN_TIMER_EVENT_ACTION_END());
-        mcpwm_generator_set_actions_on_compare_event(config->generator,
-            MCPWM_GEN_COMPARE_EVENT_ACTION_END());
-        mcpwm_del_generator(config->generator);
-        config->generator = NULL;
-    }
-    
-    // 删除比较器
-    if (config->comparator) {
-        mcpwm_del_comparator(config->comparator);
-        config->comparator = NULL;
-    }
-    
-    // 删除操作符
-    if (config->oper) {
-        mcpwm_del_operator(config->oper);
-        config->oper = NULL;
-    }
-    
-    // 停止并删除定时器
-    if (config->timer) {
-        mcpwm_timer_start_stop(config->timer, MCPWM_TIMER_STOP_EMPTY);
-        mcpwm_del_timer(config->timer);
-        config->timer = NULL;
+    sg90_channel_t *channel = sg90_channel_of(config);
+    if (channel == NULL) {
+        return ESP_ERR_INVALID_STATE;
     }
-    
+    sg90_channel_release(config, channel);
     return ESP_OK;
 }
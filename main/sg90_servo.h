@@ -4,6 +4,22 @@
  * 
  * 使用ESP32 MCPWM外设控制Tower Pro SG90舵机
  * 使用新的mcpwm_prelude.h API (ESP-IDF v5+)
+ * 
+ * 多路驱动：每个MCPWM组只用一个50Hz定时器，组内3个操作符共用该定时器，每个操作符的
+ * 两个比较器/生成器各驱动一个舵机，每组6路；第一组用满后使用第二组，最多12路。
+ * 同一组的舵机共用定时器的计数到0（TEZ）时刻，sg90_move_multi 同时更新的多个舵机
+ * 在同一个TEZ生效
+ * 
+ * 平滑动作（sg90_move_to）由TEZ中断驱动：每个20ms周期按预先计算的速度曲线更新一次比较值，
+ * 调用方不阻塞，动作结束时通过任务通知告知等待的任务。多步的动作序列（设置、转动、保持、循环）
+ * 用动作脚本（sg90_script.h）描述，同样由TEZ中断逐周期执行
+ * 
+ * 角度换算使用初始化时按校准的脉冲宽度生成的整数表（0.1°一项），设置角度只查表并写一次比较值；
+ * 校准相同的舵机共用一张表
+ * 
+ * 空闲断开（idle_detach_ms）：舵机静止超过设定时间后强制信号为低电平，舵机不再收到脉冲、
+ * 不再通电保持，也不会在投喂间隔中抖动；下一次设置角度或开始动作时自动恢复输出。
+ * 断开和恢复都在比较事件（脉冲下降沿）之后进行，不会产生不完整的脉冲
  */
 
 #ifndef SG90_SERVO_H
@@ -13,42 +29,162 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+#include <stddef.h>
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "driver/gpio.h"
 #include "driver/mcpwm_prelude.h"
 #include "soc/mcpwm_periph.h"
 
+#define SG90_GROUP_COUNT            2       /**< 使用的MCPWM组数 */
+#define SG90_CHANNELS_PER_GROUP     6       /**< 每组舵机数（3个操作符 x 2个比较器） */
+#define SG90_MAX_SERVOS             (SG90_GROUP_COUNT * SG90_CHANNELS_PER_GROUP) /**< 最多舵机数 */
+#define SG90_CALIBRATION_MAX        2       /**< 不同脉冲宽度校准的最多种数（每种一张约3.6KB的角度表） */
+#define SG90_ANGLE_DECI_MAX         1800    /**< 最大角度，单位0.1° */
+
+/**
+ * @brief 舵机配置
+ * 
+ * signal_pin 和脉冲宽度由调用方填写，其余字段由 sg90_init 填写；
+ * 定时器和操作符与同组的其他舵机共用，不要单独删除
+ */
 typedef struct {
     gpio_num_t signal_pin;          /**< 信号引脚 */
-    mcpwm_timer_handle_t timer;     /**< 定时器句柄 */
-    mcpwm_oper_handle_t oper;       /**< 操作符句柄 */
+    mcpwm_timer_handle_t timer;     /**< 定时器句柄（组内共用） */
+    mcpwm_oper_handle_t oper;       /**< 操作符句柄（与相邻通道共用） */
     mcpwm_cmpr_handle_t comparator; /**< 比较器句柄 */
     mcpwm_gen_handle_t generator;   /**< 生成器句柄 */
     float min_pulse_width_us;       /**< 最小脉冲宽度（微秒），默认0.5ms */
     float max_pulse_width_us;       /**< 最大脉冲宽度（微秒），默认2.5ms */
+    uint8_t channel;                /**< 驱动分配的通道号，组号 = channel / SG90_CHANNELS_PER_GROUP */
+    uint32_t idle_detach_ms;        /**< 静止多久后断开输出（毫秒，按20ms周期取整），0表示一直输出 */
 } sg90_config_t;
 
+#define SG90_PERIOD_MS          20          /**< PWM周期，平滑动作每个周期前进一步 */
+#define SG90_MOVE_MAX_MS        60000       /**< 单次平滑动作的最长时间 */
+
+/**
+ * @brief 动作结束时发给等待任务的通知值（eSetValueWithOverwrite）
+ */
+#define SG90_MOTION_DONE        1           /**< 到达目标角度 */
+#define SG90_MOTION_PREEMPTED   2           /**< 被新的动作或 sg90_set_angle 打断 */
+
+/**
+ * @brief 平滑动作的速度曲线
+ */
+typedef enum {
+    SG90_PROFILE_TRAPEZOID = 0,     /**< 梯形速度：匀加速、匀速、匀减速各占1/3时间 */
+    SG90_PROFILE_SCURVE,            /**< S形曲线（五次多项式），起止时速度和加速度都为0，不会甩出饲料 */
+    SG90_PROFILE_COUNT,
+} sg90_profile_t;
+
 /**
- * @brief 默认SG90配置
+ * @brief 多舵机动作中单个舵机的目标
  */
-#define SG90_DEFAULT_CONFIG(pin, mcpwm_unit, mcpwm_timer) \
+typedef struct {
+    const sg90_config_t *servo;     /**< 已初始化的舵机 */
+    float angle;                    /**< 目标角度 (0-180) */
+} sg90_target_t;
+
+#define SG90_IDLE_DETACH_MAX_MS 60000       /**< 空闲断开时间上限 */
+
+/**
+ * @brief 默认SG90配置（不断开输出）
+ */
+#define SG90_DEFAULT_CONFIG(pin)                          \
     {                                                     \
         .signal_pin = pin,                                \
-        .unit = mcpwm_unit,                               \
-        .timer = mcpwm_timer,                             \
+        .timer = NULL,                                    \
+        .oper = NULL,                                     \
+        .comparator = NULL,                               \
+        .generator = NULL,                                \
         .min_pulse_width_us = 500.0f,                     \
         .max_pulse_width_us = 2500.0f,                    \
+        .idle_detach_ms = 0,                              \
     }
 
 /**
- * @brief 初始化SG90舵机
+ * @brief 初始化SG90舵机，分配一个通道并转到0°
  * 
- * @param config 舵机配置
- * @return esp_err_t 初始化结果
+ * 组内第一个舵机创建并启动该组的定时器，之后的舵机只创建比较器和生成器（必要时创建操作符）
+ * 
+ * @param config 舵机配置，初始化后在反初始化之前必须保持有效
+ * @return esp_err_t 初始化结果；ESP_ERR_INVALID_ARG 脉冲宽度范围或空闲断开时间非法；
+ *         ESP_ERR_NO_MEM 通道或角度表已用完；失败时已分配的资源全部释放
+ */
+esp_err_t sg90_init(sg90_config_t *config);
+
+/**
+ * @brief 立即设置角度（打断正在进行的平滑动作）
  */
-esp_err_t sg90_init(const sg90_config_t *config);
 esp_err_t sg90_set_angle(const sg90_config_t *config, float angle);
+
+/**
+ * @brief 立即设置角度，整数版本（不使用浮点，打断正在进行的平滑动作）
+ * @param config 舵机配置
+ * @param angle_deci 角度，单位0.1°，超过 SG90_ANGLE_DECI_MAX 按最大值处理
+ * @return ESP_OK 成功；ESP_ERR_INVALID_STATE 舵机未初始化；其他为写比较值失败
+ */
+esp_err_t sg90_set_angle_deci(const sg90_config_t *config, uint16_t angle_deci);
+
+/**
+ * @brief 设置角度，延时后复位到0°（阻塞调用方，新代码请使用 sg90_move_to）
+ */
 esp_err_t sg90_set_angle_with_reset(const sg90_config_t *config, float angle, uint32_t reset_delay_ms);
+
+/**
+ * @brief 开始平滑动作，立即返回
+ * 
+ * 从当前位置出发，按速度曲线在 duration_ms 内到达目标角度；比较值在每个周期的TEZ中断中更新，
+ * 在下一个周期开始时生效。正在进行的动作被打断，它的等待任务收到 SG90_MOTION_PREEMPTED。
+ * 
+ * @param config 舵机配置
+ * @param angle 目标角度 (0-180)
+ * @param duration_ms 动作时间，按20ms周期取整，0表示下一个周期直接到达
+ * @param profile 速度曲线
+ * @param notify_task 动作结束时通知的任务（通知值见 SG90_MOTION_DONE），NULL表示不通知
+ * @return ESP_OK 已开始；ESP_ERR_INVALID_ARG 参数非法；ESP_ERR_INVALID_STATE 舵机未初始化
+ */
+esp_err_t sg90_move_to(const sg90_config_t *config, float angle, uint32_t duration_ms,
+                       sg90_profile_t profile, TaskHandle_t notify_task);
+
+/**
+ * @brief 多个舵机同时开始平滑动作，立即返回
+ * 
+ * 所有目标在一次加锁中设置，步数相同：同一组的舵机从同一个TEZ开始、每个周期同时更新、
+ * 同时到达；不同组的舵机各自按本组定时器推进（两组定时器相位不同步，最多相差一个周期）。
+ * duration_ms 为0时即为多个舵机的原子角度更新。
+ * 
+ * @param targets 目标数组
+ * @param count 目标个数，1-SG90_MAX_SERVOS
+ * @param duration_ms 动作时间
+ * @param profile 速度曲线
+ * @param notify_task 所有目标都到位时通知的任务（两组中最后结束的一个），NULL表示不通知
+ * @return ESP_OK 已开始；ESP_ERR_INVALID_ARG 参数非法；ESP_ERR_INVALID_STATE 有舵机未初始化
+ */
+esp_err_t sg90_move_multi(const sg90_target_t *targets, size_t count, uint32_t duration_ms,
+                          sg90_profile_t profile, TaskHandle_t notify_task);
+
+/**
+ * @brief 停止正在进行的平滑动作或脚本，停在当前位置（等待的任务收到 SG90_MOTION_PREEMPTED）
+ */
+esp_err_t sg90_stop(const sg90_config_t *config);
+
+/**
+ * @brief 是否有正在进行的平滑动作或脚本
+ */
+bool sg90_is_moving(const sg90_config_t *config);
+
+/**
+ * @brief 输出是否已因空闲断开
+ */
+bool sg90_is_detached(const sg90_config_t *config);
+
+/**
+ * @brief 反初始化舵机，释放通道；组内最后一个舵机释放时删除该组的定时器
+ */
 esp_err_t sg90_deinit(sg90_config_t *config);
 
 #ifdef __cplusplus
@@ -0,0 +1,77 @@
+/**
+ * @file socket_budget.h
+ * @brief lwIP socket预算
+ * 
+ * 所有占用lwIP socket的模块的数量都在这里定义，合计不能超过 CONFIG_LWIP_MAX_SOCKETS，
+ * 剩下的全部分给TCP连接池。各模块的头文件从这里取自己的数量，不需要互相包含。
+ * 增加占用socket的模块时在这里加一项，并相应调大 sdkconfig.defaults 中的 CONFIG_LWIP_MAX_SOCKETS
+ * 
+ *   命令端口监听socket                              1
+ *   UDP控制通道                                     1
+ *   WebSocket服务器（连接 + 监听 + 内部控制）        WS_SERVER_MAX_CLIENTS + 2
+ *   MQTT控制通道                                    1
+ *   TLS监听socket（启用时；会话使用连接池的槽位）     1
+ *   附加监听端口（每个端口 监听 + 客户端）           TCP_LISTENER_MAX * (1 + TCP_LISTENER_MAX_CLIENTS)
+ *   TCP连接池                                       其余，至少 CONN_POOL_MIN_SIZE
+ */
+
+#ifndef SOCKET_BUDGET_H
+#define SOCKET_BUDGET_H
+
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TCP_SERVER_SOCKET_COUNT     1   /**< 命令端口监听socket（客户端使用连接池的槽位） */
+#define UDP_SERVER_SOCKET_COUNT     1   /**< UDP控制通道 */
+
+#define WS_SERVER_MAX_CLIENTS       10  /**< WebSocket服务器最大连接数（WebSocket和普通HTTP连接共用） */
+
+/**
+ * @brief WebSocket服务器占用的socket数量（连接 + 监听socket + 内部控制socket）
+ */
+#define WS_SERVER_SOCKET_COUNT      (WS_SERVER_MAX_CLIENTS + 2)
+
+#define MQTT_CONTROL_SOCKET_COUNT   1   /**< MQTT控制通道占用的socket数量 */
+
+#ifdef TLS_SERVER_ENABLED
+#define TLS_SESSION_SOCKET_COUNT    1   /**< TLS监听socket；会话本身使用TCP连接池的槽位 */
+#else
+#define TLS_SESSION_SOCKET_COUNT    0
+#endif
+
+#define TCP_LISTENER_MAX            2   /**< 附加监听端口数量上限 */
+#define TCP_LISTENER_MAX_CLIENTS    2   /**< 每个附加监听端口同时连接的客户端上限 */
+
+/**
+ * @brief 附加监听端口可占用的socket数：每个端口一个监听socket加上全部客户端
+ */
+#define TCP_LISTENER_SOCKET_COUNT   (TCP_LISTENER_MAX * (1 + TCP_LISTENER_MAX_CLIENTS))
+
+/**
+ * @brief TCP连接池槽位数：lwIP的socket总数扣除上面所有模块占用的部分
+ */
+#define CONN_POOL_SIZE              (CONFIG_LWIP_MAX_SOCKETS - TCP_SERVER_SOCKET_COUNT - UDP_SERVER_SOCKET_COUNT \
+                                     - WS_SERVER_SOCKET_COUNT - MQTT_CONTROL_SOCKET_COUNT \
+                                     - TLS_SESSION_SOCKET_COUNT - TCP_LISTENER_SOCKET_COUNT)
+
+#define CONN_POOL_MIN_SIZE          8   /**< 命令端口至少支持的同时连接数 */
+
+/**
+ * @brief 同时建立的TCP连接数（不含监听socket），lwIP的TCP控制块数量不能少于它
+ */
+#define SOCKET_BUDGET_TCP_ACTIVE    (WS_SERVER_MAX_CLIENTS + MQTT_CONTROL_SOCKET_COUNT \
+                                     + TCP_LISTENER_MAX * TCP_LISTENER_MAX_CLIENTS + CONN_POOL_SIZE)
+
+_Static_assert(CONN_POOL_SIZE >= CONN_POOL_MIN_SIZE,
+               "CONFIG_LWIP_MAX_SOCKETS too small: the TCP connection pool needs at least CONN_POOL_MIN_SIZE slots");
+_Static_assert(CONFIG_LWIP_MAX_ACTIVE_TCP >= SOCKET_BUDGET_TCP_ACTIVE,
+               "CONFIG_LWIP_MAX_ACTIVE_TCP too small for the socket budget");
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOCKET_BUDGET_H
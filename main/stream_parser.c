@@ -0,0 +1,169 @@
+/**
+ * @file stream_parser.c
+ * @brief 流式请求分帧器实现
+ * 
+ * 行内容和二进制帧体按段批量复制到帧缓冲区，只有帧之间的字节逐个判断类型
+ */
+
+#include "stream_parser.h"
+#include <string.h>
+
+// 分帧器状态
+enum {
+    STREAM_STATE_IDLE = 0,      // 帧之间，按下一个字节判断帧类型
+    STREAM_STATE_LINE,          // 正在接收一行
+    STREAM_STATE_BINARY,        // 正在接收二进制帧
+};
+
+void stream_parser_init(stream_parser_t *parser, stream_parser_framing_t framing)
+{
+    parser->framing = framing;
+    stream_parser_reset(parser);
+}
+
+void stream_parser_reset(stream_parser_t *parser)
+{
+    parser->state = STREAM_STATE_IDLE;
+    parser->binary_only = false;
+    parser->overflow = false;
+    parser->len = 0;
+    parser->need = 0;
+}
+
+/**
+ * @brief 开始接收一行
+ */
+static void line_begin(stream_parser_t *parser)
+{
+    parser->state = STREAM_STATE_LINE;
+    parser->len = 0;
+    parser->overflow = false;
+}
+
+/**
+ * @brief 追加行内容，超过上限的部分丢弃并标记超长
+ */
+static void line_append(stream_parser_t *parser, const uint8_t *data, size_t len)
+{
+    size_t space = STREAM_PARSER_LINE_MAX - parser->len;
+    if (len > space) {
+        len = space;
+        parser->overflow = true;
+    }
+    memcpy(parser->buf + parser->len, data, len);
+    parser->len += len;
+}
+
+static inline bool is_line_end(uint8_t c)
+{
+    return c == '\n' || c == '\r';
+}
+
+/**
+ * @brief 输出缓冲区中的单个字节
+ */
+static void emit_byte(stream_parser_t *parser, stream_frame_t *frame, stream_frame_type_t type, uint8_t c)
+{
+    parser->buf[0] = c;
+    frame->type = type;
+    frame->len = 1;
+}
+
+size_t stream_parser_feed(stream_parser_t *parser, const uint8_t *data, size_t len, stream_frame_t *frame)
+{
+    frame->type = STREAM_FRAME_NONE;
+    frame->data = parser->buf;
+    frame->len = 0;
+    
+    size_t pos = 0;
+    while (pos < len) {
+        uint8_t c = data[pos];
+    
+        switch (parser->state) {
+            case STREAM_STATE_IDLE:
+                pos++;
+                if (is_line_end(c)) {
+                    break;      // 帧之间的空行
+                }
+                if (parser->framing == STREAM_PARSER_FRAMING_LINE) {
+                    line_begin(parser);
+                    line_append(parser, &c, 1);
+                    break;
+                }
+                if (c == BINARY_PROTOCOL_SOF) {
+                    parser->state = STREAM_STATE_BINARY;
+                    parser->buf[0] = c;
+                    parser->len = 1;
+                    parser->need = 0;
+                    break;
+                }
+                if (parser->binary_only) {
+                    break;      // 二进制连接中帧之间的杂散字节直接丢弃
+                }
+                if (c == '#') {
+                    line_begin(parser);
+                    break;
+                }
+                emit_byte(parser, frame, (c >= '0' && c <= '9') ? STREAM_FRAME_DIGIT : STREAM_FRAME_INVALID, c);
+                return pos;
+    
+            case STREAM_STATE_LINE: {
+                // 一次复制到行尾或输入末尾
+                size_t start = pos;
+                while (pos < len && !is_line_end(data[pos])) {
+                    pos++;
+                }
+                line_append(parser, data + start, pos - start);
+                if (pos == len) {
+                    return pos;
+                }
+                pos++;      // 换行符
+    
+                parser->state = STREAM_STATE_IDLE;
+                parser->buf[parser->len] = '\0';
+                frame->type = parser->overflow ? STREAM_FRAME_LINE_TOO_LONG : STREAM_FRAME_LINE;
+                frame->len = parser->len;
+                parser->len = 0;
+                return pos;
+            }
+    
+            case STREAM_STATE_BINARY:
+                if (parser->need == 0) {
+                    if (c > BINARY_PROTOCOL_MAX_PAYLOAD) {
+                        // 长度字段非法：报告帧起始字节，当前字节不消费，回到空闲状态重新判断
+                        parser->state = STREAM_STATE_IDLE;
+                        emit_byte(parser, frame, STREAM_FRAME_INVALID, BINARY_PROTOCOL_SOF);
+                        parser->len = 0;
+                        return pos;
+                    }
+                    parser->buf[parser->len++] = c;
+                    parser->need = BINARY_PROTOCOL_HEADER_LEN + c + BINARY_PROTOCOL_CRC_LEN;
+                    pos++;
+                } else {
+                    size_t copy = parser->need - parser->len;
+                    if (copy > len - pos) {
+                        copy = len - pos;
+                    }
+                    memcpy(parser->buf + parser->len, data + pos, copy);
+                    parser->len += copy;
+                    pos += copy;
+                }
+    
+                if (parser->len == parser->need) {
+                    parser->state = STREAM_STATE_IDLE;
+                    frame->type = STREAM_FRAME_BINARY;
+                    frame->len = parser->len;
+                    parser->len = 0;
+                    parser->need = 0;
+                    return pos;
+                }
+                break;
+    
+            default:
+                stream_parser_reset(parser);
+                break;
+        }
+    }
+    
+    return pos;
+}
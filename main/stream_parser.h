@@ -0,0 +1,126 @@
+/**
+ * @file stream_parser.h
+ * @brief 流式请求分帧器头文件
+ * 
+ * 每个连接一个分帧器，按任意长度的数据块依次输入，跨多个TCP段的请求和同一段中的多个请求
+ * 都能正确切分。分帧器是逐字节推进的状态机，未完成的帧保存在分帧器内部，
+ * 已消费的字节不会再次扫描；每次输入最多输出一帧，调用方循环输入剩余数据即可。
+ * 
+ * 两种分帧方式:
+ *   - 混合（命令端口）：'0'-'9' 单字节旧协议命令；'#' 开头、换行结束的标签协议行；
+ *     0xA5 开头、按头部长度字段确定帧长的二进制帧
+ *   - 按行（附加监听端口）：每个以换行结束的非空行为一帧
+ * 
+ * 行和二进制帧都有长度上限：超长的行在行尾报告一次；二进制帧的长度字段非法时立即报告，
+ * 该字节不消费，作为下一帧的开头重新判断（唯一一处重复判断的字节）。
+ * 不加锁，只能由一个任务使用
+ */
+
+#ifndef STREAM_PARSER_H
+#define STREAM_PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "binary_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STREAM_PARSER_LINE_MAX  64      /**< 单行最大长度（不含换行） */
+
+/** 帧缓冲区大小：行或二进制帧的最大长度，加上行尾的'\0' */
+#define STREAM_PARSER_BUF_SIZE  ((STREAM_PARSER_LINE_MAX > BINARY_PROTOCOL_MAX_FRAME ? \
+                                  STREAM_PARSER_LINE_MAX : BINARY_PROTOCOL_MAX_FRAME) + 1)
+
+/**
+ * @brief 分帧方式
+ */
+typedef enum {
+    STREAM_PARSER_FRAMING_MIXED = 0,    /**< 旧协议数字、标签协议行和二进制帧 */
+    STREAM_PARSER_FRAMING_LINE,         /**< 只按行分帧 */
+} stream_parser_framing_t;
+
+/**
+ * @brief 输出的帧类型
+ */
+typedef enum {
+    STREAM_FRAME_NONE = 0,              /**< 输入已全部消费，没有完整的帧 */
+    STREAM_FRAME_DIGIT,                 /**< 旧协议单字节命令，data[0]为'0'-'9' */
+    STREAM_FRAME_LINE,                  /**< 一行（混合分帧时不含行首的'#'），以'\0'结尾 */
+    STREAM_FRAME_LINE_TOO_LONG,         /**< 超长的行，data为截断后的前缀（用于取出标签回复错误） */
+    STREAM_FRAME_BINARY,                /**< 长度完整的二进制帧（CRC和内容由 binary_protocol_parse 检查） */
+    STREAM_FRAME_INVALID,               /**< 非法字节（无效的旧协议命令或二进制帧长度非法），data[0]为该字节 */
+} stream_frame_type_t;
+
+/**
+ * @brief 输出的帧，data指向分帧器内部缓冲区，下一次输入之前有效
+ */
+typedef struct {
+    stream_frame_type_t type;           /**< 帧类型 */
+    const uint8_t *data;                /**< 帧数据 */
+    size_t len;                         /**< 帧长度 */
+} stream_frame_t;
+
+/**
+ * @brief 分帧器
+ */
+typedef struct {
+    uint8_t framing;                    /**< 分帧方式（stream_parser_framing_t） */
+    uint8_t state;                      /**< 当前状态（内部使用） */
+    bool binary_only;                   /**< 只接受二进制帧，帧之间的其他字节直接丢弃 */
+    bool overflow;                      /**< 当前行超长 */
+    uint16_t len;                       /**< 缓冲区中当前帧已收到的长度 */
+    uint16_t need;                      /**< 二进制帧的总长度，长度字段到达之前为0 */
+    uint8_t buf[STREAM_PARSER_BUF_SIZE]; /**< 当前帧缓冲区 */
+} stream_parser_t;
+
+/**
+ * @brief 初始化分帧器
+ * @param parser 分帧器
+ * @param framing 分帧方式
+ */
+void stream_parser_init(stream_parser_t *parser, stream_parser_framing_t framing);
+
+/**
+ * @brief 清除未完成的帧和二进制模式，回到初始状态
+ */
+void stream_parser_reset(stream_parser_t *parser);
+
+/**
+ * @brief 进入二进制模式：此后只接受二进制帧（收到第一个有效二进制帧后由调用方设置）
+ */
+static inline void stream_parser_set_binary_only(stream_parser_t *parser)
+{
+    parser->binary_only = true;
+}
+
+/**
+ * @brief 输入数据，最多切分出一帧
+ * 
+ * 用法:
+ * @code
+ * while (len > 0) {
+ *     size_t used = stream_parser_feed(&parser, data, len, &frame);
+ *     data += used;
+ *     len -= used;
+ *     if (frame.type != STREAM_FRAME_NONE) {
+ *         // 处理frame
+ *     }
+ * }
+ * @endcode
+ * 
+ * @param parser 分帧器
+ * @param data 输入数据
+ * @param len 输入长度
+ * @param frame 输出帧，没有完整的帧时类型为 STREAM_FRAME_NONE
+ * @return 消费的字节数；输出了帧时可能小于len，否则等于len
+ */
+size_t stream_parser_feed(stream_parser_t *parser, const uint8_t *data, size_t len, stream_frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STREAM_PARSER_H
@@ -0,0 +1,395 @@
+/**
+ * @file tcp_listener.c
+ * @brief 附加TCP监听端口实现
+ * 
+ * 每个端口一个任务，阻塞在select()中等待监听socket、少量客户端连接和唤醒描述符（见 tcp_loop.h），
+ * 只在最近的空闲超时到期或被 tcp_listener_stop() 唤醒时返回。
+ * 只处理标签协议的单行请求，回复直接以非阻塞方式发送；端口任务与命令端口的任务互不等待，
+ * 命令端口积压时不影响这里的回复延迟
+ */
+
+#include "tcp_listener.h"
+#include "line_protocol.h"
+#include "stream_parser.h"
+#include "tcp_loop.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "lwip/sockets.h"
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+static const char *TAG = "TCP_LISTENER";
+
+#define TCP_LISTENER_BACKLOG            2       // 连接队列长度
+#define TCP_LISTENER_LINE_MAX           STREAM_PARSER_LINE_MAX  // 单行请求最大长度
+#define TCP_LISTENER_IDLE_TIMEOUT_MS    30000   // 默认客户端空闲超时
+#define TCP_LISTENER_STACK_SIZE         3072    // 端口任务堆栈大小
+
+// 客户端连接
+typedef struct {
+    int fd;                                 // socket描述符，-1表示空闲
+    stream_parser_t parser;                 // 按行分帧器（保存跨TCP段未收完的行）
+    TickType_t last_active;                 // 最后一次收到数据的时间
+} tcp_listener_client_t;
+
+// 监听端口
+typedef struct {
+    bool in_use;                            // 表项是否被占用（任务退出时清除）
+    volatile bool running;                  // 运行状态，清除后任务退出
+    tcp_listener_config_t config;           // 端口配置
+    command_callback_t callback;            // 命令回调
+    int listen_fd;                          // 监听socket描述符
+    int wakeup_fd;                          // 唤醒描述符，表项首次使用时创建，之后一直保留
+    bool wakeup_created;                    // 唤醒描述符是否已创建
+    tcp_listener_client_t clients[TCP_LISTENER_MAX_CLIENTS]; // 客户端连接
+} tcp_listener_t;
+
+// 全部附加监听端口的状态
+typedef struct {
+    portMUX_TYPE lock;                      // 保护表项占用和socket计数
+    tcp_listener_t listeners[TCP_LISTENER_MAX]; // 监听端口
+} tcp_listener_state_t;
+
+static tcp_listener_state_t listener_state = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+/**
+ * @brief 命令回调的回复函数，以非阻塞方式直接发送到客户端
+ */
+static int listener_reply(const tcp_request_ctx_t *ctx, const void *data, size_t len)
+{
+    ssize_t sent = send(ctx->client_fd, data, len, MSG_DONTWAIT);
+    if (sent < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        ESP_LOGW(TAG, "发送响应失败: fd=%d, %s", ctx->client_fd, strerror(errno));
+        return -1;
+    }
+    return sent;
+}
+
+/**
+ * @brief 发送一行文本回复
+ */
+static void client_send_str(tcp_listener_client_t *client, const char *response)
+{
+    const tcp_request_ctx_t ctx = {
+        .client_fd = client->fd,
+    };
+    listener_reply(&ctx, response, strlen(response));
+}
+
+/**
+ * @brief 关闭客户端连接
+ */
+static void client_close(tcp_listener_t *listener, tcp_listener_client_t *client)
+{
+    ESP_LOGI(TAG, "[%s] 客户端连接已关闭: fd=%d", listener->config.name, client->fd);
+    close(client->fd);
+    client->fd = -1;
+}
+
+/**
+ * @brief 处理一行请求 "#<tag> <cmd>"
+ */
+static void handle_line(tcp_listener_t *listener, tcp_listener_client_t *client, const stream_frame_t *frame)
+{
+    char tag[LINE_PROTOCOL_TAG_MAX_LEN + 1];
+    char response[TCP_LISTENER_LINE_MAX + 32];
+    command_t cmd;
+    
+    const char *line = (const char *)frame->data;
+    if (line[0] != LINE_PROTOCOL_PREFIX) {
+        client_send_str(client, "#? ERROR bad-tag\n");
+        return;
+    }
+    
+    line_protocol_result_t result = line_protocol_parse(line + 1, frame->len - 1, tag, &cmd);
+    
+    if (result == LINE_PROTOCOL_BAD_TAG) {
+        client_send_str(client, "#? ERROR bad-tag\n");
+        return;
+    }
+    if (frame->type == STREAM_FRAME_LINE_TOO_LONG) {
+        snprintf(response, sizeof(response), "#%s ERROR line-too-long\n", tag);
+        client_send_str(client, response);
+        return;
+    }
+    if (result != LINE_PROTOCOL_OK) {
+        snprintf(response, sizeof(response), "#%s ERROR bad-command\n", tag);
+        client_send_str(client, response);
+        return;
+    }
+    if ((listener->config.command_mask & COMMAND_MASK(cmd.type)) == 0 || listener->callback == NULL) {
+        snprintf(response, sizeof(response), "#%s ERROR unsupported\n", tag);
+        client_send_str(client, response);
+        return;
+    }
+    
+    tcp_request_ctx_t ctx = {
+        .client_fd = client->fd,
+        .conn_id = 0,
+        .format = TCP_REPLY_FORMAT_TEXT,
+        .seq = 0,
+        .reply = listener_reply,
+        .transport = NULL,
+        .perm = listener->config.perm,
+    };
+    strncpy(ctx.tag, tag, TCP_SERVER_TAG_MAX_LEN);
+    ctx.tag[TCP_SERVER_TAG_MAX_LEN] = '\0';
+    
+    listener->callback(&cmd, &ctx);
+}
+
+/**
+ * @brief 接收客户端数据并按行处理
+ */
+static void client_receive(tcp_listener_t *listener, tcp_listener_client_t *client, TickType_t now)
+{
+    char buffer[64];
+    ssize_t len = recv(client->fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    
+    if (len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        client_close(listener, client);
+        return;
+    }
+    if (len < 0) {
+        return;
+    }
+    
+    client->last_active = now;
+    const uint8_t *data = (const uint8_t *)buffer;
+    size_t remaining = (size_t)len;
+    while (remaining > 0 && client->fd >= 0) {
+        stream_frame_t frame;
+        size_t used = stream_parser_feed(&client->parser, data, remaining, &frame);
+        data += used;
+        remaining -= used;
+        if (frame.type != STREAM_FRAME_NONE) {
+            handle_line(listener, client, &frame);
+        }
+    }
+}
+
+/**
+ * @brief 接受新连接，没有空闲位置时拒绝
+ * @return true 接受了新连接
+ */
+static bool accept_client(tcp_listener_t *listener, TickType_t now)
+{
+    struct sockaddr_in client_addr;
+    int fd = tcp_loop_accept(listener->listen_fd, true, &client_addr);
+    if (fd < 0) {
+        return false;
+    }
+    
+    tcp_listener_client_t *client = NULL;
+    for (int i = 0; i < listener->config.max_clients; i++) {
+        if (listener->clients[i].fd < 0) {
+            client = &listener->clients[i];
+            break;
+        }
+    }
+    if (client == NULL) {
+        ESP_LOGW(TAG, "[%s] 连接数已达上限(%d)，拒绝连接", listener->config.name, listener->config.max_clients);
+        tcp_loop_reject(fd, true);
+        return false;
+    }
+    
+    client->fd = fd;
+    stream_parser_init(&client->parser, STREAM_PARSER_FRAMING_LINE);
+    client->last_active = now;
+    
+    char ip[16];
+    inet_ntoa_r(client_addr.sin_addr, ip, sizeof(ip));
+    ESP_LOGI(TAG, "[%s] 客户端连接成功: fd=%d, IP: %s", listener->config.name, fd, ip);
+    return true;
+}
+
+/**
+ * @brief 端口任务
+ */
+static void tcp_listener_task(void *pvParameters)
+{
+    tcp_listener_t *listener = pvParameters;
+    TickType_t idle_timeout = pdMS_TO_TICKS(listener->config.idle_timeout_ms);
+    
+    ESP_LOGI(TAG, "[%s] 端口任务启动，端口 %d", listener->config.name, listener->config.port);
+    
+    TickType_t next_timeout = portMAX_DELAY;
+    while (listener->running) {
+        tcp_loop_fds_t fds;
+        tcp_loop_fds_init(&fds, listener->wakeup_fd);
+        tcp_loop_watch_read(&fds, listener->listen_fd);
+        for (int i = 0; i < listener->config.max_clients; i++) {
+            if (listener->clients[i].fd >= 0) {
+                tcp_loop_watch_read(&fds, listener->clients[i].fd);
+            }
+        }
+    
+        // 没有客户端时一直等待，有客户端时等到最近的空闲超时
+        int ready = tcp_loop_wait(&fds, next_timeout);
+        if (ready < 0) {
+            continue;
+        }
+    
+        // 先处理已有连接（同一轮中断开的连接先释放位置），再接受新连接
+        TickType_t now = xTaskGetTickCount();
+        next_timeout = portMAX_DELAY;
+        for (int i = 0; i < listener->config.max_clients; i++) {
+            tcp_listener_client_t *client = &listener->clients[i];
+            if (client->fd < 0) {
+                continue;
+            }
+            if (ready > 0 && FD_ISSET(client->fd, &fds.read_fds)) {
+                client_receive(listener, client, now);
+                if (client->fd < 0) {
+                    continue;
+                }
+            }
+            TickType_t idle = now - client->last_active;
+            if (idle >= idle_timeout) {
+                ESP_LOGI(TAG, "[%s] 客户端空闲超时: fd=%d", listener->config.name, client->fd);
+                client_close(listener, client);
+            } else if (idle_timeout - idle < next_timeout) {
+                next_timeout = idle_timeout - idle;
+            }
+        }
+        if (ready > 0 && FD_ISSET(listener->listen_fd, &fds.read_fds) && accept_client(listener, now)) {
+            next_timeout = idle_timeout < next_timeout ? idle_timeout : next_timeout;
+        }
+    }
+    
+    // 关闭所有连接并归还socket额度
+    for (int i = 0; i < listener->config.max_clients; i++) {
+        if (listener->clients[i].fd >= 0) {
+            client_close(listener, &listener->clients[i]);
+        }
+    }
+    close(listener->listen_fd);
+    listener->listen_fd = -1;
+    ESP_LOGI(TAG, "[%s] 端口任务退出", listener->config.name);
+    
+    portENTER_CRITICAL(&listener_state.lock);
+    listener->in_use = false;
+    portEXIT_CRITICAL(&listener_state.lock);
+    
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 查找端口对应的表项
+ */
+static tcp_listener_t *find_listener(uint16_t port)
+{
+    for (int i = 0; i < TCP_LISTENER_MAX; i++) {
+        tcp_listener_t *listener = &listener_state.listeners[i];
+        if (listener->in_use && listener->config.port == port) {
+            return listener;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t tcp_listener_start(const tcp_listener_config_t *config, command_callback_t callback)
+{
+    if (config == NULL || config->name == NULL || config->port == 0 ||
+        config->max_clients == 0 || config->max_clients > TCP_LISTENER_MAX_CLIENTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // 分配表项（socket预算按 TCP_LISTENER_MAX 个端口各 1 + TCP_LISTENER_MAX_CLIENTS 个预留）
+    tcp_listener_t *listener = NULL;
+    portENTER_CRITICAL(&listener_state.lock);
+    if (find_listener(config->port) == NULL) {
+        for (int i = 0; i < TCP_LISTENER_MAX; i++) {
+            if (!listener_state.listeners[i].in_use) {
+                listener = &listener_state.listeners[i];
+                listener->in_use = true;
+                listener->config.port = config->port;
+                break;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&listener_state.lock);
+    
+    if (listener == NULL) {
+        ESP_LOGE(TAG, "[%s] 无法启动端口 %d：端口已在使用，或端口数超出上限", config->name, config->port);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    listener->config = *config;
+    if (listener->config.idle_timeout_ms == 0) {
+        listener->config.idle_timeout_ms = TCP_LISTENER_IDLE_TIMEOUT_MS;
+    }
+    // 回复都是同步的，不支持事件订阅
+    listener->config.command_mask &= ~(COMMAND_MASK(COMMAND_TYPE_SUBSCRIBE) | COMMAND_MASK(COMMAND_TYPE_UNSUBSCRIBE));
+    listener->callback = callback;
+    for (int i = 0; i < TCP_LISTENER_MAX_CLIENTS; i++) {
+        listener->clients[i].fd = -1;
+    }
+    
+    // 唤醒描述符在表项首次使用时创建并一直保留，停止端口时不会写入已关闭的描述符
+    if (!listener->wakeup_created && tcp_loop_wakeup_create(&listener->wakeup_fd) == ESP_OK) {
+        listener->wakeup_created = true;
+    }
+    
+    listener->listen_fd = listener->wakeup_created ? tcp_loop_listen(config->port, TCP_LISTENER_BACKLOG) : -1;
+    if (listener->listen_fd >= 0) {
+        listener->running = true;
+        BaseType_t ret = xTaskCreatePinnedToCore(
+            tcp_listener_task,          // 任务函数
+            config->name,               // 任务名称
+            TCP_LISTENER_STACK_SIZE,    // 堆栈大小
+            listener,                   // 参数
+            config->task_priority,      // 优先级
+            NULL,                       // 任务句柄
+            config->core_id < 0 ? tskNO_AFFINITY : config->core_id // 绑定的核心
+        );
+        if (ret == pdPASS) {
+            ESP_LOGI(TAG, "[%s] 监听端口 %d，优先级 %u，核心 %d，命令集合 0x%08x", config->name, config->port,
+                     config->task_priority, config->core_id, (unsigned)listener->config.command_mask);
+            return ESP_OK;
+        }
+        ESP_LOGE(TAG, "[%s] 创建任务失败", config->name);
+        listener->running = false;
+        close(listener->listen_fd);
+        listener->listen_fd = -1;
+    }
+    
+    portENTER_CRITICAL(&listener_state.lock);
+    listener->in_use = false;
+    portEXIT_CRITICAL(&listener_state.lock);
+    return ESP_FAIL;
+}
+
+void tcp_listener_stop(uint16_t port)
+{
+    int wakeup_fd = -1;
+    portENTER_CRITICAL(&listener_state.lock);
+    tcp_listener_t *listener = find_listener(port);
+    if (listener != NULL) {
+        listener->running = false;
+        wakeup_fd = listener->wakeup_fd;
+    }
+    portEXIT_CRITICAL(&listener_state.lock);
+    
+    if (listener != NULL) {
+        // 唤醒阻塞在select中的端口任务，它随即关闭所有连接并退出
+        tcp_loop_wakeup(wakeup_fd);
+        ESP_LOGI(TAG, "停止端口 %d", port);
+    }
+}
+
+bool tcp_listener_is_running(uint16_t port)
+{
+    portENTER_CRITICAL(&listener_state.lock);
+    tcp_listener_t *listener = find_listener(port);
+    bool running = listener != NULL && listener->running;
+    portEXIT_CRITICAL(&listener_state.lock);
+    return running;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file tcp_listener.h
+ * @brief 附加TCP监听端口头文件
+ * 
+ * 主控制端口（tcp_server.h）之外的轻量监听端口，每个端口有自己的任务、优先级、
+ * 绑定核心和命令集合。典型用法是一个只读状态端口：以高于命令端口的优先级运行在另一个核心上，
+ * 只接受STATUS，命令端口被大量投喂命令占满时健康检查仍能及时得到回复。
+ * 
+ * 协议为 tcp_server.h 的标签协议 "#<tag> <cmd>\n"（不支持旧的单字节命令、二进制帧和事件订阅），
+ * 回复在命令回调中同步发出；请求上下文的 conn_id 为0，命令回调不会发出完成回复
+ */
+
+#ifndef TCP_LISTENER_H
+#define TCP_LISTENER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "command.h"
+#include "tcp_server.h"
+#include "socket_budget.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 监听端口配置
+ */
+typedef struct {
+    const char *name;           /**< 名称，用作任务名和日志（需在端口运行期间保持有效） */
+    uint16_t port;              /**< 端口号 */
+    uint8_t task_priority;      /**< 任务优先级 */
+    int8_t core_id;             /**< 任务绑定的核心，-1表示不绑定 */
+    uint32_t command_mask;      /**< 接受的命令集合（COMMAND_MASK位），其他命令回复unsupported */
+    command_perm_t perm;        /**< 客户端的权限 */
+    uint8_t max_clients;        /**< 同时连接的客户端数，1 - TCP_LISTENER_MAX_CLIENTS */
+    uint16_t idle_timeout_ms;   /**< 客户端空闲超时，0表示使用默认值 */
+} tcp_listener_config_t;
+
+/**
+ * @brief 只读状态端口的默认配置：只接受STATUS，优先级6（高于命令端口），绑定核心1，
+ * 最多1个客户端（占用2个socket），空闲10秒断开
+ */
+#define TCP_LISTENER_STATUS_CONFIG(listen_port)         \
+    {                                                   \
+        .name = "status_listener",                      \
+        .port = (listen_port),                          \
+        .task_priority = 6,                             \
+        .core_id = 1,                                   \
+        .command_mask = COMMAND_MASK_READ_ONLY,         \
+        .perm = COMMAND_PERM_READ,                      \
+        .max_clients = 1,                               \
+        .idle_timeout_ms = 10000,                       \
+    }
+
+/**
+ * @brief 创建监听socket并启动端口任务
+ * 
+ * 每个端口占用 1 + max_clients 个socket，最多 TCP_LISTENER_MAX 个端口，预算见 socket_budget.h
+ * 
+ * @param config 端口配置
+ * @param callback 命令回调（与其他控制通道使用同一回调）
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误，ESP_ERR_NO_MEM 端口数超出上限，
+ *         ESP_FAIL 创建socket或任务失败
+ */
+esp_err_t tcp_listener_start(const tcp_listener_config_t *config, command_callback_t callback);
+
+/**
+ * @brief 停止监听端口，立即返回（端口任务被唤醒后关闭所有连接并退出）
+ * @param port 端口号
+ */
+void tcp_listener_stop(uint16_t port);
+
+/**
+ * @brief 获取端口运行状态
+ * @param port 端口号
+ * @return true 运行中
+ */
+bool tcp_listener_is_running(uint16_t port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TCP_LISTENER_H
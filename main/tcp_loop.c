@@ -0,0 +1,213 @@
+/**
+ * @file tcp_loop.c
+ * @brief TCP端口公用的监听、接受连接和select事件循环辅助函数实现
+ */
+
+#include "tcp_loop.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_vfs_eventfd.h"
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+static const char *TAG = "TCP_LOOP";
+
+#define TCP_LOOP_REJECT_MESSAGE     "ERROR: Too many clients\n"
+#define TCP_LOOP_ERROR_DELAY_MS     100     // select失败后的延时，避免空转
+
+/**
+ * @brief 设置socket为非阻塞模式
+ */
+static int set_socket_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1) {
+        return -1;
+    }
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+int tcp_loop_listen(uint16_t port, int backlog)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "创建socket失败: %s", strerror(errno));
+        return -1;
+    }
+    
+    // 允许地址复用，重启端口时不必等待旧连接的TIME_WAIT
+    int opt = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        ESP_LOGW(TAG, "设置SO_REUSEADDR失败: %s", strerror(errno));
+    }
+    
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(port);
+    
+    if (bind(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        ESP_LOGE(TAG, "绑定端口 %d 失败: %s", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    
+    // 监听socket设为非阻塞，避免select返回后accept阻塞事件循环
+    if (set_socket_nonblocking(fd) < 0) {
+        ESP_LOGW(TAG, "设置非阻塞模式失败: %s", strerror(errno));
+    }
+    
+    if (listen(fd, backlog) < 0) {
+        ESP_LOGE(TAG, "监听端口 %d 失败: %s", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    
+    ESP_LOGI(TAG, "监听端口 %d: fd=%d", port, fd);
+    return fd;
+}
+
+int tcp_loop_accept(int listen_fd, bool nodelay, struct sockaddr_in *addr)
+{
+    socklen_t addr_len = sizeof(*addr);
+    int fd = accept(listen_fd, (struct sockaddr*)addr, &addr_len);
+    if (fd < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            ESP_LOGE(TAG, "接受连接失败: %s", strerror(errno));
+        }
+        return -1;
+    }
+    
+    // 客户端socket上的收发都不能阻塞事件循环
+    if (set_socket_nonblocking(fd) < 0) {
+        ESP_LOGW(TAG, "设置客户端socket为非阻塞模式失败: %s", strerror(errno));
+    }
+    
+    if (nodelay) {
+        int opt = 1;
+        if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt)) < 0) {
+            ESP_LOGW(TAG, "设置TCP_NODELAY失败: %s", strerror(errno));
+        }
+    }
+    return fd;
+}
+
+uint32_t tcp_loop_peer_addr(int fd)
+{
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+    if (getpeername(fd, (struct sockaddr *)&addr, &addr_len) < 0) {
+        return 0;
+    }
+    
+    if (addr.ss_family == AF_INET) {
+        return ((struct sockaddr_in *)&addr)->sin_addr.s_addr;
+    }
+#if defined(AF_INET6) && (!defined(LWIP_IPV6) || LWIP_IPV6)
+    if (addr.ss_family == AF_INET6) {
+        const struct sockaddr_in6 *addr6 = (const struct sockaddr_in6 *)&addr;
+        const uint8_t *bytes = (const uint8_t *)&addr6->sin6_addr;
+        static const uint8_t v4_mapped[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF };
+        if (memcmp(bytes, v4_mapped, sizeof(v4_mapped)) == 0) {
+            uint32_t v4;
+            memcpy(&v4, bytes + 12, sizeof(v4));
+            return v4;
+        }
+    }
+#endif
+    return 0;
+}
+
+void tcp_loop_reject(int fd, bool notify)
+{
+    if (notify) {
+        send(fd, TCP_LOOP_REJECT_MESSAGE, sizeof(TCP_LOOP_REJECT_MESSAGE) - 1, MSG_DONTWAIT);
+    }
+    close(fd);
+}
+
+esp_err_t tcp_loop_wakeup_create(int *wakeup_fd)
+{
+    // 驱动只需注册一次，之后的调用返回 ESP_ERR_INVALID_STATE
+    esp_vfs_eventfd_config_t eventfd_config = {
+        .max_fds = TCP_LOOP_WAKEUP_MAX,
+    };
+    esp_err_t err = esp_vfs_eventfd_register(&eventfd_config);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "注册eventfd失败: %s", esp_err_to_name(err));
+        return err;
+    }
+    
+    int fd = eventfd(0, 0);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "创建eventfd失败: %s", strerror(errno));
+        return ESP_FAIL;
+    }
+    *wakeup_fd = fd;
+    return ESP_OK;
+}
+
+void tcp_loop_wakeup(int wakeup_fd)
+{
+    if (wakeup_fd >= 0) {
+        uint64_t value = 1;
+        write(wakeup_fd, &value, sizeof(value));
+    }
+}
+
+void tcp_loop_fds_init(tcp_loop_fds_t *fds, int wakeup_fd)
+{
+    FD_ZERO(&fds->read_fds);
+    FD_ZERO(&fds->write_fds);
+    fds->max_fd = -1;
+    fds->wakeup_fd = wakeup_fd;
+    if (wakeup_fd >= 0) {
+        tcp_loop_watch_read(fds, wakeup_fd);
+    }
+}
+
+void tcp_loop_watch_read(tcp_loop_fds_t *fds, int fd)
+{
+    FD_SET(fd, &fds->read_fds);
+    if (fd > fds->max_fd) {
+        fds->max_fd = fd;
+    }
+}
+
+void tcp_loop_watch_write(tcp_loop_fds_t *fds, int fd)
+{
+    FD_SET(fd, &fds->write_fds);
+    if (fd > fds->max_fd) {
+        fds->max_fd = fd;
+    }
+}
+
+int tcp_loop_wait(tcp_loop_fds_t *fds, TickType_t timeout)
+{
+    struct timeval tv;
+    struct timeval *tv_ptr = NULL;
+    if (timeout != portMAX_DELAY) {
+        uint32_t timeout_ms = pdTICKS_TO_MS(timeout);
+        tv.tv_sec = timeout_ms / 1000;
+        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        tv_ptr = &tv;
+    }
+    
+    int ready = select(fds->max_fd + 1, &fds->read_fds, &fds->write_fds, NULL, tv_ptr);
+    if (ready < 0) {
+        if (errno != EINTR) {
+            ESP_LOGE(TAG, "select失败: %s", strerror(errno));
+            vTaskDelay(pdMS_TO_TICKS(TCP_LOOP_ERROR_DELAY_MS));
+        }
+        return -1;
+    }
+    
+    // 唤醒事件：清除计数，由调用方随后检查运行状态
+    if (ready > 0 && fds->wakeup_fd >= 0 && FD_ISSET(fds->wakeup_fd, &fds->read_fds)) {
+        uint64_t value;
+        read(fds->wakeup_fd, &value, sizeof(value));
+    }
+    return ready;
+}
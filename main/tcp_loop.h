@@ -0,0 +1,113 @@
+/**
+ * @file tcp_loop.h
+ * @brief TCP端口公用的监听、接受连接和select事件循环辅助函数
+ * 
+ * 命令端口（tcp_server.c）和附加监听端口（tcp_listener.c）都是一个任务阻塞在select中：
+ * 创建非阻塞监听socket、接受或拒绝连接、构建描述符集合并等待都在这里实现。
+ * 每个事件循环带一个eventfd唤醒描述符，其他任务写入它即可立即唤醒select
+ * （停止端口、发布事件时），不需要靠select超时轮询运行状态。
+ * 唤醒描述符由VFS的eventfd驱动提供，不占用lwIP socket，数量上限见 TCP_LOOP_WAKEUP_MAX
+ */
+
+#ifndef TCP_LOOP_H
+#define TCP_LOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "lwip/sockets.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TCP_LOOP_WAKEUP_MAX     5   /**< eventfd驱动可创建的描述符数量（命令端口1个，每个附加监听端口1个） */
+
+/**
+ * @brief 一次select等待的描述符集合
+ */
+typedef struct {
+    fd_set read_fds;            /**< 等待可读的描述符，select返回后为可读的描述符 */
+    fd_set write_fds;           /**< 等待可写的描述符，select返回后为可写的描述符 */
+    int max_fd;                 /**< 集合中最大的描述符 */
+    int wakeup_fd;              /**< 唤醒描述符，-1表示没有 */
+} tcp_loop_fds_t;
+
+/**
+ * @brief 创建非阻塞的监听socket（允许地址复用）
+ * @param port 端口号
+ * @param backlog 连接队列长度
+ * @return socket描述符，-1表示失败
+ */
+int tcp_loop_listen(uint16_t port, int backlog);
+
+/**
+ * @brief 接受一个新连接并设为非阻塞
+ * @param listen_fd 监听socket
+ * @param nodelay 是否设置TCP_NODELAY
+ * @param addr 输出客户端地址
+ * @return 客户端socket描述符，-1表示没有待接受的连接或失败
+ */
+int tcp_loop_accept(int listen_fd, bool nodelay, struct sockaddr_in *addr);
+
+/**
+ * @brief 获取连接对端的IPv4地址（IPv6套接字上的IPv4映射地址也返回其IPv4部分）
+ * @param fd 连接socket描述符
+ * @return IPv4地址（网络字节序），0表示无法取得
+ */
+uint32_t tcp_loop_peer_addr(int fd);
+
+/**
+ * @brief 拒绝连接：以非阻塞方式发送 "ERROR: Too many clients" 后关闭
+ * @param fd 客户端socket描述符
+ * @param notify 是否发送提示（TLS端口上不能发送明文）
+ */
+void tcp_loop_reject(int fd, bool notify);
+
+/**
+ * @brief 创建唤醒描述符（首次调用时注册eventfd驱动）
+ * @param wakeup_fd 输出唤醒描述符
+ * @return ESP_OK 成功；其他值表示注册驱动或创建描述符失败
+ */
+esp_err_t tcp_loop_wakeup_create(int *wakeup_fd);
+
+/**
+ * @brief 唤醒阻塞在select中的任务，可以从任何任务调用
+ * @param wakeup_fd 唤醒描述符，小于0时不做任何事
+ */
+void tcp_loop_wakeup(int wakeup_fd);
+
+/**
+ * @brief 清空描述符集合并加入唤醒描述符
+ * @param fds 描述符集合
+ * @param wakeup_fd 唤醒描述符，-1表示没有
+ */
+void tcp_loop_fds_init(tcp_loop_fds_t *fds, int wakeup_fd);
+
+/**
+ * @brief 等待描述符可读
+ */
+void tcp_loop_watch_read(tcp_loop_fds_t *fds, int fd);
+
+/**
+ * @brief 等待描述符可写
+ */
+void tcp_loop_watch_write(tcp_loop_fds_t *fds, int fd);
+
+/**
+ * @brief 阻塞在select中，直到有描述符就绪、被唤醒或超时
+ * 
+ * 被唤醒时清除唤醒计数，调用方随后检查运行状态。select失败时记录日志并短暂延时，避免空转
+ * 
+ * @param fds 描述符集合，返回后只保留就绪的描述符
+ * @param timeout 超时tick数，0表示不等待，portMAX_DELAY表示一直等待
+ * @return 就绪的描述符数（含唤醒描述符），0表示超时，-1表示select失败
+ */
+int tcp_loop_wait(tcp_loop_fds_t *fds, TickType_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TCP_LOOP_H
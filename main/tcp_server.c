@@ -3,127 +3,858 @@
  * @brief TCP服务器实现
  * 
  * 实现TCP服务器功能，用于接收控制信号(0-9)
+ * 基于select()的事件循环，支持多个客户端同时保持长连接
+ * 支持旧的单字节命令、带标签的流水线行协议和二进制帧协议
+ * 订阅了事件流的连接在事件循环中被推送状态事件
+ * 连接状态保存在静态的连接槽位池中（见 conn_pool.h），建立和关闭连接不分配堆内存
+ * 所有响应都先写入连接的发送缓冲区，再以非阻塞方式发送，发不完的部分在socket可写时继续发送；
+ * 接收过慢、积压超过上限的连接被断开，不会拖住事件循环和其他连接
+ * 可选的TLS监听端口使用同一套连接槽位和命令协议，收发经过 tls_session.h 中的TLS会话
  */
 
 #include "tcp_server.h"
+#include "line_protocol.h"
+#include "binary_protocol.h"
+#include "command_admission.h"
+#include "command_handlers.h"
+#include "event_stream.h"
+#include "conn_pool.h"
+#include "tls_session.h"
+#include "tcp_loop.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
 #include "esp_err.h"
 #include "lwip/sockets.h"
 #include "lwip/netdb.h"
 #include <string.h>
+#include <stdio.h>
 #include <unistd.h>
-#include <fcntl.h>
 
 static const char *TAG = "TCP_SERVER";
 
 #define TCP_SERVER_BACKLOG     5      // 连接队列长度
-#define TCP_SERVER_BUFFER_SIZE 64     // 接收缓冲区大小
+
+#define TCP_SERVER_MAX_CLIENTS        CONN_POOL_SIZE  // 最大客户端数量，由连接池大小决定
+#define TCP_SERVER_IDLE_TIMEOUT_MS    60000   // 客户端空闲超时时间
+#define TCP_SERVER_STOP_TIMEOUT_MS    2000    // 停止服务器时等待任务退出的最长时间
+#define TCP_SERVER_LINE_MAX           STREAM_PARSER_LINE_MAX  // 标签协议单行最大长度
+#define TCP_SERVER_LAG_MAX_LEN        24      // 事件丢失提示的最大长度
+#define TCP_SERVER_RX_ROUNDS          8       // 一次处理连接输入时最多接收的次数，避免一个连接占住事件循环
+
+// 客户端连接即连接池槽位
+typedef conn_slot_t tcp_client_t;
 
 // TCP服务器状态
 typedef struct {
     int server_fd;              // 服务器socket描述符
     uint16_t port;              // 服务器端口
-    bool running;               // 运行状态
+    int tls_fd;                 // TLS监听socket描述符，-1表示未启用
+    uint16_t tls_port;          // TLS监听端口
+    volatile bool running;      // 运行状态
+    int wakeup_fd;              // 唤醒事件描述符(eventfd)，用于从其他任务唤醒select
+    TaskHandle_t task;          // 服务器任务句柄
+    SemaphoreHandle_t stopped;  // 服务器任务退出信号
     command_callback_t callback; // 命令回调函数
+    tcp_server_options_t options; // 服务器选项
+    SemaphoreHandle_t lock;     // 保护连接池和未完成命令计数（其他任务按连接ID回复时使用）
+    uint32_t tx_abort_count;    // 因发送积压超限被断开的连接数
+    uint32_t next_conn_id;      // 下一个连接ID
 } tcp_server_state_t;
 
 static tcp_server_state_t server_state = {
     .server_fd = -1,
     .port = 0,
+    .tls_fd = -1,
+    .tls_port = 0,
     .running = false,
+    .wakeup_fd = -1,
+    .task = NULL,
+    .stopped = NULL,
     .callback = NULL,
+    .options = TCP_SERVER_DEFAULT_OPTIONS(),
+    .lock = NULL,
+    .next_conn_id = 1,
 };
 
 /**
- * @brief 设置socket为非阻塞模式
+ * @brief 关闭客户端连接并释放连接池槽位
+ */
+static void client_close(tcp_client_t *client)
+{
+    if (client->state == CONN_STATE_FREE) {
+        return;
+    }
+    
+    xSemaphoreTake(server_state.lock, portMAX_DELAY);
+    if (client->tls != NULL) {
+        tls_session_free(client->tls);
+        client->tls = NULL;
+    }
+    close(client->fd);
+    ESP_LOGI(TAG, "客户端连接已关闭: fd=%d (%s:%d), 收/发 %u/%u 字节, 命令 %u 条, 最大积压 %u 字节",
+             client->fd, client->ip, client->port, (unsigned)client->stats.rx_bytes,
+             (unsigned)client->stats.tx_bytes, (unsigned)client->stats.commands,
+             (unsigned)client->stats.tx_peak);
+    conn_pool_release(client);
+    xSemaphoreGive(server_state.lock);
+}
+
+/**
+ * @brief 接受新的客户端连接并加入连接表
+ * @param listen_fd 监听socket
+ * @param tls 是否为TLS监听端口，是则为连接创建TLS会话并开始握手
+ */
+static void accept_new_client(int listen_fd, bool tls)
+{
+    struct sockaddr_in client_addr;
+    int client_fd = tcp_loop_accept(listen_fd, server_state.options.nodelay, &client_addr);
+    if (client_fd < 0) {
+        return;
+    }
+    
+    // 从连接池分配槽位
+    xSemaphoreTake(server_state.lock, portMAX_DELAY);
+    tcp_client_t *client = conn_pool_acquire(client_fd, server_state.next_conn_id);
+    if (client != NULL) {
+        server_state.next_conn_id++;
+        if (server_state.next_conn_id == 0) {
+            server_state.next_conn_id = 1;  // 0保留为无效ID
+        }
+    }
+    xSemaphoreGive(server_state.lock);
+    
+    if (client == NULL) {
+        ESP_LOGW(TAG, "连接数已达上限(%d)，拒绝连接: fd=%d", TCP_SERVER_MAX_CLIENTS, client_fd);
+        tcp_loop_reject(client_fd, !tls);
+        return;
+    }
+    
+    client->port = ntohs(client_addr.sin_port);
+    client->addr = client_addr.sin_addr.s_addr;
+    inet_ntoa_r(client_addr.sin_addr, client->ip, sizeof(client->ip));
+    
+    if (tls) {
+        client->tls = tls_session_new(client_fd);
+        if (client->tls == NULL) {
+            client_close(client);
+            return;
+        }
+        client->handshaking = true;
+    }
+    
+    ESP_LOGI(TAG, "客户端连接成功: fd=%d, IP: %s, 端口: %d%s", client_fd, client->ip, client->port,
+             tls ? " (TLS)" : "");
+}
+
+/**
+ * @brief 从连接接收数据（TLS连接返回解密后的数据）
+ */
+static ssize_t conn_recv(tcp_client_t *client, void *buf, size_t len)
+{
+    if (client->tls != NULL) {
+        return tls_session_read(client->tls, buf, len);
+    }
+    return recv(client->fd, buf, len, 0);
+}
+
+/**
+ * @brief 以非阻塞方式向连接发送数据（TLS连接加密后发送）
+ */
+static ssize_t conn_send(tcp_client_t *client, const void *data, size_t len)
+{
+    if (client->tls != NULL) {
+        return tls_session_write(client->tls, data, len);
+    }
+    return send(client->fd, data, len, MSG_DONTWAIT);
+}
+
+/**
+ * @brief 连接中是否有已从socket读出、尚未处理的数据（TLS记录解密后剩余的部分）
+ */
+static bool conn_has_buffered_input(tcp_client_t *client)
+{
+    return client->tls != NULL && !client->handshaking && tls_session_pending(client->tls) > 0;
+}
+
+/**
+ * @brief 连接允许积压的未发送字节数
+ */
+static size_t tx_backlog_limit(const tcp_client_t *client)
+{
+    size_t limit = server_state.options.max_tx_backlog;
+    return (limit == 0 || limit > client->tx.size) ? client->tx.size : limit;
+}
+
+/**
+ * @brief 标记连接待断开（调用方持有锁），由服务器任务在本轮事件循环结束时关闭
+ */
+static void client_abort_locked(tcp_client_t *client, const char *reason)
+{
+    if (client->state != CONN_STATE_OPEN && client->state != CONN_STATE_DRAINING) {
+        return;
+    }
+    ESP_LOGW(TAG, "断开连接: fd=%d (%s), %s, 积压 %u 字节", client->fd, client->ip, reason,
+             (unsigned)byte_ring_used(&client->tx));
+    client->state = CONN_STATE_ABORTING;
+}
+
+/**
+ * @brief 追加数据到连接的发送缓冲区（调用方持有锁）
+ * 
+ * 积压超过上限时不写入，连接被标记为待断开
+ * @return 写入的字节数，-1表示连接不可写或积压超限
  */
-static int set_socket_nonblocking(int fd)
+static int tx_enqueue_locked(tcp_client_t *client, const void *data, size_t len)
 {
-    int flags = fcntl(fd, F_GETFL, 0);
-    if (flags == -1) {
+    if (client->state != CONN_STATE_OPEN) {
+        return -1;
+    }
+    
+    size_t backlog = byte_ring_used(&client->tx) + len;
+    if (backlog > tx_backlog_limit(client)) {
+        server_state.tx_abort_count++;
+        client_abort_locked(client, "发送积压超限");
         return -1;
     }
-    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    
+    byte_ring_write(&client->tx, data, len);
+    if (backlog > client->stats.tx_peak) {
+        client->stats.tx_peak = backlog;
+    }
+    return len;
+}
+
+/**
+ * @brief 以非阻塞方式发送发送缓冲区中的数据，发不完的部分留待socket可写时继续发送
+ * 
+ * 发送缓冲区也会被其他任务按连接ID写入，整个过程持有锁；send不阻塞，持锁时间很短
+ * @return false 发送出错，连接已被标记为待断开
+ */
+static bool client_send_pending(tcp_client_t *client)
+{
+    bool ok = true;
+    
+    xSemaphoreTake(server_state.lock, portMAX_DELAY);
+    while (byte_ring_used(&client->tx) > 0) {
+        size_t len;
+        const uint8_t *data = byte_ring_read_ptr(&client->tx, &len);
+        ssize_t sent = conn_send(client, data, len);
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ESP_LOGE(TAG, "发送失败: fd=%d, %s", client->fd, strerror(errno));
+                client_abort_locked(client, "发送出错");
+                ok = false;
+            }
+            break;  // 发送窗口已满，等待socket可写
+        }
+        client->stats.tx_bytes += sent;
+        byte_ring_consume(&client->tx, sent);
+    }
+    xSemaphoreGive(server_state.lock);
+    
+    return ok;
+}
+
+/**
+ * @brief 写入响应到客户端
+ * 
+ * 响应追加到发送缓冲区，按发送策略立即尝试发送，或在本批输入处理完后统一发送。
+ * 缓冲区放不下时先尝试发送已积压的数据，仍然超出积压上限则断开该连接
+ */
+static int client_write(tcp_client_t *client, const void *data, size_t len)
+{
+    if (byte_ring_used(&client->tx) + len > tx_backlog_limit(client)) {
+        client_send_pending(client);
+    }
+    
+    xSemaphoreTake(server_state.lock, portMAX_DELAY);
+    int written = tx_enqueue_locked(client, data, len);
+    xSemaphoreGive(server_state.lock);
+    
+    if (written > 0 && server_state.options.flush_policy == TCP_SERVER_FLUSH_IMMEDIATE) {
+        client_send_pending(client);
+    }
+    return written;
+}
+
+/**
+ * @brief 写入字符串响应到客户端
+ */
+static int client_write_str(tcp_client_t *client, const char *response)
+{
+    return client_write(client, response, strlen(response));
+}
+
+/**
+ * @brief 命令回调的回复函数，写入发起请求的连接
+ */
+static int client_reply(const tcp_request_ctx_t *ctx, const void *data, size_t len)
+{
+    return client_write(ctx->transport, data, len);
+}
+
+/**
+ * @brief 把服务器选项中的限流参数应用到全部通道共用的准入控制，并重置令牌桶
+ */
+static void apply_admission_options(const tcp_server_options_t *options)
+{
+    const command_admission_config_t config = {
+        .rate_per_ip = options->rate_per_ip,
+        .burst_per_ip = options->burst_per_ip,
+        .rate_global = options->rate_global,
+        .burst_global = options->burst_global,
+        .max_inflight_total = options->max_inflight_total,
+        .inflight_retry_ms = options->inflight_retry_ms,
+    };
+    command_admission_configure(&config);
+}
+
+/**
+ * @brief 命令准入检查：本连接的未完成命令数上限，再经过全部通道共用的准入控制（见 command_admission.h）
+ * 
+ * 连接的未完成命令数只由服务器任务增加，其他任务只会减少它，检查和增加之间不会被超过上限。
+ * 通过时占用一个全局未完成命令计数，在动作完成或命令未进入执行时释放
+ * 
+ * @param client 客户端
+ * @param retry_after_ms 拒绝时输出建议的重试等待时间
+ * @return true 允许执行
+ */
+static bool admit_command(tcp_client_t *client, uint32_t *retry_after_ms)
+{
+    const tcp_server_options_t *options = &server_state.options;
+    
+    xSemaphoreTake(server_state.lock, portMAX_DELAY);
+    bool conn_full = options->max_inflight_per_conn > 0 && client->inflight >= options->max_inflight_per_conn;
+    xSemaphoreGive(server_state.lock);
+    if (conn_full) {
+        *retry_after_ms = options->inflight_retry_ms;
+        return false;
+    }
+    
+    if (!command_admission_acquire(client->addr, true, retry_after_ms)) {
+        return false;
+    }
+    
+    xSemaphoreTake(server_state.lock, portMAX_DELAY);
+    client->inflight++;
+    xSemaphoreGive(server_state.lock);
+    return true;
+}
+
+/**
+ * @brief 处理订阅/取消订阅事件流，仅支持文本协议
+ */
+static void handle_subscription(tcp_client_t *client, const command_t *cmd, const char *tag,
+                                tcp_reply_format_t format, uint16_t seq)
+{
+    char response[TCP_SERVER_LINE_MAX + 32];
+    
+    if (format == TCP_REPLY_FORMAT_BINARY) {
+        uint8_t reply[BINARY_PROTOCOL_MAX_FRAME];
+        size_t len = binary_protocol_encode_reply(reply, sizeof(reply), binary_protocol_opcode_for(cmd->type),
+                                                  seq, COMMAND_RESULT_UNSUPPORTED, NULL, 0);
+        if (len > 0) {
+            client_write(client, reply, len);
+        }
+        return;
+    }
+    
+    if (cmd->type == COMMAND_TYPE_SUBSCRIBE) {
+        // 从当前位置开始接收，不回放历史事件
+        if (!client->subscriber) {
+            client->subscriber = true;
+            client->event_cursor = event_stream_head();
+        }
+        ESP_LOGI(TAG, "客户端订阅事件流: fd=%d (%s)", client->fd, client->ip);
+        snprintf(response, sizeof(response), "#%s SUBSCRIBED\n", tag);
+    } else {
+        client->subscriber = false;
+        ESP_LOGI(TAG, "客户端取消订阅事件流: fd=%d (%s)", client->fd, client->ip);
+        snprintf(response, sizeof(response), "#%s UNSUBSCRIBED\n", tag);
+    }
+    client_write_str(client, response);
+}
+
+/**
+ * @brief 回复不在本服务器命令集合中的命令
+ */
+static void send_unsupported(tcp_client_t *client, const command_t *cmd, const char *tag,
+                             tcp_reply_format_t format, uint16_t seq)
+{
+    char response[TCP_SERVER_LINE_MAX + 32];
+    
+    if (format == TCP_REPLY_FORMAT_BINARY) {
+        uint8_t reply[BINARY_PROTOCOL_MAX_FRAME];
+        size_t len = binary_protocol_encode_reply(reply, sizeof(reply), binary_protocol_opcode_for(cmd->type),
+                                                  seq, COMMAND_RESULT_UNSUPPORTED, NULL, 0);
+        if (len > 0) {
+            client_write(client, reply, len);
+        }
+        return;
+    }
+    
+    if (tag[0] != '\0') {
+        snprintf(response, sizeof(response), "#%s ERROR unsupported\n", tag);
+    } else {
+        snprintf(response, sizeof(response), "ERROR: unsupported\n");
+    }
+    client_write_str(client, response);
+}
+
+/**
+ * @brief 调用命令回调
+ * 
+ * 不在命令集合中的命令直接回复unsupported；订阅命令由服务器直接处理；
+ * 除状态查询外的命令先经过准入检查，超出限制时直接回复BUSY，不进入执行队列
+ */
+static void dispatch_command(tcp_client_t *client, const command_t *cmd, const char *tag,
+                             tcp_reply_format_t format, uint16_t seq)
+{
+    if ((server_state.options.command_mask & COMMAND_MASK(cmd->type)) == 0) {
+        ESP_LOGW(TAG, "命令不在本端口的命令集合中: fd=%d, type=%d", client->fd, cmd->type);
+        send_unsupported(client, cmd, tag, format, seq);
+        return;
+    }
+    
+    if (cmd->type == COMMAND_TYPE_SUBSCRIBE || cmd->type == COMMAND_TYPE_UNSUBSCRIBE) {
+        handle_subscription(client, cmd, tag, format, seq);
+        return;
+    }
+    
+    if (server_state.callback == NULL) {
+        return;
+    }
+    
+    client->stats.commands++;
+    
+    tcp_request_ctx_t ctx = {
+        .client_fd = client->fd,
+        .conn_id = client->id,
+        .format = format,
+        .seq = seq,
+        .reply = client_reply,
+        .transport = client,
+        .perm = server_state.options.perm,
+    };
+    strncpy(ctx.tag, tag, TCP_SERVER_TAG_MAX_LEN);
+    ctx.tag[TCP_SERVER_TAG_MAX_LEN] = '\0';
+    
+    bool admitted = false;
+    if (command_admission_required(cmd->type)) {
+        uint32_t retry_after_ms = 0;
+        if (!admit_command(client, &retry_after_ms)) {
+            client->stats.shed++;
+            ESP_LOGW(TAG, "命令被限流: fd=%d (%s)，%ums后重试", client->fd, client->ip, (unsigned)retry_after_ms);
+            command_reply_busy(&ctx, cmd, retry_after_ms);
+            return;
+        }
+        admitted = true;
+    }
+    
+    command_result_t result = server_state.callback(cmd, &ctx);
+    
+    // 未进入执行的命令立即释放计数
+    if (admitted && result != COMMAND_RESULT_ACCEPTED && result != COMMAND_RESULT_QUEUED) {
+        tcp_server_release_inflight(client->id);
+    }
+}
+
+/**
+ * @brief 分发文本协议的数字命令
+ */
+static void dispatch_digit(tcp_client_t *client, char digit, const char *tag)
+{
+    command_t cmd = {
+        .type = COMMAND_TYPE_DIGIT,
+        .args.digit.index = digit - '0',
+    };
+    
+    dispatch_command(client, &cmd, tag, TCP_REPLY_FORMAT_TEXT, 0);
+}
+
+/**
+ * @brief 发送二进制错误回复
+ */
+static void send_binary_error(tcp_client_t *client, const binary_frame_info_t *info, command_result_t status)
+{
+    uint8_t reply[BINARY_PROTOCOL_MAX_FRAME];
+    size_t len = binary_protocol_encode_reply(reply, sizeof(reply), info->opcode, info->seq,
+                                              status, NULL, 0);
+    if (len > 0) {
+        client_write(client, reply, len);
+    }
+}
+
+/**
+ * @brief 处理分帧器输出的一个完整二进制帧
+ */
+static void handle_binary_frame(tcp_client_t *client, const uint8_t *buf, size_t len)
+{
+    command_t cmd;
+    binary_frame_info_t info;
+    
+    switch (binary_protocol_parse(buf, len, &cmd, &info)) {
+        case BINARY_PARSE_OK:
+            stream_parser_set_binary_only(&client->parser);
+            ESP_LOGI(TAG, "收到二进制命令: op=0x%02x, seq=%u", info.opcode, info.seq);
+            dispatch_command(client, &cmd, "", TCP_REPLY_FORMAT_BINARY, info.seq);
+            break;
+            
+        case BINARY_PARSE_BAD_CRC:
+            ESP_LOGW(TAG, "二进制帧校验失败: fd=%d, seq=%u", client->fd, info.seq);
+            send_binary_error(client, &info, COMMAND_RESULT_BAD_CRC);
+            break;
+            
+        case BINARY_PARSE_BAD_REQUEST:
+            ESP_LOGW(TAG, "二进制帧请求非法: fd=%d, op=0x%02x", client->fd, info.opcode);
+            send_binary_error(client, &info, COMMAND_RESULT_BAD_REQUEST);
+            break;
+            
+        default:
+            break;      // 分帧器已检查过长度，不会出现
+    }
+}
+
+/**
+ * @brief 处理一行标签协议请求 "<tag> <cmd>"（行首的'#'已去除，以'\0'结尾）
+ */
+static void handle_tagged_line(tcp_client_t *client, const char *line, size_t len, bool overflow)
+{
+    char tag[LINE_PROTOCOL_TAG_MAX_LEN + 1];
+    char response[TCP_SERVER_LINE_MAX + 32];
+    command_t cmd;
+    
+    line_protocol_result_t result = line_protocol_parse(line, len, tag, &cmd);
+    
+    if (result == LINE_PROTOCOL_BAD_TAG) {
+        ESP_LOGW(TAG, "无效标签: fd=%d, \"%s\"", client->fd, line);
+        client_write_str(client, "#? ERROR bad-tag\n");
+        return;
+    }
+    
+    if (overflow) {
+        ESP_LOGW(TAG, "请求行超长: fd=%d, tag=%s", client->fd, tag);
+        snprintf(response, sizeof(response), "#%s ERROR line-too-long\n", tag);
+        client_write_str(client, response);
+        return;
+    }
+    
+    if (result != LINE_PROTOCOL_OK) {
+        ESP_LOGW(TAG, "无效请求: fd=%d, \"%s\"", client->fd, line);
+        snprintf(response, sizeof(response), "#%s ERROR bad-command\n", tag);
+        client_write_str(client, response);
+        return;
+    }
+    
+    ESP_LOGI(TAG, "收到标签命令: #%s (类型: %d)", tag, cmd.type);
+    dispatch_command(client, &cmd, tag, TCP_REPLY_FORMAT_TEXT, 0);
+}
+
+/**
+ * @brief 处理分帧器输出的一帧
+ */
+static void handle_frame(tcp_client_t *client, const stream_frame_t *frame)
+{
+    switch (frame->type) {
+        case STREAM_FRAME_DIGIT:
+            ESP_LOGI(TAG, "收到有效命令: %c", frame->data[0]);
+            dispatch_digit(client, (char)frame->data[0], "");
+            break;
+            
+        case STREAM_FRAME_LINE:
+        case STREAM_FRAME_LINE_TOO_LONG:
+            handle_tagged_line(client, (const char *)frame->data, frame->len,
+                               frame->type == STREAM_FRAME_LINE_TOO_LONG);
+            break;
+            
+        case STREAM_FRAME_BINARY:
+            handle_binary_frame(client, frame->data, frame->len);
+            break;
+            
+        case STREAM_FRAME_INVALID:
+            ESP_LOGW(TAG, "收到无效命令: 0x%02x", frame->data[0]);
+            break;
+            
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 读取客户端数据并分发命令
+ * 
+ * 数据直接接收到槽位的接收环形缓冲区，再按段输入连接的分帧器。请求可以跨多个TCP段到达，
+ * 也可以多个请求合并在一个段中；未收完的请求由分帧器保存，接收缓冲区每次都处理完。
+ * 接收缓冲区被填满时继续接收（最多 TCP_SERVER_RX_ROUNDS 次），一个数据包中的多条命令
+ * 处理完后才统一发送响应
+ */
+static void handle_client_data(tcp_client_t *client)
+{
+    if (client->handshaking) {
+        int ret = tls_session_handshake(client->tls);
+        if (ret < 0) {
+            client_close(client);
+        } else if (ret == 0) {
+            client->handshaking = false;
+            client->last_active = xTaskGetTickCount();
+        }
+        return;
+    }
+    
+    // 接收缓冲区每次都会处理完，只有连接待断开时才可能有剩余数据
+    for (int round = 0; round < TCP_SERVER_RX_ROUNDS && client->state == CONN_STATE_OPEN; round++) {
+        size_t space;
+        uint8_t *dst = byte_ring_write_ptr(&client->rx, &space);
+        if (space == 0) {
+            break;
+        }
+        ssize_t received = conn_recv(client, dst, space);
+    
+        if (received == 0) {
+            ESP_LOGI(TAG, "客户端关闭连接: fd=%d", client->fd);
+            xSemaphoreTake(server_state.lock, portMAX_DELAY);
+            bool pending = byte_ring_used(&client->tx) > 0;
+            if (pending) {
+                client->state = CONN_STATE_DRAINING;   // 先发完缓冲区中的数据
+            }
+            xSemaphoreGive(server_state.lock);
+            if (!pending) {
+                client_close(client);
+            }
+            return;
+        }
+    
+        if (received < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ESP_LOGE(TAG, "接收数据失败: fd=%d, %s", client->fd, strerror(errno));
+                client_close(client);
+                return;
+            }
+            break;  // 暂时没有更多数据
+        }
+    
+        client->last_active = xTaskGetTickCount();
+        client->stats.rx_bytes += received;
+        byte_ring_commit(&client->rx, received);
+        ESP_LOGI(TAG, "收到数据: fd=%d (长度: %zd)", client->fd, received);
+    
+        // 处理过程中连接可能因发送积压超限被标记为待断开，此后的输入不再处理
+        while (client->state == CONN_STATE_OPEN && byte_ring_used(&client->rx) > 0) {
+            size_t len;
+            const uint8_t *data = byte_ring_read_ptr(&client->rx, &len);
+            stream_frame_t frame;
+            size_t used = stream_parser_feed(&client->parser, data, len, &frame);
+            byte_ring_consume(&client->rx, used);
+            if (frame.type != STREAM_FRAME_NONE) {
+                handle_frame(client, &frame);
+            }
+        }
+    
+        // 没有填满接收缓冲区，socket中已经没有更多数据
+        if ((size_t)received < space) {
+            break;
+        }
+    }
+    
+    // 本批输入产生的所有响应合并为一次发送
+    if (client->state == CONN_STATE_OPEN) {
+        client_send_pending(client);
+    }
+}
+
+/**
+ * @brief 唤醒阻塞在select中的服务器任务
+ */
+static void server_wakeup(void)
+{
+    tcp_loop_wakeup(server_state.wakeup_fd);
+}
+
+/**
+ * @brief 推送事件流给订阅者
+ * 
+ * 事件追加到发送缓冲区（不超过积压上限）后以非阻塞方式发送，不会阻塞事件循环。
+ * 订阅者落后超过事件缓冲区容量时：
+ *   - 若之前的数据已全部发出（偶发突发），推送 "!LAG missed=<n>" 后继续
+ *   - 若仍有数据积压（接收方过慢），断开该连接
+ */
+static void push_events(tcp_client_t *client)
+{
+    char event[TCP_SERVER_LAG_MAX_LEN + EVENT_STREAM_EVENT_MAX_LEN];
+    size_t limit = tx_backlog_limit(client);
+    
+    xSemaphoreTake(server_state.lock, portMAX_DELAY);
+    bool backlogged = byte_ring_used(&client->tx) > 0;
+    while (client->state == CONN_STATE_OPEN && byte_ring_used(&client->tx) + sizeof(event) <= limit) {
+        uint32_t missed = 0;
+        char *out = event + TCP_SERVER_LAG_MAX_LEN;
+        size_t len = event_stream_read(&client->event_cursor, out, &missed);
+        
+        if (missed > 0) {
+            if (backlogged) {
+                ESP_LOGW(TAG, "订阅者过慢: fd=%d, 丢失事件: %u", client->fd, (unsigned)missed);
+                server_state.tx_abort_count++;
+                client_abort_locked(client, "事件积压");
+                break;
+            }
+            // 丢失提示放在本事件之前
+            char lag[TCP_SERVER_LAG_MAX_LEN];
+            int lag_len = snprintf(lag, sizeof(lag), "!LAG missed=%u\n", (unsigned)missed);
+            out -= lag_len;
+            memcpy(out, lag, lag_len);
+            len += lag_len;
+        }
+        
+        if (len == 0) {
+            break;
+        }
+        byte_ring_write(&client->tx, out, len);
+    }
+    xSemaphoreGive(server_state.lock);
+    
+    if (client->state == CONN_STATE_OPEN) {
+        client_send_pending(client);
+    }
+}
+
+/**
+ * @brief 关闭超过空闲时间的客户端连接
+ * @return 距离下一个连接空闲超时的tick数，没有连接时返回portMAX_DELAY
+ */
+static TickType_t close_idle_clients(void)
+{
+    TickType_t now = xTaskGetTickCount();
+    TickType_t idle_timeout = pdMS_TO_TICKS(TCP_SERVER_IDLE_TIMEOUT_MS);
+    TickType_t next_timeout = portMAX_DELAY;
+    
+    for (int i = 0; i < TCP_SERVER_MAX_CLIENTS; i++) {
+        tcp_client_t *client = conn_pool_at(i);
+        if (client->state == CONN_STATE_FREE) {
+            continue;
+        }
+        
+        // 订阅者只接收不发送，不按空闲超时关闭；正在关闭的连接超时后强制关闭
+        if (client->subscriber && client->state == CONN_STATE_OPEN) {
+            continue;
+        }
+        
+        TickType_t idle = now - client->last_active;
+        if (idle >= idle_timeout) {
+            ESP_LOGI(TAG, "客户端空闲超时: fd=%d", client->fd);
+            client_close(client);
+        } else if (idle_timeout - idle < next_timeout) {
+            next_timeout = idle_timeout - idle;
+        }
+    }
+    
+    return next_timeout;
 }
 
 /**
  * @brief TCP服务器任务
- * 处理客户端连接和命令接收
+ * 基于select()的事件循环，同时保持多个客户端的长连接。
+ * 没有事件时一直阻塞在select中，只在最近的空闲超时到期或被唤醒事件唤醒时返回
  */
 static void tcp_server_task(void *pvParameters)
 {
-    ESP_LOGI(TAG, "TCP服务器任务启动");
+    ESP_LOGI(TAG, "TCP服务器任务启动，最大客户端数: %d", TCP_SERVER_MAX_CLIENTS);
     
-    server_state.running = true;
+    int listen_fd = server_state.server_fd;
+    int tls_fd = server_state.tls_fd;
+    TickType_t next_timeout = portMAX_DELAY;
     
     while (server_state.running) {
-        // 接受客户端连接
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        
-        int client_fd = accept(server_state.server_fd, 
-                               (struct sockaddr*)&client_addr, 
-                               &client_len);
+        // 构建待监听的描述符集合
+        tcp_loop_fds_t fds;
+        tcp_loop_fds_init(&fds, server_state.wakeup_fd);
+        tcp_loop_watch_read(&fds, listen_fd);
+        if (tls_fd >= 0) {
+            tcp_loop_watch_read(&fds, tls_fd);
+        }
+        bool buffered_input = false;
         
-        if (client_fd < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                vTaskDelay(pdMS_TO_TICKS(100));
+        for (int i = 0; i < TCP_SERVER_MAX_CLIENTS; i++) {
+            tcp_client_t *client = conn_pool_at(i);
+            if (client->state == CONN_STATE_FREE) {
                 continue;
             }
-            ESP_LOGE(TAG, "接受连接失败: %s", strerror(errno));
-            vTaskDelay(pdMS_TO_TICKS(100));
-            continue;
+            if (client->state == CONN_STATE_OPEN) {
+                tcp_loop_watch_read(&fds, client->fd);
+                buffered_input |= conn_has_buffered_input(client);
+            }
+            // 有未发完的数据时等待socket可写
+            if (byte_ring_used(&client->tx) > 0) {
+                tcp_loop_watch_write(&fds, client->fd);
+            }
         }
         
-        ESP_LOGI(TAG, "客户端连接成功: fd=%d", client_fd);
-        
-        // 获取客户端信息
-        char client_ip[16];
-        inet_ntoa_r(client_addr.sin_addr, client_ip, sizeof(client_ip));
-        ESP_LOGI(TAG, "客户端IP: %s, 端口: %d", client_ip, ntohs(client_addr.sin_port));
-        
-        // 接收数据
-        char buffer[TCP_SERVER_BUFFER_SIZE];
-        ssize_t received = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
+        // 只在有连接时才需要超时，用于关闭空闲连接；TLS连接中有未处理的解密数据时不等待
+        int ready = tcp_loop_wait(&fds, buffered_input ? 0 : next_timeout);
+        if (ready < 0) {
+            continue;
+        }
         
-        if (received > 0) {
-            buffer[received] = '\0';
-            ESP_LOGI(TAG, "收到数据: %s (长度: %zd)", buffer, received);
+        if (ready > 0) {
+            // 新连接（唤醒事件已由 tcp_loop_wait 清除，随后检查运行状态）
+            if (FD_ISSET(listen_fd, &fds.read_fds)) {
+                accept_new_client(listen_fd, false);
+            }
+            if (tls_fd >= 0 && FD_ISSET(tls_fd, &fds.read_fds)) {
+                accept_new_client(tls_fd, true);
+            }
             
-            // 处理每个字符命令 (0-9)
-            for (int i = 0; i < received; i++) {
-                char cmd = buffer[i];
-                
-                // 检查是否为有效命令 (0-9)
-                if (cmd >= '0' && cmd <= '9') {
-                    ESP_LOGI(TAG, "收到有效命令: %c", cmd);
-                    
-                    // 调用回调函数
-                    if (server_state.callback) {
-                        server_state.callback(cmd, client_fd);
-                    }
-                } else if (cmd == '\n' || cmd == '\r') {
-                    // 忽略换行符
-                } else {
-                    ESP_LOGW(TAG, "收到无效命令: %c (0x%02x)", cmd, cmd);
+            // 客户端数据（TLS连接在握手完成前推进握手）
+            for (int i = 0; i < TCP_SERVER_MAX_CLIENTS; i++) {
+                tcp_client_t *client = conn_pool_at(i);
+                if (client->state == CONN_STATE_OPEN && FD_ISSET(client->fd, &fds.read_fds)) {
+                    handle_client_data(client);
                 }
             }
-        } else if (received == 0) {
-            ESP_LOGI(TAG, "客户端关闭连接");
-        } else {
-            if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                ESP_LOGE(TAG, "接收数据失败: %s", strerror(errno));
+        }
+        
+        // TLS记录解密后剩余的数据已经从socket读出，不会再触发select可读，主动处理
+        if (buffered_input) {
+            for (int i = 0; i < TCP_SERVER_MAX_CLIENTS; i++) {
+                tcp_client_t *client = conn_pool_at(i);
+                if (client->state == CONN_STATE_OPEN && conn_has_buffered_input(client)) {
+                    handle_client_data(client);
+                }
             }
         }
         
-        // 关闭客户端连接
-        close(client_fd);
-        ESP_LOGI(TAG, "客户端连接已关闭: fd=%d", client_fd);
+        // 推送新事件（发布事件时通过唤醒事件描述符唤醒select），继续发送积压的数据
+        // （包括其他任务按连接ID写入的响应），关闭发完数据或被标记为待断开的连接
+        for (int i = 0; i < TCP_SERVER_MAX_CLIENTS; i++) {
+            tcp_client_t *client = conn_pool_at(i);
+            if (client->state == CONN_STATE_OPEN && client->subscriber) {
+                push_events(client);
+            } else if (client->state == CONN_STATE_OPEN && byte_ring_used(&client->tx) > 0) {
+                client_send_pending(client);
+            } else if (client->state == CONN_STATE_DRAINING) {
+                if (client_send_pending(client) && byte_ring_used(&client->tx) == 0) {
+                    client_close(client);
+                }
+            }
+            if (client->state == CONN_STATE_ABORTING) {
+                client_close(client);
+            }
+        }
         
-        vTaskDelay(pdMS_TO_TICKS(10));
+        next_timeout = close_idle_clients();
+    }
+    
+    // 关闭所有客户端连接
+    for (int i = 0; i < TCP_SERVER_MAX_CLIENTS; i++) {
+        client_close(conn_pool_at(i));
     }
     
     ESP_LOGI(TAG, "TCP服务器任务退出");
+    
+    // 通知tcp_server_stop任务已退出
+    server_state.task = NULL;
+    xSemaphoreGive(server_state.stopped);
     vTaskDelete(NULL);
 }
 
@@ -139,49 +870,77 @@ esp_err_t tcp_server_init(uint16_t port)
     server_state.port = port;
     server_state.server_fd = -1;
     
-    // 创建服务器socket
-    server_state.server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_state.server_fd < 0) {
-        ESP_LOGE(TAG, "创建socket失败: %s", strerror(errno));
-        return ESP_FAIL;
+    if (server_state.lock == NULL) {
+        server_state.lock = xSemaphoreCreateMutex();
+        server_state.stopped = xSemaphoreCreateBinary();
+        if (server_state.lock == NULL || server_state.stopped == NULL) {
+            ESP_LOGE(TAG, "创建信号量失败");
+            return ESP_ERR_NO_MEM;
+        }
     }
+    conn_pool_init();
     
-    ESP_LOGI(TAG, "Socket创建成功: fd=%d", server_state.server_fd);
+    // 重置限流状态
+    apply_admission_options(&server_state.options);
     
-    // 设置socket选项，允许地址复用
-    int opt = 1;
-    if (setsockopt(server_state.server_fd, SOL_SOCKET, SO_REUSEADDR, 
-                   &opt, sizeof(opt)) < 0) {
-        ESP_LOGE(TAG, "设置SO_REUSEADDR失败: %s", strerror(errno));
+    // 创建唤醒事件描述符，停止服务器时用于唤醒阻塞的select
+    if (server_state.wakeup_fd < 0) {
+        esp_err_t err = tcp_loop_wakeup_create(&server_state.wakeup_fd);
+        if (err != ESP_OK) {
+            return err;
+        }
+        
+        // 发布事件时唤醒服务器任务推送给订阅者
+        event_stream_add_listener(server_wakeup);
     }
     
-    // 绑定地址
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(port);
-    
-    if (bind(server_state.server_fd, (struct sockaddr*)&server_addr, 
-              sizeof(server_addr)) < 0) {
-        ESP_LOGE(TAG, "绑定地址失败: %s", strerror(errno));
-        close(server_state.server_fd);
-        server_state.server_fd = -1;
+    server_state.server_fd = tcp_loop_listen(port, TCP_SERVER_BACKLOG);
+    if (server_state.server_fd < 0) {
         return ESP_FAIL;
     }
     
-    ESP_LOGI(TAG, "地址绑定成功");
+    ESP_LOGI(TAG, "TCP服务器初始化完成，监听端口 %d", port);
     
-    // 设置监听
-    if (listen(server_state.server_fd, TCP_SERVER_BACKLOG) < 0) {
-        ESP_LOGE(TAG, "监听失败: %s", strerror(errno));
-        close(server_state.server_fd);
-        server_state.server_fd = -1;
+    return ESP_OK;
+}
+
+esp_err_t tcp_server_enable_tls(uint16_t port)
+{
+    if (server_state.server_fd < 0 || server_state.running) {
+        ESP_LOGE(TAG, "必须在初始化之后、启动之前启用TLS");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (server_state.tls_fd >= 0) {
+        return ESP_OK;
+    }
+    
+    esp_err_t err = tls_session_init();
+    if (err != ESP_OK) {
+        return err;
+    }
+    
+    server_state.tls_fd = tcp_loop_listen(port, TCP_SERVER_BACKLOG);
+    if (server_state.tls_fd < 0) {
         return ESP_FAIL;
     }
+    server_state.tls_port = port;
     
-    ESP_LOGI(TAG, "TCP服务器初始化完成，监听端口 %d", port);
+    ESP_LOGI(TAG, "TLS监听端口 %d", port);
+    return ESP_OK;
+}
+
+esp_err_t tcp_server_set_options(const tcp_server_options_t *options)
+{
+    if (options == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
+    server_state.options = *options;
+    apply_admission_options(options);
+    ESP_LOGI(TAG, "服务器选项: TCP_NODELAY=%d, 发送策略=%s, 最大积压=%u, 命令集合=0x%08x, 优先级=%u, 核心=%d",
+             options->nodelay, options->flush_policy == TCP_SERVER_FLUSH_PER_BATCH ? "合并发送" : "立即发送",
+             (unsigned)options->max_tx_backlog, (unsigned)options->command_mask,
+             options->task_priority, options->core_id);
     return ESP_OK;
 }
 
@@ -197,39 +956,65 @@ esp_err_t tcp_server_start(void)
         return ESP_OK;
     }
     
+    if (server_state.task != NULL) {
+        ESP_LOGE(TAG, "上一次停止尚未完成，服务器任务仍未退出");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
     ESP_LOGI(TAG, "启动TCP服务器任务");
     
+    // 在创建任务前置位，保证任务启动前调用tcp_server_stop也能正确停止
+    server_state.running = true;
+    xSemaphoreTake(server_state.stopped, 0);
+    
     // 创建服务器任务
-    BaseType_t ret = xTaskCreate(
+    BaseType_t ret = xTaskCreatePinnedToCore(
         tcp_server_task,           // 任务函数
         "tcp_server",             // 任务名称
         4096,                      // 堆栈大小
         NULL,                      // 参数
-        5,                         // 优先级
-        NULL                       // 任务句柄
+        server_state.options.task_priority, // 优先级
+        &server_state.task,        // 任务句柄
+        server_state.options.core_id < 0 ? tskNO_AFFINITY : server_state.options.core_id // 绑定的核心
     );
     
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "创建任务失败");
+        server_state.running = false;
         return ESP_FAIL;
     }
     
     return ESP_OK;
 }
 
-void tcp_server_stop(void)
+esp_err_t tcp_server_stop(void)
 {
     ESP_LOGI(TAG, "停止TCP服务器");
     
-    server_state.running = false;
+    // 唤醒服务器任务并等待其关闭所有连接后退出；上一次停止超时时任务可能仍未退出，继续等待
+    if (server_state.running || server_state.task != NULL) {
+        server_state.running = false;
+        server_wakeup();
+        
+        if (xSemaphoreTake(server_state.stopped, pdMS_TO_TICKS(TCP_SERVER_STOP_TIMEOUT_MS)) != pdTRUE) {
+            // 任务可能仍在使用监听socket和连接池，全部保留，由调用方稍后重试
+            ESP_LOGE(TAG, "等待服务器任务退出超时，监听socket和连接保持不变");
+            return ESP_ERR_TIMEOUT;
+        }
+    }
     
-    // 关闭服务器socket
+    // 任务已退出，可以安全关闭服务器socket
     if (server_state.server_fd >= 0) {
         close(server_state.server_fd);
         server_state.server_fd = -1;
     }
+    if (server_state.tls_fd >= 0) {
+        close(server_state.tls_fd);
+        server_state.tls_fd = -1;
+    }
     
     ESP_LOGI(TAG, "TCP服务器已停止");
+    return ESP_OK;
 }
 
 void tcp_server_register_command_callback(command_callback_t callback)
@@ -248,18 +1033,108 @@ uint16_t tcp_server_get_port(void)
     return server_state.port;
 }
 
-int tcp_server_send_response(int client_fd, const char* response)
+int tcp_server_send_data(int client_fd, const void* data, size_t len)
 {
-    if (client_fd < 0 || response == NULL) {
+    if (client_fd < 0 || data == NULL) {
         return -1;
     }
     
-    ssize_t sent = send(client_fd, response, strlen(response), 0);
+    ssize_t sent = send(client_fd, data, len, MSG_DONTWAIT);
     if (sent < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;   // 发送窗口已满
+        }
         ESP_LOGE(TAG, "发送响应失败: %s", strerror(errno));
         return -1;
     }
     
-    ESP_LOGI(TAG, "发送响应成功: %s (长度: %zd)", response, sent);
     return sent;
 }
+
+int tcp_server_send_response(int client_fd, const char* response)
+{
+    if (response == NULL) {
+        return -1;
+    }
+    
+    size_t len = strlen(response);
+    int sent = tcp_server_send_data(client_fd, response, len);
+    if (sent >= 0 && (size_t)sent < len) {
+        ESP_LOGW(TAG, "响应只发送了一部分: fd=%d (%d/%u)", client_fd, sent, (unsigned)len);
+    }
+    return sent;
+}
+
+int tcp_server_reply(const tcp_request_ctx_t *ctx, const char* response)
+{
+    if (response == NULL) {
+        return -1;
+    }
+    
+    return tcp_server_reply_data(ctx, response, strlen(response));
+}
+
+int tcp_server_reply_data(const tcp_request_ctx_t *ctx, const void* data, size_t len)
+{
+    if (ctx == NULL) {
+        return -1;
+    }
+    
+    if (ctx->reply) {
+        return ctx->reply(ctx, data, len);
+    }
+    
+    return tcp_server_send_data(ctx->client_fd, data, len);
+}
+
+int tcp_server_send_to_conn(uint32_t conn_id, const char* response)
+{
+    if (response == NULL) {
+        return -1;
+    }
+    
+    return tcp_server_send_data_to_conn(conn_id, response, strlen(response));
+}
+
+int tcp_server_send_data_to_conn(uint32_t conn_id, const void* data, size_t len)
+{
+    if (conn_id == 0 || data == NULL || server_state.lock == NULL) {
+        return -1;
+    }
+    
+    int written = -1;
+    
+    // 持有锁期间连接不会被关闭；只写入发送缓冲区，由服务器任务发送，接收方过慢时不会阻塞调用方
+    xSemaphoreTake(server_state.lock, portMAX_DELAY);
+    tcp_client_t *client = conn_pool_find(conn_id);
+    if (client != NULL) {
+        written = tx_enqueue_locked(client, data, len);
+    }
+    xSemaphoreGive(server_state.lock);
+    
+    if (client != NULL) {
+        server_wakeup();
+    }
+    if (written < 0) {
+        ESP_LOGW(TAG, "连接已关闭或发送积压超限，丢弃响应: conn_id=%u", (unsigned)conn_id);
+    }
+    
+    return written;
+}
+
+void tcp_server_release_inflight(uint32_t conn_id)
+{
+    if (server_state.lock == NULL) {
+        return;
+    }
+    
+    command_admission_release();
+    
+    // 连接可能已关闭，此时只释放全局计数
+    xSemaphoreTake(server_state.lock, portMAX_DELAY);
+    tcp_client_t *client = conn_pool_find(conn_id);
+    if (client != NULL && client->inflight > 0) {
+        client->inflight--;
+    }
+    xSemaphoreGive(server_state.lock);
+}
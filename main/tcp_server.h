@@ -3,24 +3,130 @@
  * @brief TCP服务器头文件
  * 
  * 提供TCP服务器功能，用于接收控制信号(0-9)
+ * 支持多个客户端同时保持长连接，连接空闲超时后自动关闭
+ * 
+ * 协议:
+ *   - 旧协议: 每个字节'0'-'9'为一条命令，无标签
+ *   - 标签协议: 一行一条请求 "#<tag> <cmd>\n"，tag为1-15个字母/数字/'_'/'-'/'.'，
+ *     客户端可以连续发送多条请求而无需等待，服务器的每条回复都以 "#<tag> " 开头
+ *   - 二进制协议: 以0xA5开头的长度前缀帧，格式见 binary_protocol.h
+ *   - 事件订阅: "#<tag> SUBSCRIBE" 后服务器主动推送 "!<seq> <事件>" 行，格式见 event_stream.h，
+ *     "#<tag> UNSUBSCRIBE" 取消订阅
  */
 
 #ifndef TCP_SERVER_H
 #define TCP_SERVER_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "esp_err.h"
+#include "command.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define TCP_SERVER_TAG_MAX_LEN  15  /**< 请求标签最大长度 */
+
 /**
- * @brief 控制信号回调函数类型
- * @param command 接收到的命令字符 ('0'-'9')
- * @param client_fd 客户端socket描述符
+ * @brief 请求所用的协议格式，决定回复的编码方式
+ */
+typedef enum {
+    TCP_REPLY_FORMAT_TEXT = 0,  /**< 文本协议（旧协议或标签协议） */
+    TCP_REPLY_FORMAT_BINARY,    /**< 二进制帧协议 */
+} tcp_reply_format_t;
+
+typedef struct tcp_request_ctx tcp_request_ctx_t;
+
+/**
+ * @brief 回复函数类型，用于非TCP连接的传输通道（如UDP）
+ * @param ctx 请求上下文
+ * @param data 响应数据
+ * @param len 响应长度
+ * @return 发送的字节数，负值表示错误
+ */
+typedef int (*tcp_reply_fn_t)(const tcp_request_ctx_t *ctx, const void *data, size_t len);
+
+/**
+ * @brief 请求上下文
+ */
+struct tcp_request_ctx {
+    int client_fd;                          /**< 客户端socket描述符 */
+    uint32_t conn_id;                       /**< 连接ID，用于异步回复时识别连接；0表示不支持异步回复 */
+    char tag[TCP_SERVER_TAG_MAX_LEN + 1];   /**< 请求标签，空字符串表示旧协议（无标签） */
+    tcp_reply_format_t format;              /**< 请求协议格式 */
+    uint16_t seq;                           /**< 二进制协议请求序号 */
+    tcp_reply_fn_t reply;                   /**< 回复函数，NULL表示直接发送到client_fd */
+    void *transport;                        /**< 传输通道私有数据 */
+    const char *dedupe_id;                  /**< 命令没有显式请求ID时用于去重的ID（UDP的请求标签），NULL表示不去重 */
+    uint32_t dedupe_scope;                  /**< dedupe_id 的作用域（见 request_cache.h），例如UDP的源IP */
+    command_perm_t perm;                    /**< 请求方的权限，未设置时为只读 */
+};
+
+/**
+ * @brief 响应发送策略
+ */
+typedef enum {
+    TCP_SERVER_FLUSH_PER_BATCH = 0, /**< 同一批输入产生的响应合并为一次send（默认） */
+    TCP_SERVER_FLUSH_IMMEDIATE,     /**< 每条响应写入发送缓冲区后立即尝试send */
+} tcp_server_flush_policy_t;
+
+/**
+ * @brief TCP服务器选项
+ */
+typedef struct {
+    bool nodelay;                           /**< 对客户端连接设置TCP_NODELAY，关闭Nagle算法 */
+    tcp_server_flush_policy_t flush_policy; /**< 响应发送策略 */
+    uint16_t rate_per_ip;                   /**< 每个客户端IP每秒允许的命令数（所有通道共用，见 command_admission.h），0表示不限制 */
+    uint16_t burst_per_ip;                  /**< 每个客户端IP允许的突发命令数 */
+    uint16_t rate_global;                   /**< 所有通道的全部客户端每秒允许的命令数，0表示不限制 */
+    uint16_t burst_global;                  /**< 所有通道的全部客户端允许的突发命令数 */
+    uint8_t max_inflight_per_conn;          /**< 每个连接未完成命令的上限，0表示不限制 */
+    uint8_t max_inflight_total;             /**< 全部连接未完成命令的上限，0表示不限制 */
+    uint16_t inflight_retry_ms;             /**< 超出并发上限时建议的重试等待时间 */
+    uint16_t max_tx_backlog;                /**< 每个连接允许积压的未发送字节数，超出时断开连接；0表示整个发送缓冲区 */
+    uint32_t command_mask;                  /**< 接受的命令集合（COMMAND_MASK位），其他命令回复unsupported */
+    command_perm_t perm;                    /**< 命令端口客户端的权限 */
+    uint8_t task_priority;                  /**< 服务器任务优先级，tcp_server_start() 时生效 */
+    int8_t core_id;                         /**< 服务器任务绑定的核心，-1表示不绑定；tcp_server_start() 时生效 */
+} tcp_server_options_t;
+
+/**
+ * @brief 默认服务器选项：合并响应并关闭Nagle，合并后的响应立即发出；
+ * 每个IP每秒5条命令（突发10条），全局每秒20条（突发30条），
+ * 每个连接最多4条、全局最多8条未完成命令；发送积压超过整个发送缓冲区时断开连接；
+ * 接受全部命令并具有管理权限，任务优先级5、不绑定核心
+ */
+#define TCP_SERVER_DEFAULT_OPTIONS()                    \
+    {                                                   \
+        .nodelay = true,                                \
+        .flush_policy = TCP_SERVER_FLUSH_PER_BATCH,     \
+        .rate_per_ip = 5,                               \
+        .burst_per_ip = 10,                             \
+        .rate_global = 20,                              \
+        .burst_global = 30,                             \
+        .max_inflight_per_conn = 4,                     \
+        .max_inflight_total = 8,                        \
+        .inflight_retry_ms = 1000,                      \
+        .max_tx_backlog = 0,                            \
+        .command_mask = COMMAND_MASK_ALL,               \
+        .perm = COMMAND_PERM_ADMIN,                     \
+        .task_priority = 5,                             \
+        .core_id = -1,                                  \
+    }
+
+/**
+ * @brief 控制命令回调函数类型
+ * 
+ * 返回 COMMAND_RESULT_ACCEPTED 或 COMMAND_RESULT_QUEUED 表示命令进入执行，
+ * 计入该连接的未完成命令数，执行完成后必须调用 tcp_server_release_inflight() 释放
+ * 
+ * @param command 解析后的命令
+ * @param ctx 请求上下文
+ * @return 命令处理结果
  */
-typedef void (*command_callback_t)(char command, int client_fd);
+typedef command_result_t (*command_callback_t)(const command_t *command, const tcp_request_ctx_t *ctx);
 
 /**
  * @brief 初始化TCP服务器
@@ -29,16 +135,36 @@ typedef void (*command_callback_t)(char command, int client_fd);
  */
 esp_err_t tcp_server_init(uint16_t port);
 
+/**
+ * @brief 设置服务器选项，对之后建立的连接生效
+ * @param options 服务器选项
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t tcp_server_set_options(const tcp_server_options_t *options);
+
+/**
+ * @brief 启用TLS监听端口
+ * 
+ * 必须在 tcp_server_init() 之后、tcp_server_start() 之前调用。TLS连接与明文连接共用连接槽位、
+ * 命令协议、限流和事件订阅，只是收发经过TLS会话（见 tls_session.h）；
+ * 支持会话票据，客户端重连时可以跳过完整握手
+ * 
+ * @param port TLS端口
+ * @return ESP_OK 成功，ESP_ERR_NOT_SUPPORTED 编译时未提供证书
+ */
+esp_err_t tcp_server_enable_tls(uint16_t port);
+
 /**
  * @brief 启动TCP服务器监听
- * @return ESP_OK 成功
+ * @return ESP_OK 成功；ESP_ERR_INVALID_STATE 未初始化，或上一次停止超时、服务器任务仍未退出
  */
 esp_err_t tcp_server_start(void);
 
 /**
- * @brief 停止TCP服务器
+ * @brief 停止TCP服务器：唤醒服务器任务，等待其关闭所有连接后退出，再关闭监听socket
+ * @return ESP_OK 已停止；ESP_ERR_TIMEOUT 等待任务退出超时，监听socket和连接池保持不变，可再次调用
  */
-void tcp_server_stop(void);
+esp_err_t tcp_server_stop(void);
 
 /**
  * @brief 注册控制命令回调
@@ -59,13 +185,75 @@ bool tcp_server_is_running(void);
 uint16_t tcp_server_get_port(void);
 
 /**
- * @brief 发送响应到客户端
+ * @brief 以非阻塞方式发送响应到客户端描述符
+ * 
+ * 不经过连接的发送缓冲区，socket发送窗口已满时只发送一部分（或0字节），
+ * 只适合连接建立前后的一次性短消息；已建立的连接应使用 tcp_server_reply() 或 tcp_server_send_to_conn()
+ * 
  * @param client_fd 客户端socket描述符
  * @param response 响应字符串
- * @return 发送的字节数，负值表示错误
+ * @return 实际发送的字节数（可能小于响应长度），负值表示错误
  */
 int tcp_server_send_response(int client_fd, const char* response);
 
+/**
+ * @brief 以非阻塞方式发送二进制数据到客户端描述符
+ * @param client_fd 客户端socket描述符
+ * @param data 数据
+ * @param len 数据长度
+ * @return 实际发送的字节数（可能小于len），负值表示错误
+ */
+int tcp_server_send_data(int client_fd, const void* data, size_t len);
+
+/**
+ * @brief 回复请求
+ * 
+ * 命令回调应使用此函数回复，以便同一个回调同时服务于TCP和其他传输通道
+ * 
+ * @param ctx 请求上下文
+ * @param response 响应字符串
+ * @return 发送的字节数，负值表示错误
+ */
+int tcp_server_reply(const tcp_request_ctx_t *ctx, const char* response);
+
+/**
+ * @brief 以二进制数据回复请求
+ * @param ctx 请求上下文
+ * @param data 响应数据
+ * @param len 响应长度
+ * @return 发送的字节数，负值表示错误
+ */
+int tcp_server_reply_data(const tcp_request_ctx_t *ctx, const void* data, size_t len);
+
+/**
+ * @brief 按连接ID发送响应
+ * 
+ * 可以在其他任务中调用（例如命令执行完成后回复）。响应追加到该连接的发送缓冲区，
+ * 由服务器任务在socket可写时发送，调用方不会因接收方过慢而阻塞。
+ * 如果该连接已关闭，则不发送（不会误发给复用了同一描述符的新连接）；
+ * 发送积压超过上限时丢弃响应并断开该连接
+ * 
+ * @param conn_id 连接ID
+ * @param response 响应字符串
+ * @return 写入发送缓冲区的字节数，负值表示错误、连接已关闭或积压超限
+ */
+int tcp_server_send_to_conn(uint32_t conn_id, const char* response);
+
+/**
+ * @brief 按连接ID发送二进制数据
+ * @param conn_id 连接ID
+ * @param data 数据
+ * @param len 数据长度
+ * @return 写入发送缓冲区的字节数，负值表示错误、连接已关闭或积压超限
+ */
+int tcp_server_send_data_to_conn(uint32_t conn_id, const void* data, size_t len);
+
+/**
+ * @brief 释放一条未完成命令的计数（命令执行完成时调用，可在其他任务中调用）
+ * @param conn_id 发起命令的连接ID
+ */
+void tcp_server_release_inflight(uint32_t conn_id);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,245 @@
+/**
+ * @file tls_session.c
+ * @brief TLS会话管理实现
+ * 
+ * 所有函数（除 tls_session_get_stats 外）只在TCP服务器任务中调用
+ */
+
+#include "tls_session.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_tls.h"
+#include <string.h>
+#include <errno.h>
+
+static const char *TAG = "TLS_SESSION";
+
+#ifdef TLS_SERVER_ENABLED
+
+// 嵌入固件的证书和私钥（EMBED_TXTFILES，以'\0'结尾）
+extern const unsigned char server_cert_pem_start[] asm("_binary_server_cert_pem_start");
+extern const unsigned char server_cert_pem_end[]   asm("_binary_server_cert_pem_end");
+extern const unsigned char server_key_pem_start[]  asm("_binary_server_key_pem_start");
+extern const unsigned char server_key_pem_end[]    asm("_binary_server_key_pem_end");
+
+// 会话表项
+typedef struct {
+    esp_tls_t *tls;             // 会话，NULL表示空闲
+    int64_t started_us;         // 接受连接的时间，用于统计握手耗时
+    size_t write_len;           // 上次返回EAGAIN的写入长度，重试时必须相同
+} tls_session_entry_t;
+
+// TLS会话管理状态
+typedef struct {
+    bool initialized;           // 证书和会话票据已初始化
+    esp_tls_cfg_server_t cfg;   // 服务器配置（所有会话共用，含票据密钥）
+    tls_session_entry_t sessions[TLS_SESSION_MAX]; // 会话表
+    tls_session_stats_t stats;  // 握手统计
+} tls_session_state_t;
+
+static tls_session_state_t tls_state;
+
+/**
+ * @brief 查找会话表项
+ */
+static tls_session_entry_t *session_find(const esp_tls_t *tls)
+{
+    for (int i = 0; i < TLS_SESSION_MAX; i++) {
+        if (tls_state.sessions[i].tls == tls) {
+            return &tls_state.sessions[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t tls_session_init(void)
+{
+    if (tls_state.initialized) {
+        return ESP_OK;
+    }
+    
+    memset(&tls_state, 0, sizeof(tls_state));
+    tls_state.cfg.servercert_buf = server_cert_pem_start;
+    tls_state.cfg.servercert_bytes = server_cert_pem_end - server_cert_pem_start;
+    tls_state.cfg.serverkey_buf = server_key_pem_start;
+    tls_state.cfg.serverkey_bytes = server_key_pem_end - server_key_pem_start;
+    
+#if CONFIG_ESP_TLS_SERVER_SESSION_TICKETS
+    // 会话票据：票据密钥只保存在内存中，重启后旧票据失效，客户端回退到完整握手
+    esp_err_t err = esp_tls_cfg_server_session_tickets_init(&tls_state.cfg);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "初始化会话票据失败: %s，只支持完整握手", esp_err_to_name(err));
+    }
+#else
+    // 未启用 CONFIG_ESP_TLS_SERVER_SESSION_TICKETS，每次连接都走完整握手
+    esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+#endif
+    
+    tls_state.initialized = true;
+    ESP_LOGI(TAG, "TLS会话初始化完成，最多 %d 个会话，会话票据: %s",
+             TLS_SESSION_MAX, err == ESP_OK ? "启用" : "禁用");
+    return ESP_OK;
+}
+
+struct esp_tls *tls_session_new(int fd)
+{
+    if (!tls_state.initialized) {
+        return NULL;
+    }
+    
+    tls_session_entry_t *entry = session_find(NULL);
+    if (entry == NULL) {
+        tls_state.stats.rejected++;
+        ESP_LOGW(TAG, "TLS会话数已达上限(%d)，拒绝连接: fd=%d", TLS_SESSION_MAX, fd);
+        return NULL;
+    }
+    
+    esp_tls_t *tls = esp_tls_init();
+    if (tls == NULL) {
+        ESP_LOGE(TAG, "分配TLS会话失败: fd=%d", fd);
+        return NULL;
+    }
+    
+    if (esp_tls_server_session_init(&tls_state.cfg, fd, tls) != ESP_OK) {
+        ESP_LOGE(TAG, "初始化TLS会话失败: fd=%d", fd);
+        esp_tls_server_session_delete(tls);
+        tls_state.stats.failures++;
+        return NULL;
+    }
+    
+    entry->tls = tls;
+    entry->started_us = esp_timer_get_time();
+    entry->write_len = 0;
+    return tls;
+}
+
+int tls_session_handshake(struct esp_tls *tls)
+{
+    tls_session_entry_t *entry = session_find(tls);
+    if (entry == NULL) {
+        return -1;
+    }
+    
+    int ret = esp_tls_server_session_continue_async(tls);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return 1;
+    }
+    if (ret != 0) {
+        tls_state.stats.failures++;
+        ESP_LOGW(TAG, "TLS握手失败: -0x%04x", (unsigned)-ret);
+        return -1;
+    }
+    
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - entry->started_us);
+    tls_state.stats.handshakes++;
+    tls_state.stats.last_us = elapsed;
+    if (tls_state.stats.min_us == 0 || elapsed < tls_state.stats.min_us) {
+        tls_state.stats.min_us = elapsed;
+    }
+    if (elapsed > tls_state.stats.max_us) {
+        tls_state.stats.max_us = elapsed;
+    }
+    ESP_LOGI(TAG, "TLS握手完成，耗时 %u ms", (unsigned)(elapsed / 1000));
+    return 0;
+}
+
+ssize_t tls_session_read(struct esp_tls *tls, void *buf, size_t len)
+{
+    ssize_t ret = esp_tls_conn_read(tls, buf, len);
+    if (ret >= 0) {
+        return ret;
+    }
+    errno = (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) ? EAGAIN : EIO;
+    return -1;
+}
+
+ssize_t tls_session_write(struct esp_tls *tls, const void *data, size_t len)
+{
+    tls_session_entry_t *entry = session_find(tls);
+    if (entry == NULL) {
+        errno = EBADF;
+        return -1;
+    }
+    
+    if (entry->write_len != 0 && len >= entry->write_len) {
+        len = entry->write_len;
+    }
+    
+    ssize_t ret = esp_tls_conn_write(tls, data, len);
+    if (ret >= 0) {
+        entry->write_len = 0;
+        return ret;
+    }
+    if (ret == ESP_TLS_ERR_SSL_WANT_WRITE || ret == ESP_TLS_ERR_SSL_WANT_READ) {
+        entry->write_len = len;
+        errno = EAGAIN;
+    } else {
+        errno = EIO;
+    }
+    return -1;
+}
+
+size_t tls_session_pending(struct esp_tls *tls)
+{
+    ssize_t avail = esp_tls_get_bytes_avail(tls);
+    return avail > 0 ? (size_t)avail : 0;
+}
+
+void tls_session_free(struct esp_tls *tls)
+{
+    tls_session_entry_t *entry = session_find(tls);
+    if (entry != NULL) {
+        entry->tls = NULL;
+    }
+    esp_tls_server_session_delete(tls);
+}
+
+#else // !TLS_SERVER_ENABLED
+
+esp_err_t tls_session_init(void)
+{
+    ESP_LOGW(TAG, "编译时未提供 main/certs/server_cert.pem 和 server_key.pem，TLS不可用");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+struct esp_tls *tls_session_new(int fd)
+{
+    return NULL;
+}
+
+int tls_session_handshake(struct esp_tls *tls)
+{
+    return -1;
+}
+
+ssize_t tls_session_read(struct esp_tls *tls, void *buf, size_t len)
+{
+    errno = EBADF;
+    return -1;
+}
+
+ssize_t tls_session_write(struct esp_tls *tls, const void *data, size_t len)
+{
+    errno = EBADF;
+    return -1;
+}
+
+size_t tls_session_pending(struct esp_tls *tls)
+{
+    return 0;
+}
+
+void tls_session_free(struct esp_tls *tls)
+{
+}
+
+#endif // TLS_SERVER_ENABLED
+
+void tls_session_get_stats(tls_session_stats_t *stats)
+{
+#ifdef TLS_SERVER_ENABLED
+    *stats = tls_state.stats;
+#else
+    memset(stats, 0, sizeof(*stats));
+#endif
+}
@@ -0,0 +1,106 @@
+/**
+ * @file tls_session.h
+ * @brief TLS会话管理头文件
+ * 
+ * 为TCP服务器的TLS监听端口提供服务器端TLS会话（基于esp-tls/mbedTLS，TLS 1.2）。
+ * 编译时 main/certs/ 下存在 server_cert.pem 和 server_key.pem 才启用（定义 TLS_SERVER_ENABLED），
+ * 证书和私钥嵌入固件，不提交到仓库。生成自签名证书:
+ * 
+ *   openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:prime256v1 -nodes -days 3650 \
+ *       -subj "/CN=smartfishfeeder" -keyout main/certs/server_key.pem -out main/certs/server_cert.pem
+ * 
+ * 完整握手需要一次ECDHE和一次ECDSA签名，开销较大；启用会话票据(RFC 5077)后，
+ * 客户端重连时带上票据即可走简化握手，不再做公钥运算。再配合长连接，握手开销被多条命令分摊。
+ * 会话票据需要 CONFIG_ESP_TLS_SERVER_SESSION_TICKETS（sdkconfig.defaults 中已启用），关闭时只支持完整握手。
+ * 握手以非阻塞方式推进，不会阻塞TCP服务器的事件循环等待网络数据。
+ * 
+ * 每个会话由mbedTLS在堆上分配收发缓冲区，同时存在的会话数限制为 TLS_SESSION_MAX
+ */
+
+#ifndef TLS_SESSION_H
+#define TLS_SESSION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include "esp_err.h"
+#include "socket_budget.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TLS_SESSION_MAX             2   /**< 同时存在的TLS会话数上限 */
+
+struct esp_tls;
+
+/**
+ * @brief 握手统计
+ */
+typedef struct {
+    uint32_t handshakes;        /**< 完成的握手次数 */
+    uint32_t failures;          /**< 失败的握手次数 */
+    uint32_t rejected;          /**< 会话数已满被拒绝的连接数 */
+    uint32_t last_us;           /**< 最近一次握手耗时（从接受连接到握手完成） */
+    uint32_t min_us;            /**< 最短握手耗时（通常是使用会话票据的简化握手） */
+    uint32_t max_us;            /**< 最长握手耗时（通常是完整握手） */
+} tls_session_stats_t;
+
+/**
+ * @brief 加载嵌入的证书和私钥，初始化会话票据
+ * @return ESP_OK 成功，ESP_ERR_NOT_SUPPORTED 编译时未提供证书
+ */
+esp_err_t tls_session_init(void);
+
+/**
+ * @brief 为已接受的连接创建TLS会话并开始握手
+ * @param fd 非阻塞的客户端socket
+ * @return 会话，NULL表示会话数已满或内存不足
+ */
+struct esp_tls *tls_session_new(int fd);
+
+/**
+ * @brief 推进握手（socket可读时调用）
+ * @return 0 握手完成，1 等待更多数据，-1 握手失败
+ */
+int tls_session_handshake(struct esp_tls *tls);
+
+/**
+ * @brief 读取解密后的数据
+ * @return 读取的字节数，0 对端关闭，-1 出错（errno为EAGAIN表示暂无数据）
+ */
+ssize_t tls_session_read(struct esp_tls *tls, void *buf, size_t len);
+
+/**
+ * @brief 以非阻塞方式加密并发送数据
+ * 
+ * 返回EAGAIN后必须以相同的起始地址再次调用，且len不小于上次的值
+ * （mbedTLS要求重试时使用相同的参数，实际只会发送上次的长度）
+ * 
+ * @return 发送的字节数，-1 出错（errno为EAGAIN表示发送窗口已满）
+ */
+ssize_t tls_session_write(struct esp_tls *tls, const void *data, size_t len);
+
+/**
+ * @brief mbedTLS中已解密、尚未读取的字节数
+ * 
+ * 这部分数据已经从socket读出，select不会再报告可读，需要主动读取
+ */
+size_t tls_session_pending(struct esp_tls *tls);
+
+/**
+ * @brief 释放TLS会话（不关闭socket）
+ */
+void tls_session_free(struct esp_tls *tls);
+
+/**
+ * @brief 获取握手统计
+ */
+void tls_session_get_stats(tls_session_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TLS_SESSION_H
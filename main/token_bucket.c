@@ -0,0 +1,64 @@
+/**
+ * @file token_bucket.c
+ * @brief 令牌桶限流实现
+ */
+
+#include "token_bucket.h"
+
+#define TOKEN_MILLI         1000    // 一个令牌
+#define REFILL_MAX_MS       60000   // 单次补充计算的最大时间间隔，防止乘法溢出
+
+void token_bucket_init(token_bucket_t *bucket, const token_bucket_config_t *config, TickType_t now)
+{
+    bucket->tokens_milli = (uint32_t)config->burst * TOKEN_MILLI;
+    bucket->last_tick = now;
+}
+
+bool token_bucket_peek(token_bucket_t *bucket, const token_bucket_config_t *config,
+                       TickType_t now, uint32_t *retry_after_ms)
+{
+    if (config->rate_per_sec == 0) {
+        return true;
+    }
+    
+    // 按经过的时间补充令牌: 每毫秒补充 rate_per_sec 个千分之一令牌
+    uint32_t elapsed_ms = pdTICKS_TO_MS(now - bucket->last_tick);
+    if (elapsed_ms > 0) {
+        if (elapsed_ms > REFILL_MAX_MS) {
+            elapsed_ms = REFILL_MAX_MS;
+        }
+        uint32_t capacity = (uint32_t)config->burst * TOKEN_MILLI;
+        bucket->tokens_milli += elapsed_ms * config->rate_per_sec;
+        if (bucket->tokens_milli > capacity) {
+            bucket->tokens_milli = capacity;
+        }
+        bucket->last_tick = now;
+    }
+    
+    if (bucket->tokens_milli >= TOKEN_MILLI) {
+        return true;
+    }
+    
+    if (retry_after_ms) {
+        uint32_t missing = TOKEN_MILLI - bucket->tokens_milli;
+        *retry_after_ms = (missing + config->rate_per_sec - 1) / config->rate_per_sec;
+    }
+    return false;
+}
+
+void token_bucket_take(token_bucket_t *bucket, const token_bucket_config_t *config)
+{
+    if (config->rate_per_sec != 0 && bucket->tokens_milli >= TOKEN_MILLI) {
+        bucket->tokens_milli -= TOKEN_MILLI;
+    }
+}
+
+bool token_bucket_consume(token_bucket_t *bucket, const token_bucket_config_t *config,
+                          TickType_t now, uint32_t *retry_after_ms)
+{
+    if (!token_bucket_peek(bucket, config, now, retry_after_ms)) {
+        return false;
+    }
+    token_bucket_take(bucket, config);
+    return true;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file token_bucket.h
+ * @brief 令牌桶限流头文件
+ * 
+ * 令牌以千分之一为单位存储，按FreeRTOS tick计算补充量，不使用浮点运算
+ */
+
+#ifndef TOKEN_BUCKET_H
+#define TOKEN_BUCKET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 令牌桶参数
+ */
+typedef struct {
+    uint16_t rate_per_sec;  /**< 每秒补充的令牌数，0表示不限制 */
+    uint16_t burst;         /**< 桶容量（允许的突发数量） */
+} token_bucket_config_t;
+
+/**
+ * @brief 令牌桶状态
+ */
+typedef struct {
+    uint32_t tokens_milli;  /**< 当前令牌数 x1000 */
+    TickType_t last_tick;   /**< 上次补充令牌的时间 */
+} token_bucket_t;
+
+/**
+ * @brief 初始化令牌桶为满桶
+ */
+void token_bucket_init(token_bucket_t *bucket, const token_bucket_config_t *config, TickType_t now);
+
+/**
+ * @brief 补充令牌并检查是否有一个可用的令牌，不消耗
+ * 
+ * 需要同时通过多个令牌桶时，先逐个检查，全部可用后再逐个调用 token_bucket_take，
+ * 避免前面的桶被消耗而后面的桶拒绝
+ * 
+ * @param bucket 令牌桶
+ * @param config 令牌桶参数
+ * @param now 当前tick
+ * @param retry_after_ms 没有令牌时输出需要等待的毫秒数，可为NULL
+ * @return true 有可用令牌（或不限制），false 令牌不足
+ */
+bool token_bucket_peek(token_bucket_t *bucket, const token_bucket_config_t *config,
+                       TickType_t now, uint32_t *retry_after_ms);
+
+/**
+ * @brief 消耗一个令牌，必须在同一时刻 token_bucket_peek 返回true之后调用
+ */
+void token_bucket_take(token_bucket_t *bucket, const token_bucket_config_t *config);
+
+/**
+ * @brief 尝试消耗一个令牌
+ * 
+ * @param bucket 令牌桶
+ * @param config 令牌桶参数
+ * @param now 当前tick
+ * @param retry_after_ms 失败时输出需要等待的毫秒数，可为NULL
+ * @return true 成功消耗，false 令牌不足
+ */
+bool token_bucket_consume(token_bucket_t *bucket, const token_bucket_config_t *config,
+                          TickType_t now, uint32_t *retry_after_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TOKEN_BUCKET_H
@@ -0,0 +1,394 @@
+/**
+ * @file udp_server.c
+ * @brief UDP控制通道实现
+ * 
+ * 每个数据报为一条 "#<id> <cmd>" 文本请求或一个二进制帧，命令分发与TCP服务器共用同一回调。
+ * 请求ID（二进制帧为序号）以源IP为作用域交给全局的请求去重缓存（request_cache.h），
+ * 只有被接受执行的动作命令才会记录，重发的请求返回缓存的执行结果
+ */
+
+#include "udp_server.h"
+#include "line_protocol.h"
+#include "binary_protocol.h"
+#include "command_handlers.h"
+#include "tcp_loop.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "lwip/sockets.h"
+#include <string.h>
+#include <stdio.h>
+
+static const char *TAG = "UDP_SERVER";
+
+#define UDP_SERVER_BUFFER_SIZE    64      // 请求数据报最大长度（接收缓冲区多留1字节用于检测超长）
+#define UDP_SERVER_RESPONSE_MAX   64      // 错误响应最大长度
+#define UDP_SERVER_STOP_TIMEOUT_MS 1000   // 停止时等待任务退出的最长时间
+
+// UDP控制通道状态
+typedef struct {
+    int server_fd;              // 服务器socket描述符
+    uint16_t port;              // 服务器端口
+    bool running;               // 运行状态
+    int wakeup_fd;              // 唤醒事件描述符(eventfd)，停止时用于唤醒阻塞的select
+    TaskHandle_t task;          // 接收任务句柄，任务退出后为NULL
+    SemaphoreHandle_t stopped;  // 接收任务退出信号
+    command_callback_t callback; // 命令回调函数
+} udp_server_state_t;
+
+static udp_server_state_t server_state = {
+    .server_fd = -1,
+    .port = 0,
+    .running = false,
+    .wakeup_fd = -1,
+    .task = NULL,
+    .stopped = NULL,
+    .callback = NULL,
+};
+
+/**
+ * @brief 发送数据报到请求方
+ */
+static int udp_send_to(const struct sockaddr_in *addr, const void *data, size_t len)
+{
+    ssize_t sent = sendto(server_state.server_fd, data, len, 0,
+                          (const struct sockaddr*)addr, sizeof(*addr));
+    if (sent < 0) {
+        ESP_LOGE(TAG, "发送响应失败: %s", strerror(errno));
+        return -1;
+    }
+    return sent;
+}
+
+/**
+ * @brief 命令回调的回复函数，发送到请求方
+ */
+static int udp_reply(const tcp_request_ctx_t *ctx, const void *data, size_t len)
+{
+    return udp_send_to(ctx->transport, data, len);
+}
+
+/**
+ * @brief 分发请求，请求ID以源IP为作用域交给命令处理的去重逻辑
+ */
+static void dispatch_request(const command_t *cmd, const char *req_id, tcp_reply_format_t format,
+                             uint16_t seq, const struct sockaddr_in *addr)
+{
+    // UDP无连接，不支持异步完成通知（conn_id为0）；重发的请求由请求去重缓存返回最终结果
+    tcp_request_ctx_t ctx = {
+        .client_fd = -1,
+        .conn_id = 0,
+        .format = format,
+        .seq = seq,
+        .reply = udp_reply,
+        .transport = (void *)addr,
+        .dedupe_id = req_id,
+        .dedupe_scope = addr->sin_addr.s_addr,
+        .perm = COMMAND_PERM_ADMIN,
+    };
+    
+    // 二进制请求没有文本标签，回复按seq匹配
+    if (format == TCP_REPLY_FORMAT_TEXT) {
+        strncpy(ctx.tag, req_id, TCP_SERVER_TAG_MAX_LEN);
+        ctx.tag[TCP_SERVER_TAG_MAX_LEN] = '\0';
+    } else {
+        ctx.tag[0] = '\0';
+    }
+    
+    // 与TCP共用按源IP和全局的令牌桶，超限时回复BUSY
+    if (!command_admit(cmd, &ctx, addr->sin_addr.s_addr)) {
+        return;
+    }
+    server_state.callback(cmd, &ctx);
+}
+
+/**
+ * @brief 处理二进制帧请求数据报，以序号作为请求ID去重
+ */
+static void handle_binary_datagram(const uint8_t *data, size_t len, const struct sockaddr_in *addr)
+{
+    command_t cmd;
+    binary_frame_info_t info;
+    uint8_t reply[BINARY_PROTOCOL_MAX_FRAME];
+    char req_id[LINE_PROTOCOL_TAG_MAX_LEN + 1];
+    
+    binary_parse_result_t result = binary_protocol_parse(data, len, &cmd, &info);
+    if (result == BINARY_PARSE_NEED_MORE || result == BINARY_PARSE_BAD_FRAME) {
+        ESP_LOGW(TAG, "丢弃不完整的二进制帧 (长度: %u)", (unsigned)len);
+        return;
+    }
+    
+    if (result == BINARY_PARSE_BAD_CRC || result == BINARY_PARSE_BAD_REQUEST) {
+        size_t n = binary_protocol_encode_reply(reply, sizeof(reply), info.opcode, info.seq,
+                                                result == BINARY_PARSE_BAD_CRC ?
+                                                COMMAND_RESULT_BAD_CRC : COMMAND_RESULT_BAD_REQUEST,
+                                                NULL, 0);
+        udp_send_to(addr, reply, n);
+        return;
+    }
+    
+    // 以 "~<seq十六进制>" 作为去重键，与文本请求ID区分（'~'不是合法的标签字符）
+    static const char hex[] = "0123456789abcdef";
+    req_id[0] = '~';
+    for (int i = 0; i < 4; i++) {
+        req_id[1 + i] = hex[(info.seq >> (12 - 4 * i)) & 0x0F];
+    }
+    req_id[5] = '\0';
+    
+    dispatch_request(&cmd, req_id, TCP_REPLY_FORMAT_BINARY, info.seq, addr);
+}
+
+/**
+ * @brief 处理文本请求数据报 "#<id> <cmd>"
+ */
+static void handle_text_datagram(char *data, size_t len, const struct sockaddr_in *addr)
+{
+    char req_id[LINE_PROTOCOL_TAG_MAX_LEN + 1];
+    char response[UDP_SERVER_RESPONSE_MAX];
+    command_t cmd;
+    
+    // 去掉行尾换行符
+    while (len > 0 && (data[len - 1] == '\n' || data[len - 1] == '\r')) {
+        len--;
+    }
+    
+    if (len == 0 || data[0] != LINE_PROTOCOL_PREFIX) {
+        udp_send_to(addr, "#? ERROR request-id-required\n", strlen("#? ERROR request-id-required\n"));
+        return;
+    }
+    
+    line_protocol_result_t result = line_protocol_parse(data + 1, len - 1, req_id, &cmd);
+    if (result == LINE_PROTOCOL_BAD_TAG) {
+        udp_send_to(addr, "#? ERROR bad-tag\n", strlen("#? ERROR bad-tag\n"));
+        return;
+    }
+    
+    if (result != LINE_PROTOCOL_OK) {
+        int n = snprintf(response, sizeof(response), "#%s ERROR bad-command\n", req_id);
+        udp_send_to(addr, response, n);
+        return;
+    }
+    
+    ESP_LOGI(TAG, "收到请求: #%s (类型: %d)", req_id, cmd.type);
+    
+    dispatch_request(&cmd, req_id, TCP_REPLY_FORMAT_TEXT, 0, addr);
+}
+
+/**
+ * @brief 回复超长的请求数据报
+ * 
+ * 二进制帧按帧头中的操作码和序号回复 BAD_REQUEST（合法帧不会超过 BINARY_PROTOCOL_MAX_FRAME），
+ * 其余按文本请求回复错误；截断后的内容不会被解析执行
+ */
+static void reply_oversized(const char *data, const struct sockaddr_in *addr)
+{
+    ESP_LOGW(TAG, "丢弃超过 %d 字节的请求数据报", UDP_SERVER_BUFFER_SIZE);
+    
+    if ((uint8_t)data[0] == BINARY_PROTOCOL_SOF) {
+        const uint8_t *header = (const uint8_t *)data;
+        uint8_t reply[BINARY_PROTOCOL_MAX_FRAME];
+        size_t n = binary_protocol_encode_reply(reply, sizeof(reply), header[2],
+                                                header[3] | (header[4] << 8),
+                                                COMMAND_RESULT_BAD_REQUEST, NULL, 0);
+        udp_send_to(addr, reply, n);
+        return;
+    }
+    udp_send_to(addr, "#? ERROR datagram-too-long\n", strlen("#? ERROR datagram-too-long\n"));
+}
+
+/**
+ * @brief 处理一个请求数据报
+ */
+static void handle_datagram(char *data, size_t len, const struct sockaddr_in *addr)
+{
+    if (server_state.callback == NULL) {
+        ESP_LOGW(TAG, "未注册命令回调，丢弃请求");
+        return;
+    }
+    
+    if (len > 0 && (uint8_t)data[0] == BINARY_PROTOCOL_SOF) {
+        handle_binary_datagram((const uint8_t *)data, len, addr);
+    } else {
+        handle_text_datagram(data, len, addr);
+    }
+}
+
+/**
+ * @brief UDP控制通道任务
+ * 
+ * 阻塞在select中等待数据报或唤醒事件，socket只由本任务读取，停止时由 udp_server_stop 在任务退出后关闭
+ */
+static void udp_server_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "UDP控制通道任务启动");
+    
+    int server_fd = server_state.server_fd;
+    
+    while (server_state.running) {
+        char buffer[UDP_SERVER_BUFFER_SIZE + 1];
+        struct sockaddr_in source_addr;
+        socklen_t addr_len = sizeof(source_addr);
+        
+        // 唤醒事件已由 tcp_loop_wait 清除，回到循环开头检查运行状态
+        tcp_loop_fds_t fds;
+        tcp_loop_fds_init(&fds, server_state.wakeup_fd);
+        tcp_loop_watch_read(&fds, server_fd);
+        if (tcp_loop_wait(&fds, portMAX_DELAY) <= 0 || !FD_ISSET(server_fd, &fds.read_fds)) {
+            continue;
+        }
+        
+        ssize_t len = recvfrom(server_fd, buffer, sizeof(buffer), MSG_DONTWAIT,
+                               (struct sockaddr*)&source_addr, &addr_len);
+        if (len < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ESP_LOGE(TAG, "接收数据失败: %s", strerror(errno));
+                vTaskDelay(pdMS_TO_TICKS(100));
+            }
+            continue;
+        }
+        
+        // 超长的数据报被recvfrom截断，读到多出的1字节即可判断
+        if (len > UDP_SERVER_BUFFER_SIZE) {
+            reply_oversized(buffer, &source_addr);
+            continue;
+        }
+        
+        handle_datagram(buffer, len, &source_addr);
+    }
+    
+    ESP_LOGI(TAG, "UDP控制通道任务退出");
+    
+    // 通知 udp_server_stop 任务已退出
+    server_state.task = NULL;
+    xSemaphoreGive(server_state.stopped);
+    vTaskDelete(NULL);
+}
+
+esp_err_t udp_server_init(uint16_t port)
+{
+    ESP_LOGI(TAG, "初始化UDP控制通道，端口: %d", port);
+    
+    if (port == 0) {
+        port = 8081;  // 默认端口
+    }
+    
+    if (server_state.running || server_state.task != NULL || server_state.server_fd >= 0) {
+        ESP_LOGE(TAG, "UDP控制通道已初始化，需先停止");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    server_state.port = port;
+    
+    if (server_state.stopped == NULL) {
+        server_state.stopped = xSemaphoreCreateBinary();
+        if (server_state.stopped == NULL) {
+            ESP_LOGE(TAG, "创建信号量失败");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    // 创建唤醒事件描述符，停止时用于唤醒阻塞的select
+    if (server_state.wakeup_fd < 0) {
+        esp_err_t err = tcp_loop_wakeup_create(&server_state.wakeup_fd);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    
+    server_state.server_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (server_state.server_fd < 0) {
+        ESP_LOGE(TAG, "创建socket失败: %s", strerror(errno));
+        return ESP_FAIL;
+    }
+    
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(port);
+    
+    if (bind(server_state.server_fd, (struct sockaddr*)&server_addr,
+             sizeof(server_addr)) < 0) {
+        ESP_LOGE(TAG, "绑定地址失败: %s", strerror(errno));
+        close(server_state.server_fd);
+        server_state.server_fd = -1;
+        return ESP_FAIL;
+    }
+    
+    ESP_LOGI(TAG, "UDP控制通道初始化完成，监听端口 %d", port);
+    
+    return ESP_OK;
+}
+
+esp_err_t udp_server_start(void)
+{
+    if (server_state.server_fd < 0) {
+        ESP_LOGE(TAG, "UDP控制通道未初始化");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (server_state.running) {
+        ESP_LOGW(TAG, "UDP控制通道已经在运行");
+        return ESP_OK;
+    }
+    
+    if (server_state.task != NULL) {
+        ESP_LOGE(TAG, "上一次停止尚未完成，接收任务仍未退出");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // 在创建任务前置位，连续两次启动只会创建一个任务，任务启动前调用udp_server_stop也能正确停止
+    server_state.running = true;
+    xSemaphoreTake(server_state.stopped, 0);
+    
+    BaseType_t ret = xTaskCreate(
+        udp_server_task,           // 任务函数
+        "udp_server",             // 任务名称
+        3072,                      // 堆栈大小
+        NULL,                      // 参数
+        5,                         // 优先级
+        &server_state.task         // 任务句柄
+    );
+    
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "创建任务失败");
+        server_state.running = false;
+        server_state.task = NULL;
+        return ESP_FAIL;
+    }
+    
+    return ESP_OK;
+}
+
+esp_err_t udp_server_stop(void)
+{
+    ESP_LOGI(TAG, "停止UDP控制通道");
+    
+    // 唤醒接收任务并等待其退出；上一次停止超时时任务可能仍未退出，继续等待
+    if (server_state.running || server_state.task != NULL) {
+        server_state.running = false;
+        tcp_loop_wakeup(server_state.wakeup_fd);
+        
+        if (xSemaphoreTake(server_state.stopped, pdMS_TO_TICKS(UDP_SERVER_STOP_TIMEOUT_MS)) != pdTRUE) {
+            // 任务可能仍在使用socket，保留不关闭，由调用方稍后重试
+            ESP_LOGE(TAG, "等待接收任务退出超时，socket保持不变");
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    
+    // 任务已退出，可以安全关闭socket
+    if (server_state.server_fd >= 0) {
+        close(server_state.server_fd);
+        server_state.server_fd = -1;
+    }
+    
+    ESP_LOGI(TAG, "UDP控制通道已停止");
+    return ESP_OK;
+}
+
+void udp_server_register_command_callback(command_callback_t callback)
+{
+    server_state.callback = callback;
+    ESP_LOGI(TAG, "命令回调已注册");
+}
@@ -0,0 +1,54 @@
+/**
+ * @file udp_server.h
+ * @brief UDP控制通道头文件
+ * 
+ * 提供无连接的低延迟控制通道，一个数据报即完成一次请求/响应。
+ * 请求格式与TCP标签协议相同: "#<id> <cmd>"，其中id为必填的请求ID；
+ * 也可以发送二进制帧（见 binary_protocol.h），以帧序号作为请求ID。
+ * 数据报最长64字节，超长的数据报不会被执行，回复 "#? ERROR datagram-too-long"（二进制帧回复 BAD_REQUEST）。
+ * 请求ID以源IP为作用域记录在全局的请求去重缓存中（见 request_cache.h），只记录被接受执行的动作命令，
+ * 客户端重发同一请求ID时返回缓存的执行结果而不会重复执行动作；队列已满被拒绝的请求不记录，重发时重新执行
+ */
+
+#ifndef UDP_SERVER_H
+#define UDP_SERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "tcp_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 初始化UDP控制通道
+ * @param port 监听端口号
+ * @return ESP_OK 成功，其他值失败
+ */
+esp_err_t udp_server_init(uint16_t port);
+
+/**
+ * @brief 启动UDP控制通道任务，已在运行时直接返回
+ * @return ESP_OK 成功；ESP_ERR_INVALID_STATE 未初始化或上一次停止尚未完成
+ */
+esp_err_t udp_server_start(void);
+
+/**
+ * @brief 停止UDP控制通道：唤醒接收任务，等待其退出后关闭socket（再次启动前需重新初始化）
+ * @return ESP_OK 成功；ESP_ERR_TIMEOUT 任务未在时限内退出，socket保持不变，可稍后重试
+ */
+esp_err_t udp_server_stop(void);
+
+/**
+ * @brief 注册控制命令回调（与TCP服务器使用同一回调类型）
+ * @param callback 回调函数
+ */
+void udp_server_register_command_callback(command_callback_t callback);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UDP_SERVER_H
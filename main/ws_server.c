@@ -0,0 +1,555 @@
+/**
+ * @file ws_server.c
+ * @brief WebSocket服务器实现
+ * 
+ * 请求在httpd任务中解析后分发给与TCP服务器共用的命令回调，
+ * 同一个输入帧产生的回复合并为一个输出帧。
+ * 事件推送在httpd任务的工作队列中执行：从事件流读出一批事件写入共享缓冲区，
+ * 再把同一个缓冲区依次发送给所有订阅的连接；跟不上推送的订阅者被关闭（见 broadcast_work）
+ */
+
+#include "ws_server.h"
+#include "line_protocol.h"
+#include "binary_protocol.h"
+#include "event_stream.h"
+#include "command_handlers.h"
+#include "tcp_loop.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_http_server.h"
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+static const char *TAG = "WS_SERVER";
+
+#define WS_SERVER_RX_MAX          128     // 单个输入帧最大长度
+#define WS_SERVER_TX_MAX          256     // 单个回复帧最大长度
+#define WS_SERVER_BROADCAST_MAX   512     // 单个推送帧最大长度
+#define WS_SERVER_LAG_MAX_LEN     24      // 事件丢失提示的最大长度
+#define WS_SERVER_SEND_TIMEOUT_S  1       // 发送超时，推送超时的订阅者在第一次超时后即被关闭
+
+// WebSocket连接表项
+typedef struct {
+    int fd;                     // socket描述符，-1表示空闲
+    bool subscriber;            // 是否接收事件推送
+} ws_client_t;
+
+// 单个输入帧的回复合并缓冲区
+typedef struct {
+    httpd_req_t *req;           // 当前请求
+    httpd_ws_type_t type;       // 回复帧类型（与输入帧相同）
+    uint8_t buf[WS_SERVER_TX_MAX]; // 合并的回复
+    size_t len;                 // 已用长度
+} ws_batch_t;
+
+// WebSocket服务器状态
+typedef struct {
+    httpd_handle_t server;      // httpd服务器句柄
+    uint16_t port;              // 服务器端口
+    command_callback_t callback; // 命令回调函数
+    portMUX_TYPE lock;          // 保护推送任务排队标志
+    bool broadcast_queued;      // 推送任务已在httpd工作队列中
+    uint32_t event_cursor;      // 事件流读取位置（所有连接共用）
+    ws_client_t clients[WS_SERVER_MAX_CLIENTS]; // 连接表（只在httpd任务中访问）
+    uint8_t broadcast_buf[WS_SERVER_BROADCAST_MAX]; // 共享推送缓冲区
+} ws_server_state_t;
+
+static ws_server_state_t server_state = {
+    .server = NULL,
+    .port = 0,
+    .callback = NULL,
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+    .broadcast_queued = false,
+};
+
+/**
+ * @brief 按描述符查找连接表项
+ */
+static ws_client_t *client_find(int fd)
+{
+    for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
+        if (server_state.clients[i].fd == fd) {
+            return &server_state.clients[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 发送合并缓冲区中的回复
+ */
+static void batch_flush(ws_batch_t *batch)
+{
+    if (batch->len == 0) {
+        return;
+    }
+    
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .type = batch->type,
+        .payload = batch->buf,
+        .len = batch->len,
+    };
+    esp_err_t err = httpd_ws_send_frame(batch->req, &frame);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "发送回复失败: %s", esp_err_to_name(err));
+    }
+    batch->len = 0;
+}
+
+/**
+ * @brief 追加回复到合并缓冲区
+ */
+static int batch_write(ws_batch_t *batch, const void *data, size_t len)
+{
+    if (batch->len + len > sizeof(batch->buf)) {
+        batch_flush(batch);
+    }
+    if (len > sizeof(batch->buf)) {
+        return -1;
+    }
+    
+    memcpy(batch->buf + batch->len, data, len);
+    batch->len += len;
+    return len;
+}
+
+/**
+ * @brief 命令回调的回复函数
+ */
+static int ws_reply(const tcp_request_ctx_t *ctx, const void *data, size_t len)
+{
+    return batch_write(ctx->transport, data, len);
+}
+
+/**
+ * @brief 处理订阅/取消订阅
+ */
+static void handle_subscription(ws_batch_t *batch, const command_t *cmd, const char *tag)
+{
+    char response[LINE_PROTOCOL_TAG_MAX_LEN + 16];
+    ws_client_t *client = client_find(httpd_req_to_sockfd(batch->req));
+    bool subscribe = cmd->type == COMMAND_TYPE_SUBSCRIBE;
+    
+    if (client) {
+        client->subscriber = subscribe;
+    }
+    
+    int n = snprintf(response, sizeof(response), "#%s %s\n", tag, subscribe ? "SUBSCRIBED" : "UNSUBSCRIBED");
+    batch_write(batch, response, n);
+}
+
+/**
+ * @brief 分发命令
+ * 
+ * WebSocket请求不支持异步完成回复（conn_id为0），动作完成通过事件推送通知
+ */
+static void dispatch_command(ws_batch_t *batch, const command_t *cmd, const char *tag,
+                             tcp_reply_format_t format, uint16_t seq)
+{
+    if (server_state.callback == NULL) {
+        return;
+    }
+    
+    tcp_request_ctx_t ctx = {
+        .client_fd = httpd_req_to_sockfd(batch->req),
+        .conn_id = 0,
+        .format = format,
+        .seq = seq,
+        .reply = ws_reply,
+        .transport = batch,
+        .perm = COMMAND_PERM_ADMIN,
+    };
+    strncpy(ctx.tag, tag, TCP_SERVER_TAG_MAX_LEN);
+    ctx.tag[TCP_SERVER_TAG_MAX_LEN] = '\0';
+    
+    // 与TCP共用按源IP和全局的令牌桶，超限时回复BUSY
+    if (!command_admit(cmd, &ctx, tcp_loop_peer_addr(ctx.client_fd))) {
+        return;
+    }
+    server_state.callback(cmd, &ctx);
+}
+
+/**
+ * @brief 处理文本帧中的一行请求
+ */
+static void handle_text_line(ws_batch_t *batch, const char *line, size_t len)
+{
+    char tag[LINE_PROTOCOL_TAG_MAX_LEN + 1];
+    char response[LINE_PROTOCOL_TAG_MAX_LEN + 32];
+    command_t cmd;
+    
+    if (len == 0) {
+        return;
+    }
+    
+    // 旧协议：单个数字
+    if (line[0] != LINE_PROTOCOL_PREFIX) {
+        if (len == 1 && line[0] >= '0' && line[0] <= '9') {
+            cmd.type = COMMAND_TYPE_DIGIT;
+            cmd.args.digit.index = line[0] - '0';
+            dispatch_command(batch, &cmd, "", TCP_REPLY_FORMAT_TEXT, 0);
+        } else {
+            batch_write(batch, "#? ERROR bad-command\n", strlen("#? ERROR bad-command\n"));
+        }
+        return;
+    }
+    
+    line_protocol_result_t result = line_protocol_parse(line + 1, len - 1, tag, &cmd);
+    if (result == LINE_PROTOCOL_BAD_TAG) {
+        batch_write(batch, "#? ERROR bad-tag\n", strlen("#? ERROR bad-tag\n"));
+        return;
+    }
+    if (result != LINE_PROTOCOL_OK) {
+        int n = snprintf(response, sizeof(response), "#%s ERROR bad-command\n", tag);
+        batch_write(batch, response, n);
+        return;
+    }
+    
+    if (cmd.type == COMMAND_TYPE_SUBSCRIBE || cmd.type == COMMAND_TYPE_UNSUBSCRIBE) {
+        handle_subscription(batch, &cmd, tag);
+        return;
+    }
+    
+    ESP_LOGI(TAG, "收到标签命令: #%s (类型: %d)", tag, cmd.type);
+    dispatch_command(batch, &cmd, tag, TCP_REPLY_FORMAT_TEXT, 0);
+}
+
+/**
+ * @brief 处理文本帧，每行一条请求
+ */
+static void handle_text_frame(ws_batch_t *batch, const char *data, size_t len)
+{
+    size_t start = 0;
+    
+    for (size_t i = 0; i <= len; i++) {
+        if (i == len || data[i] == '\n' || data[i] == '\r') {
+            handle_text_line(batch, data + start, i - start);
+            start = i + 1;
+        }
+    }
+}
+
+/**
+ * @brief 处理二进制帧，一个WebSocket帧中可以包含多个命令帧
+ */
+static void handle_binary_frame(ws_batch_t *batch, const uint8_t *data, size_t len)
+{
+    size_t pos = 0;
+    
+    while (pos < len) {
+        command_t cmd;
+        binary_frame_info_t info;
+        binary_parse_result_t result = binary_protocol_parse(data + pos, len - pos, &cmd, &info);
+        
+        if (result == BINARY_PARSE_NEED_MORE || result == BINARY_PARSE_BAD_FRAME) {
+            ESP_LOGW(TAG, "丢弃不完整的二进制帧 (剩余长度: %u)", (unsigned)(len - pos));
+            return;
+        }
+        
+        if (result == BINARY_PARSE_OK) {
+            dispatch_command(batch, &cmd, "", TCP_REPLY_FORMAT_BINARY, info.seq);
+        } else {
+            uint8_t reply[BINARY_PROTOCOL_MAX_FRAME];
+            size_t n = binary_protocol_encode_reply(reply, sizeof(reply), info.opcode, info.seq,
+                                                    result == BINARY_PARSE_BAD_CRC ?
+                                                    COMMAND_RESULT_BAD_CRC : COMMAND_RESULT_BAD_REQUEST,
+                                                    NULL, 0);
+            batch_write(batch, reply, n);
+        }
+        pos += info.frame_len;
+    }
+}
+
+/**
+ * @brief 加入连接表（WebSocket握手完成时调用）
+ */
+static void client_add(int fd)
+{
+    ws_client_t *client = client_find(fd);
+    if (client == NULL) {
+        client = client_find(-1);
+    }
+    if (client == NULL) {
+        // httpd的max_open_sockets与连接表大小相同，正常不会发生
+        ESP_LOGW(TAG, "连接表已满: fd=%d", fd);
+        return;
+    }
+    
+    client->fd = fd;
+    client->subscriber = true;
+}
+
+/**
+ * @brief /ws URI处理函数
+ */
+static esp_err_t ws_handler(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET) {
+        int fd = httpd_req_to_sockfd(req);
+        client_add(fd);
+        ESP_LOGI(TAG, "WebSocket握手完成: fd=%d", fd);
+        return ESP_OK;
+    }
+    
+    uint8_t buf[WS_SERVER_RX_MAX];
+    httpd_ws_frame_t frame = {
+        .payload = NULL,
+    };
+    
+    // 先取得帧长度
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "接收帧头失败: %s", esp_err_to_name(err));
+        return err;
+    }
+    
+    if (frame.len > sizeof(buf)) {
+        ESP_LOGW(TAG, "帧过长: %u 字节", (unsigned)frame.len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    frame.payload = buf;
+    err = httpd_ws_recv_frame(req, &frame, sizeof(buf));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "接收帧失败: %s", esp_err_to_name(err));
+        return err;
+    }
+    
+    if (frame.type != HTTPD_WS_TYPE_TEXT && frame.type != HTTPD_WS_TYPE_BINARY) {
+        return ESP_OK;
+    }
+    
+    static ws_batch_t batch;    // 只在httpd任务中使用，避免占用任务栈
+    batch.req = req;
+    batch.type = frame.type;
+    batch.len = 0;
+    
+    if (frame.type == HTTPD_WS_TYPE_TEXT) {
+        handle_text_frame(&batch, (const char *)buf, frame.len);
+    } else {
+        handle_binary_frame(&batch, buf, frame.len);
+    }
+    
+    // 本帧产生的所有回复合并为一个帧发送
+    batch_flush(&batch);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief 连接关闭回调，从连接表中移除
+ */
+static void ws_close_fn(httpd_handle_t hd, int sockfd)
+{
+    ws_client_t *client = client_find(sockfd);
+    if (client) {
+        client->fd = -1;
+        ESP_LOGI(TAG, "WebSocket连接已关闭: fd=%d", sockfd);
+    }
+    close(sockfd);
+}
+
+/**
+ * @brief 把事件批量写入共享推送缓冲区
+ * @return 写入的长度，0表示没有新事件
+ */
+static size_t broadcast_fill(void)
+{
+    size_t len = 0;
+    
+    while (len + EVENT_STREAM_EVENT_MAX_LEN + WS_SERVER_LAG_MAX_LEN <= sizeof(server_state.broadcast_buf)) {
+        uint32_t missed = 0;
+        char *out = (char *)server_state.broadcast_buf + len;
+        size_t n = event_stream_read(&server_state.event_cursor, out, &missed);
+        
+        if (missed > 0) {
+            // 丢失提示放在本事件之前
+            char lag[WS_SERVER_LAG_MAX_LEN];
+            int lag_len = snprintf(lag, sizeof(lag), "!LAG missed=%u\n", (unsigned)missed);
+            memmove(out + lag_len, out, n);
+            memcpy(out, lag, lag_len);
+            n += lag_len;
+        }
+        
+        if (n == 0) {
+            break;
+        }
+        len += n;
+    }
+    
+    return len;
+}
+
+/**
+ * @brief 订阅者的socket当前是否可写（不等待）
+ */
+static bool client_writable(int fd)
+{
+    tcp_loop_fds_t fds;
+    tcp_loop_fds_init(&fds, -1);
+    tcp_loop_watch_write(&fds, fd);
+    return tcp_loop_wait(&fds, 0) > 0;
+}
+
+/**
+ * @brief 推送事件（在httpd任务中执行）
+ * 
+ * 每批事件只序列化一次，同一缓冲区在httpd任务中依次同步发给各订阅者，没有按连接的发送队列，
+ * 因此一个慢订阅者会推迟排在它后面的订阅者和httpd的其他请求。为限制影响：
+ * 发送缓冲区已满（socket不可写）的订阅者不再发送而直接关闭；发送时仍阻塞的订阅者
+ * 最多拖慢一次 WS_SERVER_SEND_TIMEOUT_S，第一次超时或失败后即被关闭，之后的批次不再等待它
+ */
+static void broadcast_work(void *arg)
+{
+    portENTER_CRITICAL(&server_state.lock);
+    server_state.broadcast_queued = false;
+    portEXIT_CRITICAL(&server_state.lock);
+    
+    size_t len;
+    while ((len = broadcast_fill()) > 0) {
+        httpd_ws_frame_t frame = {
+            .final = true,
+            .type = HTTPD_WS_TYPE_TEXT,
+            .payload = server_state.broadcast_buf,
+            .len = len,
+        };
+        
+        for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
+            ws_client_t *client = &server_state.clients[i];
+            if (client->fd < 0 || !client->subscriber) {
+                continue;
+            }
+            if (httpd_ws_get_fd_info(server_state.server, client->fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+                continue;
+            }
+            if (!client_writable(client->fd)) {
+                ESP_LOGW(TAG, "订阅者发送缓冲区已满，关闭连接: fd=%d", client->fd);
+                client->subscriber = false;
+                httpd_sess_trigger_close(server_state.server, client->fd);
+                continue;
+            }
+            if (httpd_ws_send_frame_async(server_state.server, client->fd, &frame) != ESP_OK) {
+                ESP_LOGW(TAG, "推送超时或失败，关闭连接: fd=%d", client->fd);
+                client->subscriber = false;
+                httpd_sess_trigger_close(server_state.server, client->fd);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 新事件通知，在发布者的任务中调用，把推送任务放入httpd工作队列
+ */
+static void ws_event_listener(void)
+{
+    if (server_state.server == NULL) {
+        return;
+    }
+    
+    // 推送任务已排队时无需重复排队，它会读出所有新事件
+    portENTER_CRITICAL(&server_state.lock);
+    bool queued = server_state.broadcast_queued;
+    server_state.broadcast_queued = true;
+    portEXIT_CRITICAL(&server_state.lock);
+    
+    if (!queued && httpd_queue_work(server_state.server, broadcast_work, NULL) != ESP_OK) {
+        portENTER_CRITICAL(&server_state.lock);
+        server_state.broadcast_queued = false;
+        portEXIT_CRITICAL(&server_state.lock);
+    }
+}
+
+esp_err_t ws_server_init(uint16_t port)
+{
+    ESP_LOGI(TAG, "初始化WebSocket服务器，端口: %d", port);
+    
+    if (port == 0) {
+        port = 80;  // 默认端口
+    }
+    
+    server_state.port = port;
+    for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
+        server_state.clients[i].fd = -1;
+        server_state.clients[i].subscriber = false;
+    }
+    
+    return event_stream_add_listener(ws_event_listener);
+}
+
+esp_err_t ws_server_start(void)
+{
+    if (server_state.server != NULL) {
+        ESP_LOGW(TAG, "WebSocket服务器已经在运行");
+        return ESP_OK;
+    }
+    
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = server_state.port;
+    config.max_open_sockets = WS_SERVER_MAX_CLIENTS;
+    config.lru_purge_enable = true;
+    config.send_wait_timeout = WS_SERVER_SEND_TIMEOUT_S;
+    config.close_fn = ws_close_fn;
+    
+    server_state.event_cursor = event_stream_head();
+    
+    esp_err_t err = httpd_start(&server_state.server, &config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "启动httpd失败: %s", esp_err_to_name(err));
+        server_state.server = NULL;
+        return err;
+    }
+    
+    const httpd_uri_t ws_uri = {
+        .uri = "/ws",
+        .method = HTTP_GET,
+        .handler = ws_handler,
+        .user_ctx = NULL,
+        .is_websocket = true,
+    };
+    err = httpd_register_uri_handler(server_state.server, &ws_uri);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "注册URI失败: %s", esp_err_to_name(err));
+        httpd_stop(server_state.server);
+        server_state.server = NULL;
+        return err;
+    }
+    
+    ESP_LOGI(TAG, "WebSocket服务器已启动: ws://<IP>:%d/ws", server_state.port);
+    
+    return ESP_OK;
+}
+
+void ws_server_stop(void)
+{
+    ESP_LOGI(TAG, "停止WebSocket服务器");
+    
+    if (server_state.server != NULL) {
+        httpd_handle_t server = server_state.server;
+        server_state.server = NULL;
+        httpd_stop(server);
+    }
+}
+
+void ws_server_register_command_callback(command_callback_t callback)
+{
+    server_state.callback = callback;
+    ESP_LOGI(TAG, "命令回调已注册");
+}
+
+httpd_handle_t ws_server_get_handle(void)
+{
+    return server_state.server;
+}
+
+int ws_server_get_client_count(void)
+{
+    int count = 0;
+    for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
+        if (server_state.clients[i].fd >= 0) {
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file ws_server.h
+ * @brief WebSocket服务器头文件
+ * 
+ * 供浏览器控制面板直接控制和查看喂鱼器，基于esp_http_server的WebSocket支持。
+ * 地址: ws://<设备IP>:<端口>/ws
+ * 
+ * 协议:
+ *   - 文本帧: 每行一条请求，格式与TCP标签协议相同 "#<tag> <cmd>"，也可以是单个数字'0'-'9'
+ *   - 二进制帧: 一个或多个二进制命令帧，格式见 binary_protocol.h
+ *   - 服务器推送: 所有连接默认接收事件流（"!<seq> <事件>"，见 event_stream.h），
+ *     同一批事件只序列化一次，所有连接共用同一个缓冲区在httpd任务中依次发送，
+ *     发送缓冲区已满或推送超时的连接会被关闭；
+ *     "#<tag> UNSUBSCRIBE" 可取消推送，"#<tag> SUBSCRIBE" 恢复
+ * 
+ * 其他HTTP接口（如REST API）可以注册到同一个httpd实例上，共用连接数上限
+ */
+
+#ifndef WS_SERVER_H
+#define WS_SERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "tcp_server.h"
+#include "socket_budget.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 初始化WebSocket服务器
+ * @param port 监听端口号
+ * @return ESP_OK 成功，其他值失败
+ */
+esp_err_t ws_server_init(uint16_t port);
+
+/**
+ * @brief 启动WebSocket服务器
+ * @return ESP_OK 成功，其他值失败
+ */
+esp_err_t ws_server_start(void);
+
+/**
+ * @brief 停止WebSocket服务器
+ */
+void ws_server_stop(void);
+
+/**
+ * @brief 注册控制命令回调（与TCP服务器使用同一回调类型）
+ * @param callback 回调函数
+ */
+void ws_server_register_command_callback(command_callback_t callback);
+
+/**
+ * @brief 获取httpd服务器句柄，用于注册其他URI
+ * @return 服务器句柄，未启动时为NULL
+ */
+httpd_handle_t ws_server_get_handle(void);
+
+/**
+ * @brief 获取当前WebSocket连接数
+ * @return 连接数
+ */
+int ws_server_get_client_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WS_SERVER_H
@@ -0,0 +1,143 @@
+/**
+ * @file mock_actuator.c
+ * @brief 主机构建的模拟执行器
+ * 
+ * 与 actuator.c 的接口和语义一致：有界队列（ACTUATOR_QUEUE_LENGTH）、队列满时立即拒绝、
+ * 执行器任务依次执行并在完成后调用完成回调、STOP 取消排队命令。
+ * 每次动作（含复位）按 move_ms 计时，不驱动舵机
+ */
+
+#include "actuator.h"
+#include "mock_actuator.h"
+#include "event_stream.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include <pthread.h>
+
+static const char *TAG = "MOCK_ACTUATOR";
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    actuator_cmd_t queue[ACTUATOR_QUEUE_LENGTH];
+    uint32_t head;              // 下一条待执行命令的下标
+    uint32_t count;             // 排队中的命令数
+    bool busy;                  // 正在执行命令
+    bool initialized;
+    uint32_t stop_generation;   // 每次取消加一
+    uint32_t move_ms;           // 每次动作的模拟耗时
+} mock_actuator_state_t;
+
+static mock_actuator_state_t mock_state = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .move_ms = 20,
+};
+
+void mock_actuator_set_move_ms(uint32_t move_ms)
+{
+    mock_state.move_ms = move_ms;
+}
+
+static void mock_actuator_task(void *arg)
+{
+    (void)arg;
+    while (true) {
+        pthread_mutex_lock(&mock_state.lock);
+        while (mock_state.count == 0) {
+            pthread_cond_wait(&mock_state.cond, &mock_state.lock);
+        }
+        actuator_cmd_t cmd = mock_state.queue[mock_state.head];
+        mock_state.head = (mock_state.head + 1) % ACTUATOR_QUEUE_LENGTH;
+        mock_state.count--;
+        mock_state.busy = true;
+        uint32_t generation = mock_state.stop_generation;
+        pthread_mutex_unlock(&mock_state.lock);
+    
+        event_stream_publish(EVENT_MOTION_STARTED, cmd.angle, 0);
+        esp_err_t ret = ESP_OK;
+        int repeat = cmd.repeat > 0 ? cmd.repeat : 1;
+        for (int i = 0; i < repeat; i++) {
+            if (i > 0 && generation != mock_state.stop_generation) {
+                ret = ESP_ERR_INVALID_STATE;
+                break;
+            }
+            vTaskDelay(pdMS_TO_TICKS(mock_state.move_ms));
+        }
+    
+        pthread_mutex_lock(&mock_state.lock);
+        mock_state.busy = false;
+        pthread_mutex_unlock(&mock_state.lock);
+        event_stream_publish(EVENT_MOTION_FINISHED, cmd.angle, ret);
+    
+        if (cmd.on_done) {
+            cmd.on_done(&cmd, ret);
+        }
+    }
+}
+
+esp_err_t actuator_init(const sg90_config_t *servo)
+{
+    if (servo == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (mock_state.initialized) {
+        return ESP_OK;
+    }
+    if (xTaskCreatePinnedToCore(mock_actuator_task, "actuator", 0, NULL, 0, NULL, tskNO_AFFINITY) != pdPASS) {
+        return ESP_FAIL;
+    }
+    mock_state.initialized = true;
+    ESP_LOGI(TAG, "模拟执行器启动，队列长度 %d，每次动作 %ums", ACTUATOR_QUEUE_LENGTH, (unsigned)mock_state.move_ms);
+    return ESP_OK;
+}
+
+actuator_submit_result_t actuator_submit(const actuator_cmd_t *cmd)
+{
+    if (!mock_state.initialized || cmd == NULL) {
+        return ACTUATOR_SUBMIT_REJECTED_FULL;
+    }
+    
+    pthread_mutex_lock(&mock_state.lock);
+    if (mock_state.count >= ACTUATOR_QUEUE_LENGTH) {
+        pthread_mutex_unlock(&mock_state.lock);
+        return ACTUATOR_SUBMIT_REJECTED_FULL;
+    }
+    bool idle = mock_state.count == 0 && !mock_state.busy;
+    mock_state.queue[(mock_state.head + mock_state.count) % ACTUATOR_QUEUE_LENGTH] = *cmd;
+    mock_state.count++;
+    pthread_cond_signal(&mock_state.cond);
+    pthread_mutex_unlock(&mock_state.lock);
+    return idle ? ACTUATOR_SUBMIT_ACCEPTED : ACTUATOR_SUBMIT_QUEUED;
+}
+
+uint32_t actuator_cancel_pending(void)
+{
+    actuator_cmd_t cancelled[ACTUATOR_QUEUE_LENGTH];
+    
+    pthread_mutex_lock(&mock_state.lock);
+    mock_state.stop_generation++;
+    uint32_t count = mock_state.count;
+    for (uint32_t i = 0; i < count; i++) {
+        cancelled[i] = mock_state.queue[(mock_state.head + i) % ACTUATOR_QUEUE_LENGTH];
+    }
+    mock_state.count = 0;
+    pthread_mutex_unlock(&mock_state.lock);
+    
+    // 与 actuator.c 一样，每条被取消的命令都在调用方的任务中收到完成回调
+    for (uint32_t i = 0; i < count; i++) {
+        if (cancelled[i].on_done) {
+            cancelled[i].on_done(&cancelled[i], ESP_ERR_INVALID_STATE);
+        }
+    }
+    return count;
+}
+
+uint32_t actuator_pending_count(void)
+{
+    pthread_mutex_lock(&mock_state.lock);
+    uint32_t pending = mock_state.count + (mock_state.busy ? 1 : 0);
+    pthread_mutex_unlock(&mock_state.lock);
+    return pending;
+}
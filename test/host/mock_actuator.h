@@ -0,0 +1,16 @@
+/**
+ * @file mock_actuator.h
+ * @brief 主机构建的模拟执行器：实现 actuator.h，舵机动作用固定耗时的等待代替
+ */
+
+#ifndef MOCK_ACTUATOR_H
+#define MOCK_ACTUATOR_H
+
+#include <stdint.h>
+
+/**
+ * @brief 设置每次动作的模拟耗时（默认20ms），在 actuator_init() 之前调用
+ */
+void mock_actuator_set_move_ms(uint32_t move_ms);
+
+#endif // MOCK_ACTUATOR_H
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""
+对命令端口的主机构建（tcp_server_host）运行 tools/load_gen.py（ctest 调用）
+
+用法:
+    python3 run_load_gen.py <tcp_server_host> <load_gen.py>
+
+1. 启动 tcp_server_host（默认的限流和并发选项，模拟动作5ms），等待 "READY"
+2. 只发STATUS，按首条回复计时；再混合动作命令，按完成回复计时。两次都要求没有连接错误、
+   没有超时和未回复的请求，并打印 load_gen 的JSON结果
+3. 状态端口：STATUS 正常回复，动作命令回复 unsupported
+4. 发送SIGTERM：状态端口任务必须立即退出（不再等待select超时），命令端口正常停止
+5. 开启Nagle（--no-nodelay）再启动一次：一个数据包中的10条命令的回复必须合并为一次发送，
+   否则后面的回复要等对端的延迟ACK（约40ms）
+"""
+
+import json
+import signal
+import socket
+import subprocess
+import sys
+
+LISTENER_STOP_MAX_MS = 100      # 停止状态端口到端口任务退出的上限
+BATCH_P99_MAX_MS = 20           # 开启Nagle时10条命令一批的p99延迟上限（低于延迟ACK的约40ms）
+
+
+def free_port():
+    with socket.socket() as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+
+def run_load_gen(load_gen, port, *extra):
+    cmd = [sys.executable, load_gen, "127.0.0.1", "--port", str(port),
+           "--duration", "1", "--warmup", "0.2", "--drain", "2", *extra]
+    out = subprocess.run(cmd, check=True, capture_output=True, text=True, timeout=30).stdout
+    result = json.loads(out)
+    print(json.dumps(result, ensure_ascii=False))
+    failures = []
+    if result["errors"]:
+        failures.append(f"连接错误: {result['errors']}")
+    if result["timeouts"] or result["unanswered"]:
+        failures.append(f"超时 {result['timeouts']}，未回复 {result['unanswered']}")
+    if result["completed"] == 0 or "STATUS" not in result["results"]:
+        failures.append(f"没有完成的STATUS请求: {result['results']}")
+    return failures
+
+
+def check_batch(server_bin, load_gen):
+    """开启Nagle时，10条命令一个数据包的回复应当一次发出"""
+    port = free_port()
+    server = subprocess.Popen([server_bin, "--port", str(port), "--no-nodelay", "--no-limits"],
+                              stdout=subprocess.PIPE, text=True)
+    try:
+        if server.stdout.readline().split()[:1] != ["READY"]:
+            return ["开启Nagle的服务器没有就绪"]
+        cmd = [sys.executable, load_gen, "127.0.0.1", "--port", str(port), "--concurrency", "1",
+               "--depth", "10", "--batch", "--mix", "STOP:1", "--duration", "1", "--warmup", "0.2"]
+        result = json.loads(subprocess.run(cmd, check=True, capture_output=True, text=True, timeout=30).stdout)
+    finally:
+        server.send_signal(signal.SIGTERM)
+        server.communicate(timeout=10)
+    print(json.dumps({k: result[k] for k in ("batches", "batch_latency_ms", "results")}, ensure_ascii=False))
+    p99 = result["batch_latency_ms"]["p99"]
+    if result["batches"] == 0 or p99 > BATCH_P99_MAX_MS:
+        return [f"开启Nagle时10条命令一批的p99延迟 {p99}ms（{result['batches']} 批）"]
+    return []
+
+
+def ask(port, request):
+    with socket.create_connection(("127.0.0.1", port), timeout=2) as s:
+        s.sendall(request.encode())
+        buf = b""
+        while b"\n" not in buf:
+            chunk = s.recv(256)
+            if not chunk:
+                break
+            buf += chunk
+    return buf.decode(errors="replace").split("\n", 1)[0]
+
+
+def main():
+    server_bin, load_gen = sys.argv[1], sys.argv[2]
+    port, status_port = free_port(), free_port()
+    server = subprocess.Popen([server_bin, "--port", str(port), "--status-port", str(status_port),
+                               "--move-ms", "5"], stdout=subprocess.PIPE, text=True)
+    failures = []
+    try:
+        ready = server.stdout.readline().split()
+        if ready[:1] != ["READY"]:
+            print(f"服务器没有就绪: {ready}")
+            return 1
+
+        failures += run_load_gen(load_gen, port, "--mix", "STATUS:1", "--until", "ack")
+        failures += run_load_gen(load_gen, port, "--mix", "STATUS:8,5:1,FEED 0 1:1", "--until", "done")
+
+        reply = ask(status_port, "#s1 STATUS\n")
+        if not reply.startswith("#s1 STATUS "):
+            failures.append(f"状态端口STATUS回复: {reply!r}")
+        reply = ask(status_port, "#s2 5\n")
+        if reply != "#s2 ERROR unsupported":
+            failures.append(f"状态端口动作命令回复: {reply!r}")
+    finally:
+        server.send_signal(signal.SIGTERM)
+        try:
+            out, _ = server.communicate(timeout=10)
+        except subprocess.TimeoutExpired:
+            server.kill()
+            out, _ = server.communicate()
+            failures.append("服务器没有在10秒内退出")
+
+    print(out.strip())
+    for line in out.splitlines():
+        if line.startswith("listener_stop "):
+            waited = int(line.split()[1].rstrip("ms"))
+            if waited > LISTENER_STOP_MAX_MS:
+                failures.append(f"状态端口任务 {waited}ms 后才退出")
+    if server.returncode != 0:
+        failures.append(f"服务器退出码 {server.returncode}")
+
+    failures += check_batch(server_bin, load_gen)
+
+    for failure in failures:
+        print(f"FAIL: {failure}")
+    print("PASS" if not failures else "FAIL")
+    return 0 if not failures else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,13 @@
+/**
+ * @file gpio.h
+ * @brief 主机构建：sg90_servo.h 需要的GPIO类型
+ */
+
+#ifndef DRIVER_GPIO_H
+#define DRIVER_GPIO_H
+
+typedef int gpio_num_t;
+
+#define GPIO_NUM_NC     (-1)
+
+#endif // DRIVER_GPIO_H
@@ -0,0 +1,14 @@
+/**
+ * @file mcpwm_prelude.h
+ * @brief 主机构建：sg90_servo.h 需要的MCPWM句柄类型（主机构建不包含舵机驱动）
+ */
+
+#ifndef DRIVER_MCPWM_PRELUDE_H
+#define DRIVER_MCPWM_PRELUDE_H
+
+typedef struct mcpwm_timer_t *mcpwm_timer_handle_t;
+typedef struct mcpwm_oper_t *mcpwm_oper_handle_t;
+typedef struct mcpwm_cmpr_t *mcpwm_cmpr_handle_t;
+typedef struct mcpwm_gen_t *mcpwm_gen_handle_t;
+
+#endif // DRIVER_MCPWM_PRELUDE_H
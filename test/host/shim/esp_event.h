@@ -0,0 +1,14 @@
+/**
+ * @file esp_event.h
+ * @brief 主机构建：wifi_config.h 需要的事件类型
+ */
+
+#ifndef ESP_EVENT_H
+#define ESP_EVENT_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef const char *esp_event_base_t;
+
+#endif // ESP_EVENT_H
@@ -0,0 +1,17 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief 主机构建：堆统计（固定返回0）
+ */
+
+#ifndef ESP_HEAP_CAPS_H
+#define ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+
+#endif // ESP_HEAP_CAPS_H
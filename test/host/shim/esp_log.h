@@ -0,0 +1,30 @@
+/**
+ * @file esp_log.h
+ * @brief 主机构建：日志输出到stderr，级别由 host_log_level 控制（默认只输出警告和错误）
+ */
+
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <stdio.h>
+
+#define ESP_LOG_NONE    0
+#define ESP_LOG_ERROR   1
+#define ESP_LOG_WARN    2
+#define ESP_LOG_INFO    3
+#define ESP_LOG_DEBUG   4
+
+extern int host_log_level;
+
+#define HOST_LOG(level, letter, tag, fmt, ...) do {                     \
+        if (host_log_level >= (level)) {                                \
+            fprintf(stderr, letter " (%s) " fmt "\n", tag, ##__VA_ARGS__); \
+        }                                                               \
+    } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) HOST_LOG(ESP_LOG_ERROR, "E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) HOST_LOG(ESP_LOG_WARN, "W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) HOST_LOG(ESP_LOG_INFO, "I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) HOST_LOG(ESP_LOG_DEBUG, "D", tag, fmt, ##__VA_ARGS__)
+
+#endif // ESP_LOG_H
@@ -0,0 +1,25 @@
+/**
+ * @file esp_vfs_eventfd.h
+ * @brief 主机构建：直接使用Linux的eventfd
+ */
+
+#ifndef ESP_VFS_EVENTFD_H
+#define ESP_VFS_EVENTFD_H
+
+#include <stddef.h>
+#include <sys/eventfd.h>
+#include "esp_err.h"
+
+typedef struct {
+    size_t max_fds;
+} esp_vfs_eventfd_config_t;
+
+#define ESP_VFS_EVENTD_CONFIG_DEFAULT() { .max_fds = 5 }
+
+static inline esp_err_t esp_vfs_eventfd_register(const esp_vfs_eventfd_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+#endif // ESP_VFS_EVENTFD_H
@@ -0,0 +1,43 @@
+/**
+ * @file FreeRTOS.h
+ * @brief 主机构建：FreeRTOS基本类型，临界区映射到递归互斥锁（实现见 host_freertos.c）
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE          1
+#define pdFALSE         0
+#define pdPASS          pdTRUE
+#define pdFAIL          pdFALSE
+#define portMAX_DELAY   ((TickType_t)0xFFFFFFFFu)
+
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * CONFIG_FREERTOS_HZ) / 1000))
+#define pdTICKS_TO_MS(ticks)    ((uint32_t)(((uint64_t)(ticks) * 1000) / CONFIG_FREERTOS_HZ))
+#define portTICK_PERIOD_MS      (1000 / CONFIG_FREERTOS_HZ)
+
+// 临界区可以嵌套，与ESP32的portMUX一致
+typedef pthread_mutex_t portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED    PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP
+#define portENTER_CRITICAL(mux)         pthread_mutex_lock(mux)
+#define portEXIT_CRITICAL(mux)          pthread_mutex_unlock(mux)
+#define portENTER_CRITICAL_ISR(mux)     pthread_mutex_lock(mux)
+#define portEXIT_CRITICAL_ISR(mux)      pthread_mutex_unlock(mux)
+#define portENTER_CRITICAL_SAFE(mux)    pthread_mutex_lock(mux)
+#define portEXIT_CRITICAL_SAFE(mux)     pthread_mutex_unlock(mux)
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define tskNO_AFFINITY          0x7FFFFFFF
+
+#endif // FREERTOS_H
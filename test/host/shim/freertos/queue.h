@@ -0,0 +1,11 @@
+/**
+ * @file queue.h
+ * @brief 主机构建：占位，主机构建中没有使用队列的模块
+ */
+
+#ifndef FREERTOS_QUEUE_H
+#define FREERTOS_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+#endif // FREERTOS_QUEUE_H
@@ -0,0 +1,29 @@
+/**
+ * @file task.h
+ * @brief 主机构建：任务映射到分离的pthread，tick为进程启动以来的毫秒数
+ */
+
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+/**
+ * @brief 创建任务（堆栈大小、优先级和核心在主机上忽略）
+ */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stack_size, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id);
+
+/**
+ * @brief 删除任务，只支持任务删除自己（task 为NULL）
+ */
+void vTaskDelete(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+#endif // FREERTOS_TASK_H
@@ -0,0 +1,95 @@
+/**
+ * @file host_esp.c
+ * @brief 主机构建：ESP-IDF 杂项函数，以及主机上不存在的模块（WiFi、TLS）的替身
+ */
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "wifi_config.h"
+#include "tls_session.h"
+#include <errno.h>
+
+int host_log_level = ESP_LOG_WARN;
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                return "ESP_OK";
+        case ESP_FAIL:              return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_CRC:   return "ESP_ERR_INVALID_CRC";
+        default:                    return "UNKNOWN ERROR";
+    }
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+    return 0;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    (void)caps;
+    return 0;
+}
+
+bool wifi_is_connected(void)
+{
+    return true;
+}
+
+// 主机构建不启用TLS端口，tcp_server.c 只在 tcp_server_enable_tls() 之后才会调用下面的函数
+
+esp_err_t tls_session_init(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+struct esp_tls *tls_session_new(int fd)
+{
+    (void)fd;
+    return NULL;
+}
+
+int tls_session_handshake(struct esp_tls *tls)
+{
+    (void)tls;
+    return -1;
+}
+
+ssize_t tls_session_read(struct esp_tls *tls, void *buf, size_t len)
+{
+    (void)tls;
+    (void)buf;
+    (void)len;
+    errno = EIO;
+    return -1;
+}
+
+ssize_t tls_session_write(struct esp_tls *tls, const void *data, size_t len)
+{
+    (void)tls;
+    (void)data;
+    (void)len;
+    errno = EIO;
+    return -1;
+}
+
+size_t tls_session_pending(struct esp_tls *tls)
+{
+    (void)tls;
+    return 0;
+}
+
+void tls_session_free(struct esp_tls *tls)
+{
+    (void)tls;
+}
@@ -0,0 +1,290 @@
+/**
+ * @file host_freertos.c
+ * @brief 主机构建：FreeRTOS任务、信号量和软件定时器的pthread实现
+ * 
+ * 只实现被测模块用到的部分，语义与FreeRTOS一致：信号量的超时以tick计，
+ * portMAX_DELAY表示一直等待；任务只能删除自己
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/timers.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t entry;
+    void *arg;
+};
+
+struct host_semaphore {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    unsigned count;             // 可用数量，0或1
+};
+
+struct host_timer {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    TimerCallbackFunction_t callback;
+    TickType_t period;
+    bool auto_reload;
+    bool active;
+    uint64_t deadline_ms;       // 到期时间（单调时钟毫秒）
+};
+
+static __thread struct host_task *current_task;
+
+static uint64_t monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint64_t start_ms;
+
+static void __attribute__((constructor)) host_freertos_init(void)
+{
+    start_ms = monotonic_ms();
+}
+
+/**
+ * @brief 单调时钟上 now + ms 对应的绝对时间（条件变量使用单调时钟）
+ */
+static struct timespec deadline_after_ms(uint64_t ms)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+static void cond_init_monotonic(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void *task_trampoline(void *arg)
+{
+    current_task = arg;
+    current_task->entry(current_task->arg);
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stack_size, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id)
+{
+    (void)name;
+    (void)stack_size;
+    (void)priority;
+    (void)core_id;
+    
+    struct host_task *t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        return pdFAIL;
+    }
+    t->entry = task;
+    t->arg = arg;
+    if (handle != NULL) {
+        *handle = t;
+    }
+    if (pthread_create(&t->thread, NULL, task_trampoline, t) != 0) {
+        free(t);
+        return pdFAIL;
+    }
+    pthread_detach(t->thread);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task != NULL && task != current_task) {
+        abort();    // 主机构建只支持任务删除自己
+    }
+    free(current_task);
+    current_task = NULL;
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    uint64_t ms = pdTICKS_TO_MS(ticks);
+    struct timespec ts = {
+        .tv_sec = ms / 1000,
+        .tv_nsec = (long)(ms % 1000) * 1000000,
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)pdMS_TO_TICKS(monotonic_ms() - start_ms);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return current_task;
+}
+
+static SemaphoreHandle_t semaphore_create(unsigned count)
+{
+    struct host_semaphore *sem = calloc(1, sizeof(*sem));
+    if (sem == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&sem->mutex, NULL);
+    cond_init_monotonic(&sem->cond);
+    sem->count = count;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return semaphore_create(1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return semaphore_create(0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    struct timespec deadline = deadline_after_ms(pdTICKS_TO_MS(ticks));
+    BaseType_t taken = pdFALSE;
+    
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->count == 0 && ticks != 0) {
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(&sem->cond, &sem->mutex);
+        } else if (pthread_cond_timedwait(&sem->cond, &sem->mutex, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    if (sem->count > 0) {
+        sem->count--;
+        taken = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->mutex);
+    return taken;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    BaseType_t given = pdFALSE;
+    pthread_mutex_lock(&sem->mutex);
+    if (sem->count == 0) {
+        sem->count = 1;
+        given = pdTRUE;
+        pthread_cond_signal(&sem->cond);
+    }
+    pthread_mutex_unlock(&sem->mutex);
+    return given;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->mutex);
+    free(sem);
+}
+
+/**
+ * @brief 定时器线程：等到到期时间后在本线程中调用回调（相当于FreeRTOS的定时器任务）
+ */
+static void *timer_thread(void *arg)
+{
+    struct host_timer *timer = arg;
+    pthread_mutex_lock(&timer->mutex);
+    while (true) {
+        if (!timer->active) {
+            pthread_cond_wait(&timer->cond, &timer->mutex);
+            continue;
+        }
+        uint64_t now = monotonic_ms();
+        if (now < timer->deadline_ms) {
+            struct timespec deadline = deadline_after_ms(timer->deadline_ms - now);
+            pthread_cond_timedwait(&timer->cond, &timer->mutex, &deadline);
+            continue;
+        }
+        if (timer->auto_reload) {
+            timer->deadline_ms += pdTICKS_TO_MS(timer->period);
+        } else {
+            timer->active = false;
+        }
+        pthread_mutex_unlock(&timer->mutex);
+        timer->callback(timer);
+        pthread_mutex_lock(&timer->mutex);
+    }
+    return NULL;
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, BaseType_t auto_reload, void *id,
+                           TimerCallbackFunction_t callback)
+{
+    (void)name;
+    (void)id;
+    
+    struct host_timer *timer = calloc(1, sizeof(*timer));
+    if (timer == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&timer->mutex, NULL);
+    cond_init_monotonic(&timer->cond);
+    timer->callback = callback;
+    timer->period = period;
+    timer->auto_reload = auto_reload != pdFALSE;
+    
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, timer_thread, timer) != 0) {
+        free(timer);
+        return NULL;
+    }
+    pthread_detach(thread);
+    return timer;
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    pthread_mutex_lock(&timer->mutex);
+    timer->period = period;
+    timer->deadline_ms = monotonic_ms() + pdTICKS_TO_MS(period);
+    timer->active = true;
+    pthread_cond_signal(&timer->cond);
+    pthread_mutex_unlock(&timer->mutex);
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    pthread_mutex_lock(&timer->mutex);
+    timer->active = false;
+    pthread_cond_signal(&timer->cond);
+    pthread_mutex_unlock(&timer->mutex);
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer)
+{
+    pthread_mutex_lock(&timer->mutex);
+    BaseType_t active = timer->active ? pdTRUE : pdFALSE;
+    pthread_mutex_unlock(&timer->mutex);
+    return active;
+}
@@ -0,0 +1,11 @@
+/**
+ * @file netdb.h
+ * @brief 主机构建：lwIP netdb 映射到POSIX
+ */
+
+#ifndef LWIP_NETDB_H
+#define LWIP_NETDB_H
+
+#include <netdb.h>
+
+#endif // LWIP_NETDB_H
@@ -0,0 +1,24 @@
+/**
+ * @file sockets.h
+ * @brief 主机构建：lwIP socket API 映射到POSIX socket
+ */
+
+#ifndef LWIP_SOCKETS_H
+#define LWIP_SOCKETS_H
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static inline char *inet_ntoa_r(struct in_addr addr, char *buf, int buflen)
+{
+    return (char *)inet_ntop(AF_INET, &addr, buf, (socklen_t)buflen);
+}
+
+#endif // LWIP_SOCKETS_H
@@ -0,0 +1,14 @@
+/**
+ * @file sdkconfig.h
+ * @brief 主机构建使用的配置，取值与 sdkconfig.defaults 一致
+ */
+
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+#define CONFIG_LWIP_MAX_SOCKETS         32
+#define CONFIG_LWIP_MAX_ACTIVE_TCP      32
+#define CONFIG_FREERTOS_HZ              1000
+#define CONFIG_FREERTOS_NUMBER_OF_CORES 2
+
+#endif // SDKCONFIG_H
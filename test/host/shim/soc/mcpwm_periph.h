@@ -0,0 +1,9 @@
+/**
+ * @file mcpwm_periph.h
+ * @brief 主机构建：占位
+ */
+
+#ifndef SOC_MCPWM_PERIPH_H
+#define SOC_MCPWM_PERIPH_H
+
+#endif // SOC_MCPWM_PERIPH_H
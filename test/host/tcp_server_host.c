@@ -0,0 +1,160 @@
+/**
+ * @file tcp_server_host.c
+ * @brief 命令端口的主机构建
+ * 
+ * 把固件中真实的 tcp_server.c、tcp_listener.c、stream_parser.c、line_protocol.c、binary_protocol.c、
+ * command_registry.c 和 command_handlers.c 编译为Linux程序，舵机换成 mock_actuator.c，
+ * 用于在没有硬件时运行 tools/load_gen.py 等主机端工具:
+ * 
+ *   tcp_server_host [--port 8080] [--status-port 8081] [--move-ms 20] [--no-limits]
+ *                   [--flush batch|immediate] [--no-nodelay] [-v]
+ * 
+ * --flush 和 --no-nodelay 对应 tcp_server_options_t 的 flush_policy 和 nodelay，用于比较响应合并前后的延迟
+ * 
+ * 就绪后在标准输出打印一行 "READY <命令端口> <状态端口>"。收到 SIGINT/SIGTERM 时停止状态端口，
+ * 确认端口任务立即退出（同一端口可以马上重新启动），再停止命令端口；都成功时退出码为0
+ */
+
+#include "tcp_server.h"
+#include "tcp_listener.h"
+#include "command_registry.h"
+#include "command_handlers.h"
+#include "request_cache.h"
+#include "actuator.h"
+#include "mock_actuator.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_LISTENER_RESTART_MS    500     // 停止状态端口后等待端口任务退出的最长时间
+
+static const char *TAG = "HOST";
+
+static sg90_config_t servo_config;          // 模拟执行器不使用舵机配置，只作为“已初始化”的标记
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "用法: %s [--port N] [--status-port N] [--move-ms N] [--no-limits] "
+            "[--flush batch|immediate] [--no-nodelay] [-v]\n", prog);
+    exit(2);
+}
+
+/**
+ * @brief 停止状态端口，等待端口任务退出（用同一端口重新启动来确认），返回等待的毫秒数，-1表示超时
+ */
+static int listener_stop_and_wait(const tcp_listener_config_t *config)
+{
+    TickType_t start = xTaskGetTickCount();
+    tcp_listener_stop(config->port);
+    while (tcp_listener_start(config, command_registry_dispatch) != ESP_OK) {
+        if (xTaskGetTickCount() - start > pdMS_TO_TICKS(HOST_LISTENER_RESTART_MS)) {
+            return -1;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    int waited = (int)pdTICKS_TO_MS(xTaskGetTickCount() - start);
+    tcp_listener_stop(config->port);
+    return waited;
+}
+
+int main(int argc, char **argv)
+{
+    uint16_t port = 8080;
+    uint16_t status_port = 0;
+    uint32_t move_ms = 20;
+    bool no_limits = false;
+    bool nodelay = true;
+    tcp_server_flush_policy_t flush_policy = TCP_SERVER_FLUSH_PER_BATCH;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = (uint16_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--status-port") == 0 && i + 1 < argc) {
+            status_port = (uint16_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--move-ms") == 0 && i + 1 < argc) {
+            move_ms = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-limits") == 0) {
+            no_limits = true;
+        } else if (strcmp(argv[i], "--flush") == 0 && i + 1 < argc) {
+            const char *policy = argv[++i];
+            if (strcmp(policy, "batch") == 0) {
+                flush_policy = TCP_SERVER_FLUSH_PER_BATCH;
+            } else if (strcmp(policy, "immediate") == 0) {
+                flush_policy = TCP_SERVER_FLUSH_IMMEDIATE;
+            } else {
+                usage(argv[0]);
+            }
+        } else if (strcmp(argv[i], "--no-nodelay") == 0) {
+            nodelay = false;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            host_log_level = ESP_LOG_INFO;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    
+    // 信号由主线程同步等待，其他线程（服务器任务）继承屏蔽字，不会被信号打断
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    
+    // 与 app_main 相同的初始化顺序
+    request_cache_init();
+    ESP_ERROR_CHECK(command_handlers_init());
+    ESP_ERROR_CHECK(command_registry_init());
+    mock_actuator_set_move_ms(move_ms);
+    ESP_ERROR_CHECK(actuator_init(&servo_config));
+    command_handlers_set_servo(&servo_config);
+    
+    ESP_ERROR_CHECK(tcp_server_init(port));
+    tcp_server_options_t options = TCP_SERVER_DEFAULT_OPTIONS();
+    options.nodelay = nodelay;
+    options.flush_policy = flush_policy;
+    if (no_limits) {
+        // 只测量协议和命令路径本身：不限流、不限制未完成命令数
+        options.rate_per_ip = 0;
+        options.rate_global = 0;
+        options.max_inflight_per_conn = 0;
+        options.max_inflight_total = 0;
+    }
+    ESP_ERROR_CHECK(tcp_server_set_options(&options));
+    tcp_server_register_command_callback(command_registry_dispatch);
+    ESP_ERROR_CHECK(tcp_server_start());
+    
+    tcp_listener_config_t status_config = TCP_LISTENER_STATUS_CONFIG(status_port);
+    status_config.command_mask = command_registry_mask(status_config.perm);
+    if (status_port != 0) {
+        ESP_ERROR_CHECK(tcp_listener_start(&status_config, command_registry_dispatch));
+    }
+    
+    printf("READY %u %u\n", port, status_port);
+    fflush(stdout);
+    
+    int sig;
+    sigwait(&signals, &sig);
+    
+    int rc = 0;
+    if (status_port != 0) {
+        int waited = listener_stop_and_wait(&status_config);
+        if (waited < 0) {
+            ESP_LOGE(TAG, "状态端口任务在 %dms 内没有退出", HOST_LISTENER_RESTART_MS);
+            rc = 1;
+        } else {
+            printf("listener_stop %dms\n", waited);
+        }
+    }
+    esp_err_t err = tcp_server_stop();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "停止命令端口失败: %s", esp_err_to_name(err));
+        rc = 1;
+    }
+    printf("STOPPED %d\n", rc);
+    return rc;
+}
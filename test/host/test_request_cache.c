@@ -0,0 +1,269 @@
+/**
+ * @file test_request_cache.c
+ * @brief 请求ID去重缓存主机端测试
+ * 
+ * 只通过公开接口和统计检查淘汰与过期行为：表满时只淘汰已完成的记录（按LRU顺序），
+ * forget 后的表项移到LRU尾部被优先复用，超过有效期的记录按新请求处理，
+ * 不同作用域的同名ID互不影响，表中全是执行中的请求时不再记录。
+ * tick由本文件提供（xTaskGetTickCount），测试可以直接跳过有效期
+ */
+
+#include "request_cache.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+
+#define TEST_TTL_TICKS  pdMS_TO_TICKS(REQUEST_CACHE_TTL_MS)
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            printf("[%s] 第%d行检查失败: %s\n", __func__, __LINE__, #cond);       \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+static TickType_t test_now;
+
+TickType_t xTaskGetTickCount(void)
+{
+    return test_now;
+}
+
+static const char *test_id(int n)
+{
+    static char ids[2 * REQUEST_CACHE_SIZE + 8][8];
+    snprintf(ids[n], sizeof(ids[n]), "r%d", n);
+    return ids[n];
+}
+
+static bool begin(uint32_t scope, const char *id, request_result_t *cached)
+{
+    return request_cache_begin(scope, id, 90, cached);
+}
+
+static request_cache_stats_t stats(void)
+{
+    request_cache_stats_t s;
+    request_cache_get_stats(&s);
+    return s;
+}
+
+/**
+ * @brief 把表填满 REQUEST_CACHE_SIZE 条新请求 r0..r31（r0最久未使用）
+ * @param complete 是否全部标记为已完成
+ */
+static void fill(bool complete)
+{
+    request_result_t cached;
+    for (int i = 0; i < REQUEST_CACHE_SIZE; i++) {
+        begin(REQUEST_CACHE_SCOPE_GLOBAL, test_id(i), &cached);
+        if (complete) {
+            request_cache_complete(REQUEST_CACHE_SCOPE_GLOBAL, test_id(i), ESP_OK);
+        }
+    }
+}
+
+/**
+ * @brief 表满时只淘汰已完成的记录，执行中的记录保留；全部执行中时新请求不记录
+ */
+static int test_evict_only_completed(void)
+{
+    int failures = 0;
+    request_result_t cached;
+    
+    test_now = 0;
+    request_cache_init();
+    fill(false);
+    for (int i = 1; i < REQUEST_CACHE_SIZE; i += 2) {
+        request_cache_complete(REQUEST_CACHE_SCOPE_GLOBAL, test_id(i), ESP_OK);
+    }
+    CHECK(stats().inserts == REQUEST_CACHE_SIZE);
+    
+    // 一半已完成：新请求依次淘汰它们
+    for (int i = 0; i < REQUEST_CACHE_SIZE / 2; i++) {
+        CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, test_id(REQUEST_CACHE_SIZE + i), &cached));
+    }
+    CHECK(stats().evictions == REQUEST_CACHE_SIZE / 2);
+    CHECK(stats().full == 0);
+    
+    // 现在全部在执行中：再来的新请求无法记录，重发时也不会命中
+    CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, "extra", &cached));
+    CHECK(stats().full == 1);
+    CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, "extra", &cached));
+    CHECK(stats().full == 2);
+    CHECK(stats().evictions == REQUEST_CACHE_SIZE / 2);
+    
+    // 执行中的记录全部还在
+    for (int i = 0; i < REQUEST_CACHE_SIZE; i += 2) {
+        CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, test_id(i), &cached));
+        CHECK(cached.state == REQUEST_STATE_PENDING && cached.angle == 90);
+    }
+    for (int i = 0; i < REQUEST_CACHE_SIZE / 2; i++) {
+        CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, test_id(REQUEST_CACHE_SIZE + i), &cached));
+    }
+    
+    // 完成一条后表中有了可淘汰的记录
+    request_cache_complete(REQUEST_CACHE_SCOPE_GLOBAL, test_id(0), ESP_OK);
+    CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, "extra", &cached));
+    CHECK(stats().full == 2);
+    CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, "extra", &cached));
+    
+    printf("[evict] 失败 %d\n", failures);
+    return failures;
+}
+
+/**
+ * @brief 已完成的记录按LRU顺序淘汰，命中会把记录移到最近使用
+ */
+static int test_evict_lru_order(void)
+{
+    int failures = 0;
+    request_result_t cached;
+    
+    test_now = 0;
+    request_cache_init();
+    fill(true);
+    
+    // r0 命中后变为最近使用，下一条新请求淘汰 r1
+    CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, test_id(0), &cached));
+    CHECK(cached.state == REQUEST_STATE_DONE);
+    CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, "new", &cached));
+    CHECK(stats().evictions == 1);
+    CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, test_id(0), &cached));
+    CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, test_id(2), &cached));
+    CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, test_id(1), &cached));
+    
+    printf("[lru] 失败 %d\n", failures);
+    return failures;
+}
+
+/**
+ * @brief forget 删除记录并把表项移到LRU尾部，下一条新请求直接复用它而不淘汰其他记录
+ */
+static int test_forget_relinks_tail(void)
+{
+    int failures = 0;
+    request_result_t cached;
+    
+    test_now = 0;
+    request_cache_init();
+    fill(true);
+    
+    // r31 是最近使用的表项（LRU头部），forget 后应移到尾部
+    int last = REQUEST_CACHE_SIZE - 1;
+    request_cache_forget(REQUEST_CACHE_SCOPE_GLOBAL, test_id(last));
+    CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, "new", &cached));
+    CHECK(stats().evictions == 0);
+    
+    // 最久未使用的 r0 没有被淘汰
+    CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, test_id(0), &cached));
+    CHECK(cached.state == REQUEST_STATE_DONE);
+    
+    // 被删除的ID重发时按新请求执行（此时表满，淘汰最久未使用的 r1）
+    CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, test_id(last), &cached));
+    CHECK(stats().evictions == 1);
+    CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, test_id(last), &cached));
+    CHECK(cached.state == REQUEST_STATE_PENDING);
+    
+    // forget 不存在的ID不改变表
+    request_cache_forget(REQUEST_CACHE_SCOPE_GLOBAL, "missing");
+    CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, "new", &cached));
+    
+    printf("[forget] 失败 %d\n", failures);
+    return failures;
+}
+
+/**
+ * @brief 超过有效期的记录按新请求处理，分配时直接复用（包括执行中的记录），不计入淘汰数
+ */
+static int test_expiry(void)
+{
+    int failures = 0;
+    request_result_t cached;
+    
+    test_now = 1000;
+    request_cache_init();
+    CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, "a", &cached));
+    request_cache_complete(REQUEST_CACHE_SCOPE_GLOBAL, "a", ESP_OK);
+    
+    // 有效期边界上仍然命中
+    test_now = 1000 + TEST_TTL_TICKS;
+    CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, "a", &cached));
+    CHECK(cached.state == REQUEST_STATE_DONE);
+    
+    // 过期后按新请求执行，重新记录为执行中
+    test_now = 1000 + TEST_TTL_TICKS + 1;
+    CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, "a", &cached));
+    CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, "a", &cached));
+    CHECK(cached.state == REQUEST_STATE_PENDING);
+    
+    // 全部执行中的表在过期后可以复用，不算淘汰也不算表满
+    test_now = 0;
+    request_cache_init();
+    fill(false);
+    test_now = TEST_TTL_TICKS + 1;
+    for (int i = 0; i < REQUEST_CACHE_SIZE; i++) {
+        CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, test_id(REQUEST_CACHE_SIZE + i), &cached));
+    }
+    CHECK(stats().evictions == 0);
+    CHECK(stats().full == 0);
+    CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, test_id(0), &cached));
+    CHECK(stats().full == 1);
+    
+    // tick回绕后按差值计算有效期
+    test_now = (TickType_t)0 - 10;
+    request_cache_init();
+    CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, "wrap", &cached));
+    test_now = 10;
+    CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, "wrap", &cached));
+    
+    printf("[expiry] 失败 %d\n", failures);
+    return failures;
+}
+
+/**
+ * @brief 同一个ID在不同作用域中是不同的请求
+ */
+static int test_scopes(void)
+{
+    int failures = 0;
+    request_result_t cached;
+    const uint32_t scope_a = 0x0100A8C0;    // 192.168.0.1
+    const uint32_t scope_b = 0x0200A8C0;    // 192.168.0.2
+    
+    test_now = 0;
+    request_cache_init();
+    CHECK(!begin(scope_a, "7", &cached));
+    CHECK(!begin(scope_b, "7", &cached));
+    CHECK(!begin(REQUEST_CACHE_SCOPE_GLOBAL, "7", &cached));
+    CHECK(stats().inserts == 3);
+    
+    request_cache_complete(scope_a, "7", ESP_OK);
+    request_cache_complete(scope_b, "7", ESP_FAIL);
+    
+    CHECK(begin(scope_a, "7", &cached));
+    CHECK(cached.state == REQUEST_STATE_DONE);
+    CHECK(begin(scope_b, "7", &cached));
+    CHECK(cached.state == REQUEST_STATE_FAILED && cached.error == ESP_FAIL);
+    CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, "7", &cached));
+    CHECK(cached.state == REQUEST_STATE_PENDING);
+    
+    // 删除一个作用域的记录不影响其他作用域
+    request_cache_forget(scope_b, "7");
+    CHECK(begin(scope_a, "7", &cached));
+    CHECK(begin(REQUEST_CACHE_SCOPE_GLOBAL, "7", &cached));
+    CHECK(!begin(scope_b, "7", &cached));
+    CHECK(stats().hits == 5);
+    
+    printf("[scope] 失败 %d\n", failures);
+    return failures;
+}
+
+int main(void)
+{
+    int failures = test_evict_only_completed() + test_evict_lru_order() + test_forget_relinks_tail() +
+                   test_expiry() + test_scopes();
+    printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    return failures == 0 ? 0 : 1;
+}
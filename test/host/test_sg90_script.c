@@ -0,0 +1,247 @@
+/**
+ * @file test_sg90_script.c
+ * @brief 舵机动作脚本编译主机端测试
+ * 
+ * 检查 sg90_script_compile 的合法性判断和编译结果：交叉的循环被拒绝，目标相同的循环按嵌套处理，
+ * 嵌套层数限制，循环体中没有占用周期的步骤被拒绝，总周期数在溢出时饱和为 UINT32_MAX。
+ * 只用到 esp_log/esp_err 的替身，不需要FreeRTOS或驱动的实现
+ */
+
+#include "sg90_script.h"
+#include "esp_log.h"
+#include <stdio.h>
+
+#define STEP_COUNT(steps)   (sizeof(steps) / sizeof((steps)[0]))
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            printf("[%s] 第%d行检查失败: %s\n", __func__, __LINE__, #cond);       \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+// esp_log.h 替身的日志级别（不链接 host_esp.c），编译失败时的错误日志不输出
+int host_log_level = ESP_LOG_NONE;
+
+/**
+ * @brief 头文件示例中的投喂脚本：指令逐条对应，结尾追加END
+ */
+static int test_feed_example(void)
+{
+    int failures = 0;
+    static const sg90_script_step_t steps[] = {
+        SG90_SCRIPT_RAMP(900, 10, SG90_PROFILE_SCURVE),
+        SG90_SCRIPT_HOLD(25),
+        SG90_SCRIPT_RAMP(700, 3, SG90_PROFILE_TRAPEZOID),
+        SG90_SCRIPT_RAMP(900, 3, SG90_PROFILE_TRAPEZOID),
+        SG90_SCRIPT_LOOP(2, 3),
+        SG90_SCRIPT_RAMP(0, 10, SG90_PROFILE_SCURVE),
+    };
+    sg90_script_t script;
+    
+    CHECK(sg90_script_compile(steps, STEP_COUNT(steps), &script) == ESP_OK);
+    CHECK(script.len == STEP_COUNT(steps) + 1);
+    CHECK(script.total_periods == 10 + 25 + (3 + 3) * 3 + 10);
+    CHECK(script.insns[0].op == SG90_SCRIPT_OP_RAMP && script.insns[0].arg == 900 &&
+          script.insns[0].count == 10 && script.insns[0].aux == SG90_PROFILE_SCURVE);
+    CHECK(script.insns[4].op == SG90_SCRIPT_OP_LOOP && script.insns[4].arg == 2 &&
+          script.insns[4].count == 3 && script.insns[4].aux == 0);
+    CHECK(script.insns[6].op == SG90_SCRIPT_OP_END);
+    
+    printf("[example] 失败 %d\n", failures);
+    return failures;
+}
+
+/**
+ * @brief 两个循环的范围部分重叠（交叉）时拒绝，编译失败后 len 为0
+ */
+static int test_crossing_loops(void)
+{
+    int failures = 0;
+    static const sg90_script_step_t crossing[] = {
+        SG90_SCRIPT_HOLD(1),
+        SG90_SCRIPT_HOLD(1),
+        SG90_SCRIPT_LOOP(0, 2),     // 范围 [0, 2]
+        SG90_SCRIPT_LOOP(1, 2),     // 范围 [1, 3]，与上一个交叉
+    };
+    static const sg90_script_step_t nested[] = {
+        SG90_SCRIPT_HOLD(1),
+        SG90_SCRIPT_HOLD(1),
+        SG90_SCRIPT_LOOP(1, 2),     // 范围 [1, 2]
+        SG90_SCRIPT_LOOP(0, 3),     // 范围 [0, 3]，包含上一个
+    };
+    static const sg90_script_step_t sequential[] = {
+        SG90_SCRIPT_HOLD(1),
+        SG90_SCRIPT_LOOP(0, 2),     // 范围 [0, 1]
+        SG90_SCRIPT_HOLD(1),
+        SG90_SCRIPT_LOOP(2, 3),     // 范围 [2, 3]，不重叠
+    };
+    sg90_script_t script;
+    
+    script.len = 99;
+    CHECK(sg90_script_compile(crossing, STEP_COUNT(crossing), &script) == ESP_ERR_INVALID_ARG);
+    CHECK(script.len == 0);
+    
+    CHECK(sg90_script_compile(nested, STEP_COUNT(nested), &script) == ESP_OK);
+    CHECK(script.insns[2].aux == 1 && script.insns[3].aux == 0);
+    CHECK(script.total_periods == 1 * 3 + 1 * 2 * 3);
+    
+    CHECK(sg90_script_compile(sequential, STEP_COUNT(sequential), &script) == ESP_OK);
+    CHECK(script.insns[1].aux == 0 && script.insns[3].aux == 0);
+    CHECK(script.total_periods == 2 + 3);
+    
+    printf("[crossing] 失败 %d\n", failures);
+    return failures;
+}
+
+/**
+ * @brief 跳回同一步骤的两个循环按嵌套处理：后面的循环是外层
+ */
+static int test_equal_targets(void)
+{
+    int failures = 0;
+    static const sg90_script_step_t steps[] = {
+        SG90_SCRIPT_HOLD(5),
+        SG90_SCRIPT_LOOP(0, 2),
+        SG90_SCRIPT_LOOP(0, 3),
+        SG90_SCRIPT_SET(0),
+    };
+    sg90_script_t script;
+    
+    CHECK(sg90_script_compile(steps, STEP_COUNT(steps), &script) == ESP_OK);
+    CHECK(script.insns[1].aux == 1);
+    CHECK(script.insns[2].aux == 0);
+    CHECK(script.total_periods == 5 * 2 * 3 + 1);
+    
+    printf("[equal] 失败 %d\n", failures);
+    return failures;
+}
+
+/**
+ * @brief 最多 SG90_SCRIPT_LOOP_DEPTH 层嵌套，再多一层拒绝
+ */
+static int test_depth_limit(void)
+{
+    int failures = 0;
+    sg90_script_step_t steps[SG90_SCRIPT_LOOP_DEPTH + 2];
+    sg90_script_t script;
+    
+    const sg90_script_step_t hold = SG90_SCRIPT_HOLD(1);
+    const sg90_script_step_t loop = SG90_SCRIPT_LOOP(0, 2);
+    steps[0] = hold;
+    for (int i = 1; i <= SG90_SCRIPT_LOOP_DEPTH + 1; i++) {
+        steps[i] = loop;
+    }
+    
+    CHECK(sg90_script_compile(steps, SG90_SCRIPT_LOOP_DEPTH + 1, &script) == ESP_OK);
+    CHECK(script.insns[1].aux == SG90_SCRIPT_LOOP_DEPTH - 1);
+    CHECK(script.insns[SG90_SCRIPT_LOOP_DEPTH].aux == 0);
+    CHECK(script.total_periods == 1u << SG90_SCRIPT_LOOP_DEPTH);
+    
+    CHECK(sg90_script_compile(steps, SG90_SCRIPT_LOOP_DEPTH + 2, &script) == ESP_ERR_INVALID_ARG);
+    CHECK(script.len == 0);
+    
+    printf("[depth] 失败 %d\n", failures);
+    return failures;
+}
+
+/**
+ * @brief 循环体中没有占用周期的步骤（中断中会连续跳转）时拒绝，其他非法参数同样拒绝
+ */
+static int test_untimed_body(void)
+{
+    int failures = 0;
+    static const sg90_script_step_t loop_only[] = {
+        SG90_SCRIPT_HOLD(1),
+        SG90_SCRIPT_LOOP(0, 2),
+        SG90_SCRIPT_LOOP(1, 2),     // 循环体只有上一个LOOP
+    };
+    static const sg90_script_step_t self_target[] = {
+        SG90_SCRIPT_HOLD(1),
+        SG90_SCRIPT_LOOP(1, 2),     // 跳回自己
+    };
+    static const sg90_script_step_t first_step[] = {
+        SG90_SCRIPT_LOOP(0, 2),
+    };
+    static const sg90_script_step_t zero_count[] = {
+        SG90_SCRIPT_HOLD(1),
+        SG90_SCRIPT_LOOP(0, 0),
+    };
+    static const sg90_script_step_t zero_hold[] = {
+        SG90_SCRIPT_HOLD(0),
+    };
+    static const sg90_script_step_t end_step[] = {
+        SG90_SCRIPT_HOLD(1),
+        { .op = SG90_SCRIPT_OP_END },
+    };
+    sg90_script_t script;
+    
+    CHECK(sg90_script_compile(loop_only, STEP_COUNT(loop_only), &script) == ESP_ERR_INVALID_ARG);
+    CHECK(sg90_script_compile(self_target, STEP_COUNT(self_target), &script) == ESP_ERR_INVALID_ARG);
+    CHECK(sg90_script_compile(first_step, STEP_COUNT(first_step), &script) == ESP_ERR_INVALID_ARG);
+    CHECK(sg90_script_compile(zero_count, STEP_COUNT(zero_count), &script) == ESP_ERR_INVALID_ARG);
+    CHECK(sg90_script_compile(zero_hold, STEP_COUNT(zero_hold), &script) == ESP_ERR_INVALID_ARG);
+    CHECK(sg90_script_compile(end_step, STEP_COUNT(end_step), &script) == ESP_ERR_INVALID_ARG);
+    CHECK(sg90_script_compile(loop_only, 0, &script) == ESP_ERR_INVALID_ARG);
+    CHECK(sg90_script_compile(loop_only, SG90_SCRIPT_MAX_STEPS + 1, &script) == ESP_ERR_INVALID_ARG);
+    CHECK(sg90_script_compile(NULL, 1, &script) == ESP_ERR_INVALID_ARG);
+    CHECK(sg90_script_compile(loop_only, 1, NULL) == ESP_ERR_INVALID_ARG);
+    
+    printf("[untimed] 失败 %d\n", failures);
+    return failures;
+}
+
+/**
+ * @brief 总周期数超过 UINT32_MAX 时饱和，中间的乘积也不能在uint64中回绕
+ */
+static int test_total_overflow(void)
+{
+    int failures = 0;
+    sg90_script_step_t steps[SG90_SCRIPT_LOOP_DEPTH + 2];
+    sg90_script_t script;
+    
+    // 2^15 个周期重复 (2^15)^4 次共 2^75 个周期，在uint64中回绕为0，加上最后1个周期得到1
+    const sg90_script_step_t hold = SG90_SCRIPT_HOLD(1u << 15);
+    const sg90_script_step_t loop = SG90_SCRIPT_LOOP(0, 1u << 15);
+    const sg90_script_step_t last = SG90_SCRIPT_SET(0);
+    steps[0] = hold;
+    for (int i = 1; i <= SG90_SCRIPT_LOOP_DEPTH; i++) {
+        steps[i] = loop;
+    }
+    steps[SG90_SCRIPT_LOOP_DEPTH + 1] = last;
+    CHECK(sg90_script_compile(steps, SG90_SCRIPT_LOOP_DEPTH + 2, &script) == ESP_OK);
+    CHECK(script.total_periods == UINT32_MAX);
+    
+    // 刚好不溢出：65535 * 65535 + 2 * 65535 = 2^32 - 1
+    static const sg90_script_step_t exact[] = {
+        SG90_SCRIPT_HOLD(UINT16_MAX),
+        SG90_SCRIPT_LOOP(0, UINT16_MAX),
+        SG90_SCRIPT_HOLD(UINT16_MAX),
+        SG90_SCRIPT_HOLD(UINT16_MAX),
+    };
+    CHECK(sg90_script_compile(exact, STEP_COUNT(exact), &script) == ESP_OK);
+    CHECK(script.total_periods == UINT32_MAX);
+    CHECK(script.len == STEP_COUNT(exact) + 1);
+    
+    // 每层都不溢出，但累加后超出
+    static const sg90_script_step_t sum[] = {
+        SG90_SCRIPT_HOLD(UINT16_MAX),
+        SG90_SCRIPT_LOOP(0, UINT16_MAX),
+        SG90_SCRIPT_HOLD(UINT16_MAX),
+        SG90_SCRIPT_LOOP(2, UINT16_MAX),
+    };
+    CHECK(sg90_script_compile(sum, STEP_COUNT(sum), &script) == ESP_OK);
+    CHECK(script.total_periods == UINT32_MAX);
+    
+    printf("[overflow] 失败 %d\n", failures);
+    return failures;
+}
+
+int main(void)
+{
+    int failures = test_feed_example() + test_crossing_loops() + test_equal_targets() +
+                   test_depth_limit() + test_untimed_body() + test_total_overflow();
+    printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    return failures == 0 ? 0 : 1;
+}
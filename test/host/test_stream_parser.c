@@ -0,0 +1,225 @@
+/**
+ * @file test_stream_parser.c
+ * @brief 流式分帧器主机端测试
+ * 
+ * 用一段混合了旧协议数字、标签协议行、二进制帧、超长行、非法长度字节和杂散字节的输入，
+ * 先一次性输入得到参考帧序列（并与预期逐帧比较），再在所有两个切分点的组合处把输入切成三段
+ * 依次输入，要求输出的帧序列与参考完全一致。按行分帧的方式同样测试
+ */
+
+#include "stream_parser.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_INPUT_MAX  512     // 测试输入最大长度
+#define TEST_FRAMES_MAX 64      // 单次解析最多帧数
+
+// 收集到的帧（复制数据，分帧器缓冲区在下一次输入后失效）
+typedef struct {
+    stream_frame_type_t type;
+    size_t len;
+    uint8_t data[STREAM_PARSER_BUF_SIZE];
+} test_frame_t;
+
+// 预期的帧
+typedef struct {
+    stream_frame_type_t type;
+    const char *data;           // NULL表示只比较类型和长度
+    size_t len;
+} test_expect_t;
+
+typedef struct {
+    uint8_t data[TEST_INPUT_MAX];
+    size_t len;
+} test_input_t;
+
+static void input_add(test_input_t *input, const void *data, size_t len)
+{
+    memcpy(input->data + input->len, data, len);
+    input->len += len;
+}
+
+static void input_add_str(test_input_t *input, const char *str)
+{
+    input_add(input, str, strlen(str));
+}
+
+/**
+ * @brief 按切分点分段输入，收集所有帧
+ * @return 帧数，-1表示分帧器没有推进（死循环）或帧数超限
+ */
+static int parse_split(stream_parser_framing_t framing, const test_input_t *input,
+                       const size_t *cuts, size_t cut_count, test_frame_t *frames)
+{
+    stream_parser_t parser;
+    stream_parser_init(&parser, framing);
+    
+    int count = 0;
+    size_t start = 0;
+    for (size_t seg = 0; seg <= cut_count; seg++) {
+        size_t end = seg < cut_count ? cuts[seg] : input->len;
+        const uint8_t *data = input->data + start;
+        size_t len = end - start;
+        while (len > 0) {
+            stream_frame_t frame;
+            size_t used = stream_parser_feed(&parser, data, len, &frame);
+            if (used == 0 && frame.type == STREAM_FRAME_NONE) {
+                return -1;
+            }
+            data += used;
+            len -= used;
+            if (frame.type != STREAM_FRAME_NONE) {
+                if (count >= TEST_FRAMES_MAX) {
+                    return -1;
+                }
+                frames[count].type = frame.type;
+                frames[count].len = frame.len;
+                memcpy(frames[count].data, frame.data, frame.len);
+                count++;
+            }
+        }
+        start = end;
+    }
+    return count;
+}
+
+static bool frames_equal(const test_frame_t *a, int a_count, const test_frame_t *b, int b_count)
+{
+    if (a_count != b_count) {
+        return false;
+    }
+    for (int i = 0; i < a_count; i++) {
+        if (a[i].type != b[i].type || a[i].len != b[i].len || memcmp(a[i].data, b[i].data, a[i].len) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 一次性输入与预期比较，再与所有两个切分点的组合比较
+ * @return 失败数
+ */
+static int check_stream(const char *name, stream_parser_framing_t framing, const test_input_t *input,
+                        const test_expect_t *expect, int expect_count)
+{
+    static test_frame_t ref[TEST_FRAMES_MAX];
+    static test_frame_t got[TEST_FRAMES_MAX];
+    int failures = 0;
+    
+    int ref_count = parse_split(framing, input, NULL, 0, ref);
+    if (ref_count != expect_count) {
+        printf("[%s] 一次性输入: 帧数 %d，预期 %d\n", name, ref_count, expect_count);
+        return 1;
+    }
+    for (int i = 0; i < expect_count; i++) {
+        size_t len = expect[i].data ? strlen(expect[i].data) : expect[i].len;
+        if (ref[i].type != expect[i].type || ref[i].len != len ||
+            (expect[i].data && memcmp(ref[i].data, expect[i].data, len) != 0)) {
+            printf("[%s] 一次性输入: 第%d帧 type=%d len=%u，预期 type=%d len=%u\n",
+                   name, i, ref[i].type, (unsigned)ref[i].len, expect[i].type, (unsigned)len);
+            failures++;
+        }
+    }
+    
+    unsigned splits = 0;
+    for (size_t i = 0; i <= input->len; i++) {
+        for (size_t j = i; j <= input->len; j++) {
+            size_t cuts[2] = { i, j };
+            int got_count = parse_split(framing, input, cuts, 2, got);
+            splits++;
+            if (!frames_equal(ref, ref_count, got, got_count)) {
+                if (failures < 10) {
+                    printf("[%s] 切分点 %u,%u: 帧序列与一次性输入不同 (%d帧，参考%d帧)\n",
+                           name, (unsigned)i, (unsigned)j, got_count, ref_count);
+                }
+                failures++;
+            }
+        }
+    }
+    
+    printf("[%s] %u字节，%d帧，%u种切分，失败 %d\n", name, (unsigned)input->len, ref_count, splits, failures);
+    return failures;
+}
+
+static int test_mixed(void)
+{
+    test_input_t input = { .len = 0 };
+    char long_line[STREAM_PARSER_LINE_MAX + 20];
+    
+    // 旧协议数字和标签协议行（CRLF和LF结尾）
+    input_add_str(&input, "12#t1 FEED 0 2\r\n#x STATUS\n9");
+    // 有效长度的二进制帧（分帧器不检查CRC）
+    static const uint8_t bin_a[] = { BINARY_PROTOCOL_SOF, 2, 0x01, 0x34, 0x12, 0x5A, 0x00, 0xBE, 0xEF };
+    input_add(&input, bin_a, sizeof(bin_a));
+    // 超长行
+    memset(long_line, 'a', sizeof(long_line));
+    long_line[0] = '#';
+    long_line[sizeof(long_line) - 1] = '\n';
+    input_add(&input, long_line, sizeof(long_line));
+    // 长度字段非法：报告帧起始字节，长度字节作为下一帧的开头重新判断
+    static const uint8_t bad_len[] = { BINARY_PROTOCOL_SOF, 0xFF, '3' };
+    input_add(&input, bad_len, sizeof(bad_len));
+    // 长度字段非法且长度字节本身是帧起始字节
+    static const uint8_t bad_len_sof[] = { BINARY_PROTOCOL_SOF, BINARY_PROTOCOL_SOF, 0 };
+    input_add(&input, bad_len_sof, sizeof(bad_len_sof));
+    static const uint8_t bin_tail[] = { 0x02, 0x00, 0x01, 0xAA, 0xBB };
+    input_add(&input, bin_tail, sizeof(bin_tail));
+    // 杂散字节、空行和最大长度的二进制帧
+    input_add_str(&input, "x\n\n#z 5\n");
+    uint8_t bin_max[BINARY_PROTOCOL_MAX_FRAME];
+    memset(bin_max, 0x5C, sizeof(bin_max));
+    bin_max[0] = BINARY_PROTOCOL_SOF;
+    bin_max[1] = BINARY_PROTOCOL_MAX_PAYLOAD;
+    input_add(&input, bin_max, sizeof(bin_max));
+    input_add_str(&input, "7");
+    
+    const test_expect_t expect[] = {
+        { STREAM_FRAME_DIGIT, "1", 0 },
+        { STREAM_FRAME_DIGIT, "2", 0 },
+        { STREAM_FRAME_LINE, "t1 FEED 0 2", 0 },
+        { STREAM_FRAME_LINE, "x STATUS", 0 },
+        { STREAM_FRAME_DIGIT, "9", 0 },
+        { STREAM_FRAME_BINARY, NULL, sizeof(bin_a) },
+        { STREAM_FRAME_LINE_TOO_LONG, NULL, STREAM_PARSER_LINE_MAX },
+        { STREAM_FRAME_INVALID, "\xA5", 0 },
+        { STREAM_FRAME_INVALID, "\xFF", 0 },
+        { STREAM_FRAME_DIGIT, "3", 0 },
+        { STREAM_FRAME_INVALID, "\xA5", 0 },
+        { STREAM_FRAME_BINARY, NULL, BINARY_PROTOCOL_HEADER_LEN + BINARY_PROTOCOL_CRC_LEN },
+        { STREAM_FRAME_INVALID, "x", 0 },
+        { STREAM_FRAME_LINE, "z 5", 0 },
+        { STREAM_FRAME_BINARY, NULL, BINARY_PROTOCOL_MAX_FRAME },
+        { STREAM_FRAME_DIGIT, "7", 0 },
+    };
+    return check_stream("mixed", STREAM_PARSER_FRAMING_MIXED, &input, expect, sizeof(expect) / sizeof(expect[0]));
+}
+
+static int test_line(void)
+{
+    test_input_t input = { .len = 0 };
+    char long_line[STREAM_PARSER_LINE_MAX + 5];
+    
+    input_add_str(&input, "FEED 1\r\n\nSTATUS\n");
+    memset(long_line, 'b', sizeof(long_line));
+    long_line[sizeof(long_line) - 1] = '\n';
+    input_add(&input, long_line, sizeof(long_line));
+    input_add_str(&input, "#12\n\xA5 raw\nPING\n");
+    
+    const test_expect_t expect[] = {
+        { STREAM_FRAME_LINE, "FEED 1", 0 },
+        { STREAM_FRAME_LINE, "STATUS", 0 },
+        { STREAM_FRAME_LINE_TOO_LONG, NULL, STREAM_PARSER_LINE_MAX },
+        { STREAM_FRAME_LINE, "#12", 0 },
+        { STREAM_FRAME_LINE, "\xA5 raw", 0 },
+        { STREAM_FRAME_LINE, "PING", 0 },
+    };
+    return check_stream("line", STREAM_PARSER_FRAMING_LINE, &input, expect, sizeof(expect) / sizeof(expect[0]));
+}
+
+int main(void)
+{
+    int failures = test_mixed() + test_line();
+    printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+TCP连接反复建立/断开的长时间压力测试（主机端，只依赖Python标准库）
+
+用法:
+    python3 tools/conn_soak.py <设备IP> [--port 8080] [--duration 600] [--concurrency 4]
+                               [--interval 10] [--tolerance 512]
+
+多个线程不断建立连接、发送一条标签状态查询、读取回复后关闭连接，
+其中一部分连接不读回复直接关闭或发送半行后断开，覆盖异常断开的路径。
+每隔 interval 秒新建一个连接发送 "#soak STATUS"，从回复中读取
+heap=<内部DRAM空闲字节> heap_min=<历史最低> conns=<使用中/总槽位>，输出JSON时间序列。
+
+预热（前两个采样）之后空闲堆的最大最小值之差不超过 tolerance 字节时判定为通过，
+即连接的建立和关闭不会在堆上留下分配
+"""
+
+import argparse
+import json
+import random
+import re
+import socket
+import threading
+import time
+
+STATUS_RE = re.compile(r"heap=(\d+) heap_min=(\d+)")
+CONNS_RE = re.compile(r"conns=(\d+)/(\d+)")
+
+
+def query_status(args):
+    """新建一个连接读取状态，槽位用尽时重试"""
+    for _ in range(20):
+        try:
+            with socket.create_connection((args.host, args.port), timeout=5) as sock:
+                sock.sendall(b"#soak STATUS\n")
+                buf = b""
+                while b"\n" not in buf:
+                    chunk = sock.recv(256)
+                    if not chunk:
+                        break
+                    buf += chunk
+                line = buf.decode(errors="replace")
+                match = STATUS_RE.search(line)
+                if match:
+                    conns = CONNS_RE.search(line)
+                    return {
+                        "heap": int(match.group(1)),
+                        "heap_min": int(match.group(2)),
+                        "conns": conns.group(0)[6:] if conns else None,
+                    }
+        except OSError:
+            pass
+        time.sleep(0.2)
+    return None
+
+
+def churn(args, stop, counters, lock):
+    """不断建立并断开连接"""
+    rng = random.Random()
+    while not stop.is_set():
+        mode = rng.random()
+        try:
+            sock = socket.create_connection((args.host, args.port), timeout=5)
+            if mode < 0.7:
+                # 正常请求/回复后关闭
+                sock.sendall(b"#c STATUS\n")
+                sock.recv(256)
+            elif mode < 0.85:
+                # 发送半行后直接断开
+                sock.sendall(b"#half")
+            # 其余：建立连接后立即断开
+            sock.close()
+            with lock:
+                counters["connections"] += 1
+        except OSError:
+            with lock:
+                counters["errors"] += 1
+            time.sleep(0.05)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SmartFishFeeder TCP连接压力测试")
+    parser.add_argument("host", help="设备IP地址")
+    parser.add_argument("--port", type=int, default=8080, help="TCP端口（默认8080）")
+    parser.add_argument("--duration", type=float, default=600.0, help="测试时长，秒（默认600）")
+    parser.add_argument("--concurrency", type=int, default=4, help="并发建立连接的线程数（默认4）")
+    parser.add_argument("--interval", type=float, default=10.0, help="采样间隔，秒（默认10）")
+    parser.add_argument("--tolerance", type=int, default=512, help="允许的空闲堆波动，字节（默认512）")
+    args = parser.parse_args()
+
+    stop = threading.Event()
+    lock = threading.Lock()
+    counters = {"connections": 0, "errors": 0}
+    threads = [threading.Thread(target=churn, args=(args, stop, counters, lock), daemon=True)
+               for _ in range(args.concurrency)]
+
+    samples = []
+    started = time.monotonic()
+    first = query_status(args)
+    if first:
+        samples.append(dict(first, t=0.0, connections=0))
+    for t in threads:
+        t.start()
+
+    while time.monotonic() - started < args.duration:
+        time.sleep(args.interval)
+        sample = query_status(args)
+        if sample:
+            with lock:
+                sample.update(t=round(time.monotonic() - started, 1), connections=counters["connections"])
+            samples.append(sample)
+            print(json.dumps(sample, ensure_ascii=False), flush=True)
+
+    stop.set()
+    for t in threads:
+        t.join(timeout=10)
+
+    steady = [s["heap"] for s in samples[2:]] or [s["heap"] for s in samples]
+    drift = (max(steady) - min(steady)) if steady else None
+    print(json.dumps({
+        "samples": len(samples),
+        "connections": counters["connections"],
+        "connect_errors": counters["errors"],
+        "heap_first": samples[0]["heap"] if samples else None,
+        "heap_last": samples[-1]["heap"] if samples else None,
+        "heap_min": min(s["heap_min"] for s in samples) if samples else None,
+        "steady_heap_drift": drift,
+        "pass": drift is not None and drift <= args.tolerance,
+    }, ensure_ascii=False, indent=2))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,329 @@
+#!/usr/bin/env python3
+"""
+TCP命令端口负载生成与延迟测试（主机端，只依赖Python标准库，Linux）
+
+用法:
+    # 对真实设备，或对 ESP-IDF linux 目标编译出的固件（--host 127.0.0.1）
+    python3 tools/load_gen.py <设备IP> [--port 8080] [--concurrency 4] [--depth 4]
+                              [--duration 10] [--warmup 1] [--mix STATUS:8,5:1] [--until ack] [--batch]
+
+    # 没有硬件时，在本进程中启动一个模拟服务器（同样的标签协议 + 模拟舵机队列）验证工具本身
+    python3 tools/load_gen.py --self-test [--mock-move-ms 20]
+
+concurrency 个连接各自运行一个线程，每个连接上最多 depth 条请求同时在途（流水线），
+收到回复后立即补发，即闭环压测。每条请求为 "#<tag> <cmd>"，tag 在全部连接中唯一，
+按回复行开头的 "#<tag> " 与请求对应。
+--batch 时每个连接把 depth 条请求放在一次 send 中发出，全部完成后再发下一批，
+另外统计整批的延迟（batch_latency_ms，例如 --depth 10 即10条命令的一个数据包）。
+
+mix 为逗号分隔的 "<命令>:<权重>"，命令即标签协议中的 cmd（STATUS 或数字 0-9）。
+until 决定一条请求何时算完成:
+  - ack:  收到第一条回复（ACCEPTED/QUEUED/STATUS/BUSY/ERROR ...）
+  - done: 动作命令等到 DONE/FAILED 完成回复；ACCEPTED/QUEUED 只记为确认
+注意设备默认的限流（每IP每秒5条动作命令、每连接4条未完成命令）会让超出的动作命令回复BUSY，
+这些请求照常计入延迟并在 results 中单独计数。
+
+输出JSON: 吞吐量（完成请求数/秒）、各回复类型计数、p50/p95/p99/p99.9 延迟，
+以及按2的幂微秒分桶的延迟直方图（桶上界 -> 次数）。预热期内完成的请求不计入统计
+"""
+
+import argparse
+import json
+import queue
+import random
+import socket
+import threading
+import time
+
+PENDING_REPLIES = ("ACCEPTED", "QUEUED")    # 动作命令的中间回复，--until done 时不算完成
+
+
+def parse_mix(text):
+    """解析 "STATUS:8,5:1" 为 [(命令, 权重)]"""
+    mix = []
+    for item in text.split(","):
+        command, _, weight = item.strip().partition(":")
+        if not command:
+            continue
+        mix.append((command, float(weight) if weight else 1.0))
+    if not mix:
+        raise ValueError("命令组合为空")
+    return mix
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return 0.0
+    k = min(len(sorted_values) - 1, int(round(p / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[k]
+
+
+def histogram(latencies):
+    """按2的幂微秒分桶，返回 {"<=上界us": 次数}"""
+    buckets = {}
+    for value in latencies:
+        bound = 1
+        us = value * 1e6
+        while bound < us:
+            bound <<= 1
+        buckets[bound] = buckets.get(bound, 0) + 1
+    return {f"<={bound}us": buckets[bound] for bound in sorted(buckets)}
+
+
+class Connection:
+    """一个压测连接：流水线发送并按标签匹配回复"""
+
+    def __init__(self, args, index, mix, stats):
+        self.args = args
+        self.index = index
+        self.mix_commands = [c for c, _ in mix]
+        self.mix_weights = [w for _, w in mix]
+        self.rng = random.Random(args.seed * 1000 + index)
+        self.stats = stats
+        self.inflight = {}      # tag -> (发送时间, 命令)
+        self.batch_sent = 0.0
+        self.seq = 0
+        self.buf = b""
+
+    def next_request(self, sent):
+        self.seq += 1
+        tag = f"c{self.index}.{self.seq}"
+        command = self.rng.choices(self.mix_commands, self.mix_weights)[0]
+        self.inflight[tag] = (sent, command)
+        return f"#{tag} {command}\n"
+
+    def send_one(self, sock):
+        sock.sendall(self.next_request(time.perf_counter()).encode())
+
+    def send_batch(self, sock):
+        self.batch_sent = time.perf_counter()
+        payload = "".join(self.next_request(self.batch_sent) for _ in range(self.args.depth))
+        sock.sendall(payload.encode())
+
+    def handle_line(self, line, now):
+        if not line.startswith("#"):
+            return     # 事件推送或旧协议回复
+        tag, _, rest = line[1:].partition(" ")
+        entry = self.inflight.get(tag)
+        if entry is None:
+            return     # --until ack 时动作命令稍后的完成回复
+        kind = rest.split(" ", 1)[0] or "?"
+        if self.args.until == "done" and kind in PENDING_REPLIES:
+            return
+        del self.inflight[tag]
+        self.stats.record(entry[0], now, kind)
+        if self.args.batch and not self.inflight:
+            self.stats.record_batch(self.batch_sent, now)
+
+    def run(self, start_at, stop_at):
+        sock = socket.create_connection((self.args.host, self.args.port), timeout=5)
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        try:
+            while time.perf_counter() < start_at:
+                time.sleep(0.001)
+            while True:
+                now = time.perf_counter()
+                if now < stop_at:
+                    if self.args.batch:
+                        if not self.inflight:
+                            self.send_batch(sock)
+                    else:
+                        while len(self.inflight) < self.args.depth:
+                            self.send_one(sock)
+                elif not self.inflight or now > stop_at + self.args.drain:
+                    break
+                try:
+                    chunk = sock.recv(4096)
+                except socket.timeout:
+                    self.stats.timeouts += len(self.inflight)
+                    self.inflight.clear()
+                    continue
+                if not chunk:
+                    raise ConnectionError("连接被设备关闭")
+                now = time.perf_counter()
+                self.buf += chunk
+                while b"\n" in self.buf:
+                    line, _, self.buf = self.buf.partition(b"\n")
+                    self.handle_line(line.decode(errors="replace").rstrip("\r"), now)
+        finally:
+            self.stats.unanswered += len(self.inflight)
+            sock.close()
+
+
+class Stats:
+    """全部连接共用的统计"""
+
+    def __init__(self, measure_from):
+        self.lock = threading.Lock()
+        self.measure_from = measure_from
+        self.latencies = []
+        self.batch_latencies = []
+        self.results = {}
+        self.timeouts = 0
+        self.unanswered = 0
+        self.errors = []
+
+    def record(self, sent, now, kind):
+        if sent < self.measure_from:
+            return
+        with self.lock:
+            self.latencies.append(now - sent)
+            self.results[kind] = self.results.get(kind, 0) + 1
+
+    def record_batch(self, sent, now):
+        if sent < self.measure_from:
+            return
+        with self.lock:
+            self.batch_latencies.append(now - sent)
+
+
+def run_load(args, mix):
+    start_at = time.perf_counter() + 0.2
+    measure_from = start_at + args.warmup
+    stop_at = measure_from + args.duration
+    stats = Stats(measure_from)
+
+    def worker(index):
+        try:
+            Connection(args, index, mix, stats).run(start_at, stop_at)
+        except (OSError, ConnectionError) as e:
+            with stats.lock:
+                stats.errors.append(f"连接{index}: {e}")
+
+    threads = [threading.Thread(target=worker, args=(i,)) for i in range(args.concurrency)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    latencies = sorted(stats.latencies)
+    result = {
+        "target": f"{args.host}:{args.port}",
+        "concurrency": args.concurrency,
+        "depth": args.depth,
+        "until": args.until,
+        "mix": {c: w for c, w in mix},
+        "duration_s": args.duration,
+        "completed": len(latencies),
+        "throughput_per_s": round(len(latencies) / args.duration, 1),
+        "results": stats.results,
+        "timeouts": stats.timeouts,
+        "unanswered": stats.unanswered,
+        "errors": stats.errors,
+        "latency_ms": {
+            "p50": round(percentile(latencies, 50) * 1000, 3),
+            "p95": round(percentile(latencies, 95) * 1000, 3),
+            "p99": round(percentile(latencies, 99) * 1000, 3),
+            "p99.9": round(percentile(latencies, 99.9) * 1000, 3),
+            "max": round(latencies[-1] * 1000, 3) if latencies else 0.0,
+        },
+        "histogram": histogram(latencies),
+    }
+    if args.batch:
+        batches = sorted(stats.batch_latencies)
+        result["batches"] = len(batches)
+        result["batch_latency_ms"] = {
+            "p50": round(percentile(batches, 50) * 1000, 3),
+            "p99": round(percentile(batches, 99) * 1000, 3),
+            "max": round(batches[-1] * 1000, 3) if batches else 0.0,
+        }
+    return result
+
+
+def run_mock_server(args, ready):
+    """模拟设备：标签协议 + 容量8的舵机队列，每个动作耗时 mock_move_ms"""
+    capacity = 8
+    moves = queue.Queue()
+    pending = [0]
+    lock = threading.Lock()
+
+    def actuator():
+        while True:
+            conn, tag, angle = moves.get()
+            time.sleep(args.mock_move_ms / 1000.0)
+            with lock:
+                pending[0] -= 1
+            try:
+                conn.sendall(f"#{tag} DONE {angle}\n".encode())
+            except OSError:
+                pass
+
+    def reply(conn, tag, command):
+        if command == "STATUS":
+            return f"#{tag} STATUS pending={pending[0]}/{capacity} wifi=1\n"
+        if len(command) == 1 and command.isdigit():
+            angle = int(command) * 20
+            with lock:
+                if pending[0] >= capacity:
+                    return f"#{tag} REJECTED full\n"
+                pending[0] += 1
+                queued = pending[0] > 1
+            moves.put((conn, tag, angle))
+            return f"#{tag} QUEUED {pending[0]}\n" if queued else f"#{tag} ACCEPTED\n"
+        return f"#{tag} ERROR bad-command\n"
+
+    def serve(conn):
+        conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        buf = b""
+        try:
+            while True:
+                chunk = conn.recv(4096)
+                if not chunk:
+                    break
+                buf += chunk
+                out = []
+                while b"\n" in buf:
+                    line, _, buf = buf.partition(b"\n")
+                    tag, _, command = line.decode(errors="replace")[1:].partition(" ")
+                    out.append(reply(conn, tag, command.strip()))
+                conn.sendall("".join(out).encode())    # 与设备一样，同一批输入的回复合并发送
+        except OSError:
+            pass
+        finally:
+            conn.close()
+
+    threading.Thread(target=actuator, daemon=True).start()
+    listener = socket.create_server(("127.0.0.1", 0))
+    args.host, args.port = "127.0.0.1", listener.getsockname()[1]
+    ready.set()
+    while True:
+        conn, _ = listener.accept()
+        threading.Thread(target=serve, args=(conn,), daemon=True).start()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SmartFishFeeder TCP命令端口负载测试")
+    parser.add_argument("host", nargs="?", help="设备IP地址")
+    parser.add_argument("--port", type=int, default=8080, help="TCP端口（默认8080）")
+    parser.add_argument("--concurrency", type=int, default=4, help="并发连接数（默认4）")
+    parser.add_argument("--depth", type=int, default=4, help="每个连接在途请求数（默认4）")
+    parser.add_argument("--duration", type=float, default=10.0, help="统计时长，秒（默认10）")
+    parser.add_argument("--warmup", type=float, default=1.0, help="预热时长，秒（默认1）")
+    parser.add_argument("--drain", type=float, default=5.0, help="结束后等待在途回复的最长时间，秒（默认5）")
+    parser.add_argument("--mix", default="STATUS:1", help="命令组合，如 STATUS:8,5:1（默认STATUS:1）")
+    parser.add_argument("--until", choices=("ack", "done"), default="ack", help="请求完成的判定（默认ack）")
+    parser.add_argument("--batch", action="store_true", help="每批 depth 条请求一次发送，全部完成后再发下一批")
+    parser.add_argument("--seed", type=int, default=1, help="命令组合的随机种子（默认1）")
+    parser.add_argument("--self-test", action="store_true", help="对本进程中的模拟服务器测试")
+    parser.add_argument("--mock-move-ms", type=float, default=20.0, help="--self-test 中每个动作的耗时（默认20）")
+    args = parser.parse_args()
+
+    if args.concurrency < 1 or args.depth < 1:
+        parser.error("--concurrency 和 --depth 至少为1")
+    try:
+        mix = parse_mix(args.mix)
+    except ValueError as e:
+        parser.error(f"--mix: {e}")
+
+    if args.self_test:
+        ready = threading.Event()
+        threading.Thread(target=run_mock_server, args=(args, ready), daemon=True).start()
+        ready.wait()
+    elif not args.host:
+        parser.error("需要设备IP地址")
+
+    print(json.dumps(run_load(args, mix), ensure_ascii=False, indent=2))
+
+
+if __name__ == "__main__":
+    main()
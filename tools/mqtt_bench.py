@@ -0,0 +1,271 @@
+#!/usr/bin/env python3
+"""
+MQTT控制通道吞吐量/延迟测试（主机端，只依赖Python标准库，内置最小的MQTT 3.1.1客户端）
+
+用法:
+    # 对真实设备：向 feeder/<id>/cmd 发布1000条QoS1命令，统计 feeder/<id>/reply 上的回复
+    python3 tools/mqtt_bench.py --broker 127.0.0.1 --device feeder-a1b2c3
+
+    # 没有硬件时，在同一进程中运行一个模拟设备，对本地mosquitto验证整条链路
+    mosquitto -p 1883 &
+    python3 tools/mqtt_bench.py --broker 127.0.0.1 --device mock --mock-device
+
+选项:
+    --count N     命令数（默认1000）
+    --batch K     每条MQTT消息包含的命令行数（默认1，设备支持一条消息多行命令）
+    --command C   命令（默认STATUS，不驱动舵机；用数字命令时注意设备队列长度为8）
+输出JSON: 命令数、收到的回复数、各回复类型计数、耗时、commands/s、p50/p95/p99延迟
+
+"1000条命令"测的是MQTT往返和命令分发，不是1000条排队的动作：设备的动作队列长度为
+ACTUATOR_QUEUE_LENGTH（8），数字命令最多8条排队，其余立即回复 "REJECTED full"，
+results 中可以看到各类回复的数量。动作完成不在回复主题上通知（见状态主题）。
+
+QoS1的重复投递只有带请求ID的命令（"#<tag> <cmd> id=<rid>"）才能去重，见 mqtt_control.h
+"""
+
+import argparse
+import json
+import socket
+import struct
+import threading
+import time
+
+
+def _encode_length(n):
+    out = bytearray()
+    while True:
+        byte = n % 128
+        n //= 128
+        out.append(byte | 0x80 if n else byte)
+        if not n:
+            return bytes(out)
+
+
+def _encode_str(s):
+    data = s.encode()
+    return struct.pack("!H", len(data)) + data
+
+
+class MiniMqtt:
+    """最小的MQTT 3.1.1客户端：CONNECT / SUBSCRIBE / PUBLISH(QoS0/1) / PUBACK / PINGREQ"""
+
+    def __init__(self, host, port, client_id, on_message, keepalive=30):
+        self.sock = socket.create_connection((host, port), timeout=10)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.on_message = on_message
+        self.keepalive = keepalive
+        self.lock = threading.Lock()
+        self.next_id = 1
+        self.acked = threading.Semaphore(0)
+        self.unacked = 0
+        self.running = True
+
+        variable = _encode_str("MQTT") + bytes([4, 0x02]) + struct.pack("!H", keepalive)
+        self._send(0x10, variable + _encode_str(client_id))
+        header, body = self._read_packet()
+        if header >> 4 != 2 or body[1] != 0:
+            raise ConnectionError("CONNECT被拒绝")
+        self.sock.settimeout(None)
+
+        threading.Thread(target=self._reader, daemon=True).start()
+        threading.Thread(target=self._pinger, daemon=True).start()
+
+    def _send(self, header, body):
+        with self.lock:
+            self.sock.sendall(bytes([header]) + _encode_length(len(body)) + body)
+
+    def _recv_exact(self, n):
+        data = b""
+        while len(data) < n:
+            chunk = self.sock.recv(n - len(data))
+            if not chunk:
+                raise ConnectionError("连接被关闭")
+            data += chunk
+        return data
+
+    def _read_packet(self):
+        header = self._recv_exact(1)[0]
+        length, shift = 0, 0
+        while True:
+            byte = self._recv_exact(1)[0]
+            length |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        return header, self._recv_exact(length) if length else b""
+
+    def _packet_id(self):
+        with self.lock:
+            pid = self.next_id
+            self.next_id = self.next_id % 65535 + 1
+        return pid
+
+    def _reader(self):
+        try:
+            while self.running:
+                header, body = self._read_packet()
+                ptype = header >> 4
+                if ptype == 3:      # PUBLISH
+                    qos = (header >> 1) & 0x03
+                    topic_len = struct.unpack("!H", body[:2])[0]
+                    topic = body[2:2 + topic_len].decode()
+                    pos = 2 + topic_len
+                    if qos:
+                        pid = body[pos:pos + 2]
+                        pos += 2
+                        self._send(0x40, pid)
+                    self.on_message(topic, body[pos:])
+                elif ptype == 4:    # PUBACK
+                    self.acked.release()
+        except (OSError, ConnectionError):
+            self.running = False
+
+    def _pinger(self):
+        while self.running:
+            time.sleep(self.keepalive / 2)
+            try:
+                self._send(0xC0, b"")
+            except OSError:
+                return
+
+    def subscribe(self, topic, qos=1):
+        self._send(0x82, struct.pack("!H", self._packet_id()) + _encode_str(topic) + bytes([qos]))
+
+    def publish(self, topic, payload, qos=1):
+        if isinstance(payload, str):
+            payload = payload.encode()
+        body = _encode_str(topic)
+        if qos:
+            body += struct.pack("!H", self._packet_id())
+            self.unacked += 1
+        self._send(0x30 | (qos << 1), body + payload)
+
+    def wait_acks(self, timeout):
+        deadline = time.monotonic() + timeout
+        while self.unacked > 0:
+            if not self.acked.acquire(timeout=max(0.0, deadline - time.monotonic())):
+                return False
+            self.unacked -= 1
+        return True
+
+    def close(self):
+        self.running = False
+        try:
+            self._send(0xE0, b"")
+            self.sock.close()
+        except OSError:
+            pass
+
+
+def run_mock_device(args, ready):
+    """模拟设备：订阅命令主题，按设备的文本协议回复到回复主题"""
+    reply_topic = f"feeder/{args.device}/reply"
+    client = None
+
+    def on_message(topic, payload):
+        replies = []
+        for line in payload.decode(errors="replace").splitlines():
+            if not line.startswith("#") or " " not in line:
+                replies.append("#? ERROR bad-tag")
+                continue
+            tag, command = line[1:].split(" ", 1)
+            if command == "STATUS":
+                replies.append(f"#{tag} STATUS pending=0/8 wifi=1")
+            elif len(command) == 1 and command.isdigit():
+                replies.append(f"#{tag} ACCEPTED")
+            else:
+                replies.append(f"#{tag} ERROR bad-command")
+        client.publish(reply_topic, "\n".join(replies) + "\n")
+
+    client = MiniMqtt(args.broker, args.port, f"{args.device}-mock", on_message)
+    client.subscribe(f"feeder/{args.device}/cmd")
+    time.sleep(0.2)
+    ready.set()
+    return client
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return 0.0
+    k = min(len(sorted_values) - 1, int(round(p / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[k]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SmartFishFeeder MQTT吞吐量测试")
+    parser.add_argument("--broker", default="127.0.0.1", help="MQTT服务器地址")
+    parser.add_argument("--port", type=int, default=1883, help="MQTT服务器端口")
+    parser.add_argument("--device", required=True, help="设备ID（主题 feeder/<id>/...）")
+    parser.add_argument("--count", type=int, default=1000, help="命令数")
+    parser.add_argument("--batch", type=int, default=1, help="每条消息的命令行数")
+    parser.add_argument("--command", default="STATUS", help="命令（默认STATUS）")
+    parser.add_argument("--timeout", type=float, default=30.0, help="等待回复的最长时间，秒")
+    parser.add_argument("--mock-device", action="store_true", help="在本进程中运行模拟设备")
+    args = parser.parse_args()
+
+    mock = None
+    if args.mock_device:
+        ready = threading.Event()
+        mock = run_mock_device(args, ready)
+        ready.wait()
+
+    sent_at = {}
+    latencies = []
+    results = {}
+    done = threading.Event()
+
+    def on_message(topic, payload):
+        now = time.perf_counter()
+        for line in payload.decode(errors="replace").splitlines():
+            tag, _, rest = line[1:].partition(" ") if line.startswith("#") else (None, "", "")
+            start = sent_at.pop(tag, None)
+            if start is not None:
+                latencies.append(now - start)
+                kind = rest.split(" ", 1)[0] or "?"
+                results[kind] = results.get(kind, 0) + 1
+        if len(latencies) >= args.count:
+            done.set()
+
+    client = MiniMqtt(args.broker, args.port, f"bench-{int(time.time())}", on_message)
+    client.subscribe(f"feeder/{args.device}/reply")
+    time.sleep(0.2)
+
+    cmd_topic = f"feeder/{args.device}/cmd"
+    started = time.perf_counter()
+    for first in range(0, args.count, args.batch):
+        lines = []
+        for i in range(first, min(first + args.batch, args.count)):
+            tag = f"m{i}"
+            sent_at[tag] = time.perf_counter()
+            lines.append(f"#{tag} {args.command}")
+        client.publish(cmd_topic, "\n".join(lines) + "\n")
+    publish_done = time.perf_counter()
+    acked = client.wait_acks(args.timeout)
+
+    done.wait(args.timeout)
+    elapsed = time.perf_counter() - started
+    client.close()
+    if mock:
+        mock.close()
+
+    latencies.sort()
+    print(json.dumps({
+        "commands": args.count,
+        "batch": args.batch,
+        "replies": len(latencies),
+        "missing": args.count - len(latencies),
+        "results": results,
+        "all_puback": acked,
+        "publish_s": round(publish_done - started, 3),
+        "elapsed_s": round(elapsed, 3),
+        "commands_per_s": round(len(latencies) / elapsed, 1) if elapsed > 0 else 0.0,
+        "latency_ms": {
+            "p50": round(percentile(latencies, 50) * 1000, 2),
+            "p95": round(percentile(latencies, 95) * 1000, 2),
+            "p99": round(percentile(latencies, 99) * 1000, 2),
+        },
+    }, ensure_ascii=False, indent=2))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""
+REST API 与原始TCP协议的对比压测（主机端，只依赖Python标准库）
+
+用法:
+    python3 tools/rest_bench.py <设备IP> [--http-port 80] [--tcp-port 8080]
+                                [--clients 1,4] [--duration 10] [--paths tcp,rest]
+
+两条路径都发送状态查询（不驱动舵机、不受命令限流影响），每个客户端保持一条长连接
+以闭环方式发送请求:
+  - rest: HTTP/1.1 keep-alive 的 GET /status
+  - tcp:  标签协议 "#<tag> STATUS\\n"，等待以 "#<tag> " 开头的回复行
+输出每种路径、每个并发数下的 requests/s 以及 p50/p99 延迟（JSON）。
+--paths tcp 只测原始TCP路径，例如对 test/host 中的 tcp_server_host（没有HTTP服务器）
+"""
+
+import argparse
+import http.client
+import json
+import socket
+import threading
+import time
+
+
+def rest_client(args, stop_at, stats):
+    conn = http.client.HTTPConnection(args.host, args.http_port, timeout=5)
+    while time.monotonic() < stop_at:
+        start = time.perf_counter()
+        conn.request("GET", "/status", headers={"Connection": "keep-alive"})
+        response = conn.getresponse()
+        response.read()
+        if response.status != 200:
+            stats["errors"] += 1
+            continue
+        stats["latencies"].append(time.perf_counter() - start)
+    conn.close()
+
+
+def tcp_client(args, index, stop_at, stats):
+    sock = socket.create_connection((args.host, args.tcp_port), timeout=5)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    buf = b""
+    seq = 0
+    while time.monotonic() < stop_at:
+        tag = f"r{index}-{seq}".encode()
+        start = time.perf_counter()
+        sock.sendall(b"#" + tag + b" STATUS\n")
+        while True:
+            line, sep, rest = buf.partition(b"\n")
+            if sep:
+                buf = rest
+                if line.startswith(b"#" + tag + b" "):
+                    break
+                continue
+            chunk = sock.recv(1024)
+            if not chunk:
+                raise ConnectionError("连接被关闭")
+            buf += chunk
+        stats["latencies"].append(time.perf_counter() - start)
+        seq += 1
+    sock.close()
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return 0.0
+    k = min(len(sorted_values) - 1, int(round(p / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[k]
+
+
+def run_round(args, path, clients):
+    stats = [{"latencies": [], "errors": 0} for _ in range(clients)]
+    stop_at = time.monotonic() + args.duration
+
+    def worker(i):
+        try:
+            if path == "rest":
+                rest_client(args, stop_at, stats[i])
+            else:
+                tcp_client(args, i, stop_at, stats[i])
+        except (OSError, ConnectionError, http.client.HTTPException):
+            stats[i]["errors"] += 1
+
+    threads = [threading.Thread(target=worker, args=(i,)) for i in range(clients)]
+    started = time.monotonic()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.monotonic() - started
+
+    latencies = sorted(l for s in stats for l in s["latencies"])
+    return {
+        "path": path,
+        "clients": clients,
+        "requests": len(latencies),
+        "requests_per_s": round(len(latencies) / elapsed, 1) if elapsed > 0 else 0.0,
+        "latency_ms": {
+            "p50": round(percentile(latencies, 50) * 1000, 2),
+            "p99": round(percentile(latencies, 99) * 1000, 2),
+        },
+        "errors": sum(s["errors"] for s in stats),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SmartFishFeeder REST/TCP对比压测")
+    parser.add_argument("host", help="设备IP地址")
+    parser.add_argument("--http-port", type=int, default=80, help="HTTP端口（默认80）")
+    parser.add_argument("--tcp-port", type=int, default=8080, help="TCP端口（默认8080）")
+    parser.add_argument("--clients", default="1,4", help="并发连接数列表（默认1,4）")
+    parser.add_argument("--duration", type=float, default=10.0, help="每轮测试时长，秒（默认10）")
+    parser.add_argument("--paths", default="tcp,rest", help="测试的路径（默认tcp,rest）")
+    args = parser.parse_args()
+
+    paths = [p.strip() for p in args.paths.split(",") if p.strip()]
+    if not paths or any(p not in ("tcp", "rest") for p in paths):
+        parser.error("--paths 只能包含 tcp 和 rest")
+
+    report = []
+    for n in (int(c) for c in args.clients.split(",")):
+        for path in paths:
+            report.append(run_round(args, path, n))
+    print(json.dumps(report, ensure_ascii=False, indent=2))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""
+舵机空闲断开的功耗模型（主机端，只依赖Python标准库）
+
+用法:
+    python3 tools/servo_power_model.py [--feeds-per-day 3] [--portions 2] [--angle 90]
+                                       [--hold-ms 1000] [--detach-ms 2000] [--json]
+
+按20ms的PWM周期逐周期模拟一天的舵机电流，比较一直输出PWM和空闲断开（sg90_config_t.idle_detach_ms）
+两种情况。投喂动作按执行器的时序展开：每份转到 angle（每度4ms，至少200ms）、保持 hold-ms、
+转回0°，两份之间在0°停留200ms。断开的状态机与驱动一致：静止计时在每个周期的比较事件中进行，
+新的动作先在下一个比较事件恢复输出，动作从恢复后的TEZ开始推进。
+
+电流为模型参数而不是实测值，默认值取SG90空载的典型量级，可按实测的台架数据替换:
+  - 转动中 --moving-ma
+  - 输出PWM静止保持 --hold-ma，另加抖动修正：每 --jitter-interval-s 秒一次、
+    持续 --jitter-ms 毫秒、电流 --jitter-ma
+  - 断开后（无脉冲，只有舵机控制芯片的静态电流）--detached-ma
+"""
+
+import argparse
+import json
+
+PERIOD_MS = 20                  # 与 SG90_PERIOD_MS 一致
+MOVE_MIN_MS = 200               # 与 ACTUATOR_MOVE_MIN_MS 一致
+MOVE_MS_PER_DEG = 4             # 与 ACTUATOR_MOVE_MS_PER_DEG 一致
+REPEAT_GAP_MS = 200             # 与 ACTUATOR_REPEAT_GAP_MS 一致
+DAY_PERIODS = 24 * 3600 * 1000 // PERIOD_MS
+
+
+def move_periods(distance):
+    """单次转动占用的周期数（最后一步写入后再等一个周期生效）"""
+    duration = max(MOVE_MIN_MS, distance * MOVE_MS_PER_DEG)
+    return max(1, duration // PERIOD_MS) + 1
+
+
+def feed_commands(args):
+    """一天内的投喂命令：[(开始周期, 步骤列表)]，步骤为 (转动周期数, 0) 或 (None, 静止周期数)"""
+    commands = []
+    spacing = DAY_PERIODS // max(1, args.feeds_per_day)
+    for feed in range(args.feeds_per_day):
+        steps = []
+        for portion in range(args.portions):
+            if portion > 0:
+                steps.append((None, REPEAT_GAP_MS // PERIOD_MS))
+            steps.append((move_periods(args.angle), 0))
+            steps.append((None, args.hold_ms // PERIOD_MS))
+            steps.append((move_periods(args.angle), 0))
+        commands.append((feed * spacing + spacing // 2, steps))
+    return commands
+
+
+def simulate(args, detach_periods):
+    """逐周期模拟，返回各状态的周期数和平均电流"""
+    jitter_every = max(1, int(args.jitter_interval_s * 1000 // PERIOD_MS))
+    jitter_len = max(1, args.jitter_ms // PERIOD_MS)
+
+    pending = sorted(feed_commands(args))
+
+    counts = {"moving": 0, "holding": 0, "jitter": 0, "detached": 0}
+    detached = False
+    idle = 0
+    quiet = 0                   # 保持期间距离上一次抖动修正的周期数
+    queue = []                  # 当前命令剩余的步骤
+    move_left = 0               # 当前转动剩余周期
+    wait_left = 0               # 当前静止步骤剩余周期
+    next_cmd = 0
+
+    for period in range(DAY_PERIODS):
+        if next_cmd < len(pending) and period == pending[next_cmd][0]:
+            queue.extend(pending[next_cmd][1])
+            next_cmd += 1
+
+        # 取下一步：静止步骤按周期计时，转动需要输出已连接
+        if move_left == 0 and wait_left == 0 and queue:
+            moving, wait = queue[0]
+            if moving is None:
+                queue.pop(0)
+                wait_left = wait
+            elif not detached:
+                queue.pop(0)
+                move_left = moving
+            # 断开时本周期没有脉冲，比较事件中恢复，下一个周期开始转动
+
+        if detached:
+            counts["detached"] += 1
+            if wait_left > 0:
+                wait_left -= 1
+            elif queue and queue[0][0] is not None:
+                detached = False            # 比较事件中撤销强制电平
+                idle = 0
+            continue
+
+        if move_left > 0:
+            counts["moving"] += 1
+            move_left -= 1
+            idle = 0
+            quiet = 0
+            continue
+
+        # 静止且输出PWM：保持电流，周期性的抖动修正
+        quiet += 1
+        if quiet % jitter_every < jitter_len:
+            counts["jitter"] += 1
+        else:
+            counts["holding"] += 1
+        if wait_left > 0:
+            wait_left -= 1
+        idle += 1
+        if detach_periods > 0 and idle >= detach_periods:
+            detached = True
+
+    current = {
+        "moving": args.moving_ma,
+        "holding": args.hold_ma,
+        "jitter": args.jitter_ma,
+        "detached": args.detached_ma,
+    }
+    charge = sum(counts[k] * current[k] for k in counts)
+    return {
+        "periods": counts,
+        "avg_ma": round(charge / DAY_PERIODS, 3),
+        "mah_per_day": round(charge / DAY_PERIODS * 24, 1),
+        "idle_avg_ma": round((charge - counts["moving"] * args.moving_ma) /
+                             max(1, DAY_PERIODS - counts["moving"]), 3),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SmartFishFeeder 舵机空闲断开功耗模型")
+    parser.add_argument("--feeds-per-day", type=int, default=3, help="每天投喂次数（默认3）")
+    parser.add_argument("--portions", type=int, default=2, help="每次投喂份数（默认2）")
+    parser.add_argument("--angle", type=int, default=90, help="投喂转到的角度（默认90）")
+    parser.add_argument("--hold-ms", type=int, default=1000, help="转到投喂角度后的保持时间（默认1000）")
+    parser.add_argument("--detach-ms", type=int, default=2000, help="静止多久后断开（默认2000，与main.c一致）")
+    parser.add_argument("--moving-ma", type=float, default=180.0, help="转动电流，mA（默认180）")
+    parser.add_argument("--hold-ma", type=float, default=9.0, help="输出PWM静止保持电流，mA（默认9）")
+    parser.add_argument("--jitter-ma", type=float, default=150.0, help="抖动修正时的电流，mA（默认150）")
+    parser.add_argument("--jitter-interval-s", type=float, default=2.0, help="抖动修正间隔，秒（默认2）")
+    parser.add_argument("--jitter-ms", type=int, default=40, help="每次抖动修正的时长，毫秒（默认40）")
+    parser.add_argument("--detached-ma", type=float, default=5.0, help="断开后的静态电流，mA（默认5）")
+    parser.add_argument("--supply-v", type=float, default=5.0, help="舵机电源电压（默认5V）")
+    parser.add_argument("--json", action="store_true", help="输出JSON")
+    args = parser.parse_args()
+
+    always_on = simulate(args, 0)
+    detach = simulate(args, (args.detach_ms + PERIOD_MS - 1) // PERIOD_MS)
+    saving = 1.0 - detach["avg_ma"] / always_on["avg_ma"]
+    idle_saving = 1.0 - detach["idle_avg_ma"] / always_on["idle_avg_ma"]
+    result = {
+        "always_on": always_on,
+        "idle_detach": detach,
+        "saving_percent": round(saving * 100, 1),
+        "idle_saving_percent": round(idle_saving * 100, 1),
+        "energy_saved_wh_per_day": round((always_on["mah_per_day"] - detach["mah_per_day"]) *
+                                         args.supply_v / 1000, 2),
+    }
+
+    if args.json:
+        print(json.dumps(result, indent=2, ensure_ascii=False))
+        return
+
+    print(f"{'':12}{'平均电流mA':>12}{'mAh/天':>10}{'空闲平均mA':>12}")
+    for name, label in (("always_on", "一直输出"), ("idle_detach", "空闲断开")):
+        r = result[name]
+        print(f"{label:12}{r['avg_ma']:>12}{r['mah_per_day']:>10}{r['idle_avg_ma']:>12}")
+    print(f"全天节省 {result['saving_percent']}%，空闲电流节省 {result['idle_saving_percent']}%，"
+          f"每天少用 {result['energy_saved_wh_per_day']} Wh")
+    print(f"断开的周期占比 {detach['periods']['detached'] / DAY_PERIODS * 100:.2f}%，"
+          f"转动周期 一直输出 {always_on['periods']['moving']} / 空闲断开 {detach['periods']['moving']}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""
+TLS控制端口握手延迟测试：完整握手 vs 会话票据恢复（主机端，只依赖Python标准库）
+
+用法:
+    # 对真实设备（证书为自签名时用 --cafile 指定同一个证书，不校验主机名）
+    python3 tools/tls_bench.py <设备IP> [--port 8443] [--cafile main/certs/server_cert.pem]
+                               [--count 20] [--commands 20]
+
+    # 没有硬件时，在本进程中启动一个TLS 1.2服务器（同样的标签协议）验证测试本身
+    python3 tools/tls_bench.py --self-test --certfile main/certs/server_cert.pem \\
+                               --keyfile main/certs/server_key.pem
+
+每轮新建TCP连接并完成TLS握手，记录从发起连接到握手完成的时间:
+  - full:    不带会话，完整握手（ECDHE + 证书签名）
+  - resumed: 带上第一次握手得到的会话票据，简化握手
+握手后发送一条 "#tls STATUS" 确认命令协议可用。
+最后在一条长连接上闭环发送 commands 条STATUS，给出握手被多条命令分摊后的平均开销。
+输出JSON: 各自的 p50/p95/max 握手耗时、实际恢复成功的次数
+"""
+
+import argparse
+import json
+import socket
+import ssl
+import threading
+import time
+
+
+def make_client_context(args):
+    ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+    ctx.minimum_version = ssl.TLSVersion.TLSv1_2
+    ctx.maximum_version = ssl.TLSVersion.TLSv1_2    # 设备只支持TLS 1.2的会话票据
+    ctx.check_hostname = False
+    if args.cafile:
+        ctx.load_verify_locations(args.cafile)
+        ctx.verify_mode = ssl.CERT_REQUIRED
+    else:
+        ctx.verify_mode = ssl.CERT_NONE
+    return ctx
+
+
+def read_line(sock, buf):
+    while b"\n" not in buf:
+        chunk = sock.recv(256)
+        if not chunk:
+            raise ConnectionError("连接被关闭")
+        buf += chunk
+    line, _, rest = buf.partition(b"\n")
+    return line, rest
+
+
+def command(sock, buf, tag):
+    sock.sendall(b"#" + tag.encode() + b" STATUS\n")
+    while True:
+        line, buf = read_line(sock, buf)
+        if line.startswith(b"#" + tag.encode() + b" "):
+            return line, buf
+
+
+def handshake(args, ctx, session=None):
+    """建立连接并握手，返回 (socket, 握手耗时秒, 是否恢复)"""
+    start = time.perf_counter()
+    raw = socket.create_connection((args.host, args.port), timeout=10)
+    raw.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    sock = ctx.wrap_socket(raw, session=session)
+    return sock, time.perf_counter() - start, sock.session_reused
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return 0.0
+    k = min(len(sorted_values) - 1, int(round(p / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[k]
+
+
+def summary(values):
+    values = sorted(values)
+    return {
+        "count": len(values),
+        "p50_ms": round(percentile(values, 50) * 1000, 2),
+        "p95_ms": round(percentile(values, 95) * 1000, 2),
+        "max_ms": round(values[-1] * 1000, 2) if values else 0.0,
+    }
+
+
+def run_self_test_server(args, ready):
+    """本地TLS 1.2服务器，按标签协议回复STATUS"""
+    ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    ctx.minimum_version = ssl.TLSVersion.TLSv1_2
+    ctx.maximum_version = ssl.TLSVersion.TLSv1_2
+    ctx.load_cert_chain(args.certfile, args.keyfile)
+
+    listener = socket.create_server(("127.0.0.1", 0))
+    args.host, args.port = "127.0.0.1", listener.getsockname()[1]
+    ready.set()
+
+    def serve(conn):
+        try:
+            with ctx.wrap_socket(conn, server_side=True) as sock:
+                buf = b""
+                while True:
+                    line, buf = read_line(sock, buf)
+                    tag = line[1:].split(b" ", 1)[0] if line.startswith(b"#") else b"?"
+                    sock.sendall(b"#" + tag + b" STATUS pending=0/8 wifi=1\n")
+        except (OSError, ConnectionError, ssl.SSLError):
+            pass
+
+    while True:
+        conn, _ = listener.accept()
+        threading.Thread(target=serve, args=(conn,), daemon=True).start()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SmartFishFeeder TLS握手延迟测试")
+    parser.add_argument("host", nargs="?", help="设备IP地址")
+    parser.add_argument("--port", type=int, default=8443, help="TLS端口（默认8443）")
+    parser.add_argument("--cafile", help="用于校验设备证书的CA或自签名证书，不指定则不校验")
+    parser.add_argument("--count", type=int, default=20, help="每种握手的次数（默认20）")
+    parser.add_argument("--commands", type=int, default=20, help="长连接上发送的命令数（默认20）")
+    parser.add_argument("--self-test", action="store_true", help="对本进程中的TLS服务器测试")
+    parser.add_argument("--certfile", help="--self-test 使用的服务器证书")
+    parser.add_argument("--keyfile", help="--self-test 使用的服务器私钥")
+    args = parser.parse_args()
+
+    if args.self_test:
+        if not args.certfile or not args.keyfile:
+            parser.error("--self-test 需要 --certfile 和 --keyfile")
+        ready = threading.Event()
+        threading.Thread(target=run_self_test_server, args=(args, ready), daemon=True).start()
+        ready.wait()
+    elif not args.host:
+        parser.error("需要设备IP地址")
+
+    ctx = make_client_context(args)
+    full, resumed = [], []
+    reused_count = 0
+    session = None
+
+    for i in range(args.count):
+        sock, elapsed, _ = handshake(args, ctx)
+        command(sock, b"", f"full{i}")
+        session = sock.session
+        sock.close()
+        full.append(elapsed)
+
+    for i in range(args.count):
+        sock, elapsed, reused = handshake(args, ctx, session)
+        command(sock, b"", f"res{i}")
+        if reused:
+            reused_count += 1
+        else:
+            session = sock.session  # 票据失效（例如设备重启），改用新会话
+        sock.close()
+        resumed.append(elapsed)
+
+    # 长连接：一次握手后连续发送命令
+    sock, connect_s, _ = handshake(args, ctx, session)
+    buf = b""
+    started = time.perf_counter()
+    for i in range(args.commands):
+        _, buf = command(sock, buf, f"keep{i}")
+    commands_s = time.perf_counter() - started
+    sock.close()
+
+    print(json.dumps({
+        "target": f"{args.host}:{args.port}",
+        "full_handshake": summary(full),
+        "resumed_handshake": dict(summary(resumed), reused=reused_count),
+        "persistent": {
+            "commands": args.commands,
+            "handshake_ms": round(connect_s * 1000, 2),
+            "avg_command_ms": round(commands_s / max(args.commands, 1) * 1000, 2),
+            "amortized_ms_per_command": round((connect_s + commands_s) / max(args.commands, 1) * 1000, 2),
+        },
+    }, ensure_ascii=False, indent=2))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""
+WebSocket服务器吞吐量测试（主机端，只依赖Python标准库）
+
+用法:
+    python3 tools/ws_bench.py <设备IP> [--port 80] [--clients 1,5,10] [--duration 10]
+
+每个客户端以闭环方式发送 "#<tag> STATUS" 并等待对应回复，统计全部客户端的
+请求/回复速率（messages/s）和回复延迟；同时统计收到的推送事件数，
+用于确认广播在多连接下仍然正常。STATUS不会驱动舵机，可以在设备上长时间运行。
+"""
+
+import argparse
+import base64
+import json
+import os
+import socket
+import struct
+import threading
+import time
+
+
+def ws_connect(host, port, path="/ws", timeout=5.0):
+    """建立WebSocket连接，返回socket"""
+    sock = socket.create_connection((host, port), timeout=timeout)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    key = base64.b64encode(os.urandom(16)).decode()
+    request = (
+        f"GET {path} HTTP/1.1\r\n"
+        f"Host: {host}:{port}\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        f"Sec-WebSocket-Key: {key}\r\n"
+        "Sec-WebSocket-Version: 13\r\n\r\n"
+    )
+    sock.sendall(request.encode())
+
+    response = b""
+    while b"\r\n\r\n" not in response:
+        chunk = sock.recv(1024)
+        if not chunk:
+            raise ConnectionError("握手时连接被关闭")
+        response += chunk
+    if b" 101 " not in response.split(b"\r\n", 1)[0]:
+        raise ConnectionError("握手失败: " + response.split(b"\r\n", 1)[0].decode(errors="replace"))
+    return sock
+
+
+def ws_send_text(sock, text):
+    """发送一个带掩码的文本帧"""
+    payload = text.encode()
+    mask = os.urandom(4)
+    header = bytes([0x81])
+    if len(payload) < 126:
+        header += bytes([0x80 | len(payload)])
+    else:
+        header += bytes([0x80 | 126]) + struct.pack("!H", len(payload))
+    masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+    sock.sendall(header + mask + masked)
+
+
+class FrameReader:
+    """从socket中读取服务器发来的WebSocket帧（服务器帧不带掩码）"""
+
+    def __init__(self, sock):
+        self.sock = sock
+        self.buf = b""
+
+    def _read(self, n):
+        while len(self.buf) < n:
+            chunk = self.sock.recv(4096)
+            if not chunk:
+                raise ConnectionError("连接被关闭")
+            self.buf += chunk
+        data, self.buf = self.buf[:n], self.buf[n:]
+        return data
+
+    def read_frame(self):
+        b0, b1 = self._read(2)
+        length = b1 & 0x7F
+        if length == 126:
+            length = struct.unpack("!H", self._read(2))[0]
+        elif length == 127:
+            length = struct.unpack("!Q", self._read(8))[0]
+        return b0 & 0x0F, self._read(length)
+
+
+def run_client(args, index, stop_at, results):
+    """单个客户端：闭环发送STATUS直到测试结束"""
+    stats = {"replies": 0, "events": 0, "latencies": [], "error": None}
+    results[index] = stats
+    try:
+        sock = ws_connect(args.host, args.port)
+        reader = FrameReader(sock)
+        seq = 0
+        while time.monotonic() < stop_at:
+            tag = f"b{index}-{seq}"
+            start = time.perf_counter()
+            ws_send_text(sock, f"#{tag} STATUS")
+            # 一个回复帧中可能夹带推送事件，直到收到本请求的回复
+            replied = False
+            while not replied:
+                opcode, payload = reader.read_frame()
+                if opcode != 0x1:
+                    continue
+                for line in payload.decode(errors="replace").splitlines():
+                    if line.startswith("!"):
+                        stats["events"] += 1
+                    elif line.startswith(f"#{tag} "):
+                        replied = True
+            stats["latencies"].append(time.perf_counter() - start)
+            stats["replies"] += 1
+            seq += 1
+        sock.close()
+    except (OSError, ConnectionError) as exc:
+        stats["error"] = str(exc)
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return 0.0
+    k = min(len(sorted_values) - 1, int(round(p / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[k]
+
+
+def run_round(args, clients):
+    results = [None] * clients
+    stop_at = time.monotonic() + args.duration
+    threads = [threading.Thread(target=run_client, args=(args, i, stop_at, results))
+               for i in range(clients)]
+    started = time.monotonic()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.monotonic() - started
+
+    replies = sum(r["replies"] for r in results)
+    latencies = sorted(l for r in results for l in r["latencies"])
+    return {
+        "clients": clients,
+        "duration_s": round(elapsed, 2),
+        "replies": replies,
+        "messages_per_s": round(replies / elapsed, 1) if elapsed > 0 else 0.0,
+        "events": sum(r["events"] for r in results),
+        "latency_ms": {
+            "p50": round(percentile(latencies, 50) * 1000, 2),
+            "p99": round(percentile(latencies, 99) * 1000, 2),
+        },
+        "errors": [r["error"] for r in results if r["error"]],
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SmartFishFeeder WebSocket吞吐量测试")
+    parser.add_argument("host", help="设备IP地址")
+    parser.add_argument("--port", type=int, default=80, help="WebSocket端口（默认80）")
+    parser.add_argument("--clients", default="1,5,10", help="并发连接数列表（默认1,5,10）")
+    parser.add_argument("--duration", type=float, default=10.0, help="每轮测试时长，秒（默认10）")
+    args = parser.parse_args()
+
+    report = [run_round(args, int(n)) for n in args.clients.split(",")]
+    print(json.dumps(report, ensure_ascii=False, indent=2))
+
+
+if __name__ == "__main__":
+    main()